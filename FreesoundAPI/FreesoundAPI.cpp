@@ -1,7 +1,7 @@
 #include "FreesoundAPI.h"
 
 String URIS::HOST = String("freesound.org");
-String URIS::BASE = String("https://" + HOST + "/apiv2");
+String URIS::BASE = SystemStats::getEnvironmentVariable("FREESOUND_API_BASE_URL", URIS::getDefaultBaseURL()).trimCharactersAtEnd("/");
 String URIS::TEXT_SEARCH = String("/search/text/");
 String URIS::CONTENT_SEARCH = String("/search/content/");
 String URIS::COMBINED_SEARCH = String("/search/combined/");
@@ -41,7 +41,32 @@ URL URIS::uri(String uri, StringArray replacements)
 			uri = uri.replaceSection(start, 1 + end - start, replacements[i]);
 		}
 	}
-	return BASE + uri;	
+	return getBaseURL() + uri;
+}
+
+static CriticalSection& getBaseURLLock()
+{
+	static CriticalSection lock;
+	return lock;
+}
+
+void URIS::setBaseURL(const String& newBase)
+{
+	const String base = newBase.trim().trimCharactersAtEnd("/");
+
+	const ScopedLock sl(getBaseURLLock());
+	BASE = base.isNotEmpty() ? base : getDefaultBaseURL();
+}
+
+String URIS::getBaseURL()
+{
+	const ScopedLock sl(getBaseURLLock());
+	return BASE;
+}
+
+String URIS::getDefaultBaseURL()
+{
+	return "https://" + HOST + "/apiv2";
 }
 
 FreesoundClient::FreesoundClient()
@@ -155,15 +180,7 @@ SoundList FreesoundClient::textSearch(String query, String filter, String sort,
 	}
 
 	URL url = URIS::uri(URIS::TEXT_SEARCH, StringArray());
-	FSRequest request(url, *this);
-	Response resp = request.request(params,String(),false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(url, params);
 }
 
 SoundList FreesoundClient::contentSearch(String target, String descriptorsFilter, int page, int pageSize, String fields, String descriptors, int normalized)
@@ -197,15 +214,7 @@ SoundList FreesoundClient::contentSearch(String target, String descriptorsFilter
 	}
 
 	URL url = URIS::uri(URIS::CONTENT_SEARCH, StringArray());
-	FSRequest request(url, *this);
-	Response resp = request.request(params, String(), false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(url, params);
 }
 
 FSList FreesoundClient::fetchNextPage(FSList soundList)
@@ -236,28 +245,41 @@ FSList FreesoundClient::fetchPreviousPage(FSList soundList)
 
 SoundList FreesoundClient::fetchNextPage(SoundList soundList)
 {
-	FSRequest request(soundList.getNextPage(), *this);
-	Response resp = request.request(StringPairArray(), String(), false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(soundList.getNextPage());
 }
 
 SoundList FreesoundClient::fetchPreviousPage(SoundList soundList)
 {
-	FSRequest request(soundList.getPreviousPage(), *this);
+	return requestSoundList(soundList.getPreviousPage());
+}
+
+FSList FreesoundClient::fetchPage(FSList fslist, int page)
+{
+	if (page == fslist.getPageNumber())
+		return fslist;
+	String pageURL = fslist.getPageURL(page);
+	if (pageURL.isEmpty())
+		return FSList();
+
+	FSRequest request(pageURL, *this);
 	Response resp = request.request(StringPairArray(), String(), false);
 	int resultCode = resp.first;
 	if (resultCode == 200) {
 		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
+		FSList returnedList(response);
+		return returnedList;
 	}
-	return SoundList();
+	return FSList();
+}
+
+SoundList FreesoundClient::fetchPage(SoundList fslist, int page)
+{
+	if (page == fslist.getPageNumber())
+		return fslist;
+	String pageURL = fslist.getPageURL(page);
+	if (pageURL.isEmpty())
+		return SoundList();
+	return requestSoundList(pageURL);
 }
 
 FSSound FreesoundClient::getSound(String id, String fields)
@@ -280,6 +302,70 @@ FSSound FreesoundClient::getSound(String id, String fields)
 	return FSSound();
 }
 
+//Every property of a sound, requested by getSounds() when no fields are given
+static const String allSoundFields = "id,url,name,tags,description,geotag,created,license,type,channels,filesize,bitrate,bitdepth,"
+	"duration,samplerate,username,pack,download,bookmark,previews,images,num_downloads,avg_rating,num_ratings,rate,comments,"
+	"num_comments,comment,similar_sounds,analysis,analysis_stats,analysis_frames,ac_analysis";
+
+Array<FSSound> FreesoundClient::getSounds(StringArray ids, String fields, int maxIdsPerRequest, int maxParallelRequests)
+{
+	StringArray uniqueIds;
+	for (const auto& id : ids) {
+		if (id.trim().isNotEmpty()) {
+			uniqueIds.addIfNotAlreadyThere(id.trim());
+		}
+	}
+
+	//Split the ids in chunks which fit in a single page of search results
+	const int chunkSize = jlimit(1, 150, maxIdsPerRequest);
+	Array<StringArray> chunks;
+	for (int i = 0; i < uniqueIds.size(); i += chunkSize) {
+		chunks.add(StringArray(uniqueIds.strings.begin() + i, jmin(chunkSize, uniqueIds.size() - i)));
+	}
+
+	std::vector<SoundList> chunkResults((size_t) chunks.size());
+	auto resolveChunk = [this, &chunks, &chunkResults, &fields](int chunkIndex) {
+		const StringArray& chunk = chunks.getReference(chunkIndex);
+		StringPairArray params;
+		params.set("filter", "id:(" + chunk.joinIntoString(" OR ") + ")");
+		params.set("page_size", String(chunk.size()));
+		params.set("fields", fields.isNotEmpty() ? fields : allSoundFields);
+		chunkResults[(size_t) chunkIndex] = requestSoundList(URIS::uri(URIS::TEXT_SEARCH, StringArray()), params);
+	};
+
+	if (chunks.size() == 1) {
+		resolveChunk(0);
+	}
+	else if (chunks.size() > 1) {
+		//A pool of its own, so that this can be called from the client's worker pool without starving it
+		WaitableEvent allChunksDone;
+		std::atomic<int> chunksLeft(chunks.size());
+		ThreadPool chunkPool(jlimit(1, chunks.size(), maxParallelRequests));
+
+		for (int i = 0; i < chunks.size(); i++) {
+			chunkPool.addJob([&resolveChunk, &allChunksDone, &chunksLeft, i]() {
+				resolveChunk(i);
+				if (--chunksLeft == 0)
+					allChunksDone.signal();
+			});
+		}
+		allChunksDone.wait();
+	}
+
+	HashMap<String, FSSound> soundsById;
+	for (auto& chunkResult : chunkResults) {
+		for (const auto& sound : chunkResult.toArrayOfCompactSounds()) {
+			soundsById.set(sound.getIDString(), sound.toFSSound());
+		}
+	}
+
+	Array<FSSound> returnedSounds;
+	for (const auto& id : ids) {
+		returnedSounds.add(soundsById.contains(id.trim()) ? soundsById[id.trim()] : FSSound());
+	}
+	return returnedSounds;
+}
+
 var FreesoundClient::getSoundAnalysis(String id, String descriptors, int normalized)
 {
 	StringPairArray params;
@@ -332,26 +418,20 @@ SoundList FreesoundClient::getSimilarSounds(String id, String descriptorsFilter,
 	}
 
 	URL url = URIS::uri(URIS::SIMILAR_SOUNDS, id);
-	FSRequest request(url, *this);
-	Response resp = request.request(params, String(), false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(url, params);
 }
 
 URL::DownloadTask* FreesoundClient::downloadSound(FSSound sound, const File & location, URL::DownloadTask::Listener * listener)
 {
 	URL address = sound.getDownload();
+	FSHostLimiter::getShared().recordDetachedRequest(address);
 	return address.downloadToFile(location, "Authorization: " + header, listener).get();
 }
 
 URL::DownloadTask* FreesoundClient::downloadOGGSoundPreview(FSSound sound, const File & location, URL::DownloadTask::Listener * listener)
 {
     URL address = sound.getOGGPreviewURL();
+    FSHostLimiter::getShared().recordDetachedRequest(address);
     return address.downloadToFile(location, "", listener).get();
 }
 
@@ -570,15 +650,7 @@ SoundList FreesoundClient::getUserSounds(String username, String descriptorsFilt
 	}
 
 	URL url = URIS::uri(URIS::USER_SOUNDS, username);
-	FSRequest request(url, *this);
-	Response resp = request.request(params, String(), false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(url, params);
 }
 
 FSList FreesoundClient::getUserBookmarkCategories(String username)
@@ -670,15 +742,7 @@ SoundList FreesoundClient::getPackSounds(String id, String descriptorsFilter, in
 	}
 
 	URL url = URIS::uri(URIS::PACK_SOUNDS, StringArray(id));
-	FSRequest request(url, *this);
-	Response resp = request.request(params, String(), false);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		SoundList returnedSounds(response);
-		return returnedSounds;
-	}
-	return SoundList();
+	return requestSoundList(url, params);
 }
 
 URL::DownloadTask* FreesoundClient::downloadPack(FSPack pack, const File & location, URL::DownloadTask::Listener * listener)
@@ -726,234 +790,1894 @@ String FreesoundClient::getClientID()
 	return clientID;
 }
 
-
-
-
-void FreesoundClientComponent::startAuthentication(int mode)
+void FreesoundClient::setWorkerPool(std::shared_ptr<FSWorkerPool> pool)
 {
-	URL url;
-	if (mode == 0) { url = URIS::uri(URIS::LOGOUT_AUTHORIZE, StringArray()); }
-	else { url = URIS::uri(URIS::AUTHORIZE, StringArray()); }
-	url = url.withParameter("client_id", getClientID());
-	url = url.withParameter("response_type", "code");
-	goToURL(url.toString(true));
+	workerPool = pool;
 }
 
-
-
-void FreesoundClientComponent::pageFinishedLoading(const String &url) {
-	if (url.startsWith("https://freesound.org/home/app_permissions/permission_granted/")) {
-		URL recUrl(url);
-		StringArray paramNames = recUrl.getParameterNames();
-		StringArray paramVals = recUrl.getParameterValues();
-
-		int codeInd = paramNames.indexOf("code", true, 0);
-		authCode = paramVals[codeInd];
-		if (finishedLoadingCallback != nullptr) {
-			finishedLoadingCallback();
-		}
-
-	}
-
+std::shared_ptr<FSWorkerPool> FreesoundClient::getWorkerPool()
+{
+	if (workerPool == nullptr)
+		return FSWorkerPool::getDefault();
+	return workerPool;
 }
 
-void FreesoundClientComponent::exchangeToken(Callback cb)
+SoundList FreesoundClient::requestSoundList(URL url, StringPairArray params)
 {
-	StringPairArray params;
-	params.set("client_id", clientID);
-	params.set("client_secret", clientSecret);
-	params.set("grant_type", "authorization_code");
-	params.set("code", authCode);
-
-	URL url = URIS::uri(URIS::ACCESS_TOKEN, StringArray());
+	SoundList returnedSounds;
 	FSRequest request(url, *this);
-	Response resp = request.request(params);
-	int resultCode = resp.first;
-	if (resultCode == 200) {
-		var response = resp.second;
-		accessToken = response["access_token"];
-		refreshToken = response["refresh_token"];
-		header = "Bearer " + accessToken;
-	}
-	cb();
+	int resultCode = request.requestStream([&returnedSounds](InputStream& stream, int statusCode) {
+		if (statusCode != 200)
+			return false;
+		bool parsedOk = false;
+		returnedSounds = SoundList::fromStream(stream, &parsedOk);
+		return parsedOk;
+	}, params, String(), false);
+
+	if (resultCode == 200)
+		return returnedSounds;
+	return SoundList();
 }
 
+void FreesoundClient::setResponseCache(std::shared_ptr<FSResponseCache> cache)
+{
+	responseCache = cache;
+}
 
-void FreesoundClientComponent::pageLoadHadNetworkError() {
-	startAuthentication();
+std::shared_ptr<FSResponseCache> FreesoundClient::getResponseCache()
+{
+	if (responseCache == nullptr)
+		return FSResponseCache::getDefault();
+	return responseCache;
 }
 
-void FreesoundClientComponent::setCallback(Callback cb)
+FSAsyncHandle<SoundList> FreesoundClient::textSearchAsync(String query, String filter, String sort, int groupByPack, int page, int pageSize, String fields, String descriptors, int normalized)
 {
-	finishedLoadingCallback = cb;
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.textSearch(query, filter, sort, groupByPack, page, pageSize, fields, descriptors, normalized); });
 }
 
+FSAsyncHandle<SoundList> FreesoundClient::contentSearchAsync(String target, String descriptorsFilter, int page, int pageSize, String fields, String descriptors, int normalized)
+{
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.contentSearch(target, descriptorsFilter, page, pageSize, fields, descriptors, normalized); });
+}
 
+FSAsyncHandle<FSList> FreesoundClient::fetchNextPageAsync(FSList fslist)
+{
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.fetchNextPage(fslist); });
+}
 
-Response FSRequest::request(StringPairArray params, String data, bool postLikeRequest)
+FSAsyncHandle<FSList> FreesoundClient::fetchPreviousPageAsync(FSList fslist)
 {
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.fetchPreviousPage(fslist); });
+}
 
-	URL url = uri;
-	String header;
-	int statusCode = -1;
-	StringPairArray responseHeaders;
-	if (data.isNotEmpty()) { url = url.withPOSTData(data); }
-	if (params.size() != 0) { url = url.withParameters(params); }
-	if (client.isTokenNotEmpty()) { header = "Authorization: " + client.getHeader(); }
+FSAsyncHandle<SoundList> FreesoundClient::fetchNextPageAsync(SoundList fslist)
+{
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.fetchNextPage(fslist); });
+}
 
+FSAsyncHandle<SoundList> FreesoundClient::fetchPreviousPageAsync(SoundList fslist)
+{
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.fetchPreviousPage(fslist); });
+}
 
-	//Try to open a stream with this information.
-	if (auto stream = std::unique_ptr<InputStream>(url.createInputStream(postLikeRequest, nullptr, nullptr, header,
-		10000, // timeout in millisecs
-		&responseHeaders, &statusCode)))
-	{
-		//Stream created successfully, store the response, log it and return the response in a pair containing (statusCode, response)
-		String resp = stream->readEntireStreamAsString();
-		var response = JSON::parse(resp);
-		return Response(statusCode, response);
-	}
-	//Couldnt create stream, return (-1, emptyVar)
-	return Response(statusCode, var());
+FSAsyncHandle<FSList> FreesoundClient::fetchPageAsync(FSList fslist, int page)
+{
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.fetchPage(fslist, page); });
 }
 
-FSList::FSList()
+FSAsyncHandle<SoundList> FreesoundClient::fetchPageAsync(SoundList fslist, int page)
 {
-	count = 0;
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.fetchPage(fslist, page); });
 }
 
-FSList::FSList(var response)
+FSAsyncHandle<FSSound> FreesoundClient::getSoundAsync(String id, String fields)
 {
-	count = response["count"]; //getIntValue
-	nextPage = response["next"];
-	previousPage = response["previous"];
-	results = response["results"];
+	return runAsync<FSSound>([=](FreesoundClient& c) { return c.getSound(id, fields); });
 }
 
-String FSList::getNextPage()
+FSAsyncHandle<Array<FSSound>> FreesoundClient::getSoundsAsync(StringArray ids, String fields, int maxIdsPerRequest, int maxParallelRequests)
 {
-	return nextPage;
+	return runAsync<Array<FSSound>>([=](FreesoundClient& c) { return c.getSounds(ids, fields, maxIdsPerRequest, maxParallelRequests); });
 }
 
-String FSList::getPreviousPage()
+FSAsyncHandle<var> FreesoundClient::getSoundAnalysisAsync(String id, String descriptors, int normalized)
 {
-	return previousPage;
+	return runAsync<var>([=](FreesoundClient& c) { return c.getSoundAnalysis(id, descriptors, normalized); });
 }
 
-var FSList::getResults()
+FSAsyncHandle<SoundList> FreesoundClient::getSimilarSoundsAsync(String id, String descriptorsFilter, int page, int pageSize, String fields, String descriptors, int normalized)
 {
-	return results;
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.getSimilarSounds(id, descriptorsFilter, page, pageSize, fields, descriptors, normalized); });
 }
 
-int FSList::getCount()
+FSAsyncHandle<int> FreesoundClient::uploadSoundAsync(const File& fileToUpload, String tags, String description, String name, String license, String pack, String geotag)
 {
-	return count;
+	File file(fileToUpload);
+	return runAsync<int>([=](FreesoundClient& c) { return c.uploadSound(file, tags, description, name, license, pack, geotag); });
 }
 
-FSSound::FSSound()
+FSAsyncHandle<int> FreesoundClient::describeSoundAsync(String uploadFilename, String description, String license, String name, String tags, String pack, String geotag)
 {
+	return runAsync<int>([=](FreesoundClient& c) { return c.describeSound(uploadFilename, description, license, name, tags, pack, geotag); });
 }
 
-FSSound::FSSound(var sound)
+FSAsyncHandle<var> FreesoundClient::pendingUploadsAsync()
 {
-	id = sound["id"];
-	url = URL(sound["url"]);
-	name = sound["name"];
-	tags = StringArray();
-	for (int i = 0; i < sound["tags"].size(); i++) {
-		tags.add(sound["tags"][i]);
-	}
-	description = sound["description"];
-	geotag = sound["geotag"];
-	created = sound["created"];
-	license = sound["license"];
-	format = sound["type"];
-	channels = sound["channels"];
-	filesize = sound["filesize"];
-	bitrate = sound["bitrate"];
-	bitdepth = sound["bitdepth"];
-	duration = sound["duration"];
-	samplerate = sound["samplerate"];
-	user = sound["username"];
-	pack = URL(sound["pack"]);
-	download = URL(sound["download"]);
-	bookmark = URL(sound["bookmark"]);
-	previews = sound["previews"];
-    images = sound["images"];
-	numDownloads = sound["images"];
-	avgRating = sound["num_downloads"];
-	numRatings = sound["avg_rating"];
-	rate = URL(sound["rate"]);
-	comments = URL(sound["comments"]);
-	numComments = sound["num_comments"];
-	comment = URL(sound["comment"]);
-	similarSounds = URL(sound["similar_sounds"]);
-	analysis = sound["analysis"];
-	analysisStats = URL(sound["analysis_stats"]);
-	analysisFrames = URL(sound["analysis_frames"]);
-	acAnalysis = sound["ac_analysis"];
+	return runAsync<var>([](FreesoundClient& c) { return c.pendingUploads(); });
+}
 
-	std::cout << "FSSound created with id: " << id << std::endl;
+FSAsyncHandle<bool> FreesoundClient::editSoundDescriptionAsync(String id, String name, String tags, String description, String license, String pack, String geotag)
+{
+	return runAsync<bool>([=](FreesoundClient& c) { c.editSoundDescription(id, name, tags, description, license, pack, geotag); return true; });
+}
 
+FSAsyncHandle<bool> FreesoundClient::bookmarkSoundAsync(String id, String name, String category)
+{
+	return runAsync<bool>([=](FreesoundClient& c) { c.bookmarkSound(id, name, category); return true; });
 }
 
-URL FSSound::getDownload()
+FSAsyncHandle<bool> FreesoundClient::rateSoundAsync(String id, int rating)
 {
-	return download;
+	return runAsync<bool>([=](FreesoundClient& c) { c.rateSound(id, rating); return true; });
 }
 
-URL FSSound::getOGGPreviewURL()
+FSAsyncHandle<bool> FreesoundClient::commentSoundAsync(String id, String comment)
 {
-    if (!previews.hasProperty("preview-hq-ogg")){
-        /*
-         If you reached this bit of code is because you're trying to download the preview of a sound
-         but the freesound-juce client does not know the URL where to find that preview.
-         
-         It can happen that the FSSound object does not have "previews" property if the object was
-         constructed from the results of a SoundList (e.g. using SoundList::toSoundArray method) and
-         the "previews" field was not initially requested in the query that created the SoundList
-         object. If you just reached this bit of code, make sure that you include the "previews" field
-         in the "fields" parameter of the function that generated the SoundList.
-         */
-        throw;
-    }
-    return URL(previews["preview-hq-ogg"]);
+	return runAsync<bool>([=](FreesoundClient& c) { c.commentSound(id, comment); return true; });
 }
 
+FSAsyncHandle<FSUser> FreesoundClient::getUserAsync(String user)
+{
+	return runAsync<FSUser>([=](FreesoundClient& c) { return c.getUser(user); });
+}
 
+FSAsyncHandle<SoundList> FreesoundClient::getUserSoundsAsync(String username, String descriptorsFilter, int page, int pageSize, String fields, String descriptors, int normalized)
+{
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.getUserSounds(username, descriptorsFilter, page, pageSize, fields, descriptors, normalized); });
+}
 
-FSUser::FSUser()
+FSAsyncHandle<FSList> FreesoundClient::getUserBookmarkCategoriesAsync(String username)
 {
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.getUserBookmarkCategories(username); });
 }
 
-FSUser::FSUser(var user)
+FSAsyncHandle<FSList> FreesoundClient::getUserBookmarkCategoriesSoundsAsync(String username, String bookmarkCategory)
 {
-	profile = URL(user["url"]);
-	about = user["about"];
-	username = user["username"];
-	homepage = URL(user["homepage"]);
-	avatar = user["avatar"];
-	dateJoined = user["date_joined"];
-	numSounds = user["num_sounds"];
-	sounds = URL(user["sounds"]);
-	numPacks = user["num_packs"];
-	packs = URL(user["packs"]);
-	numPosts = user["num_posts"];
-	numComments = user["num_comments"];
-	bookmarks = URL(user["bookmarks"]);
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.getUserBookmarkCategoriesSounds(username, bookmarkCategory); });
+}
 
+FSAsyncHandle<FSList> FreesoundClient::getUserPacksAsync(String username)
+{
+	return runAsync<FSList>([=](FreesoundClient& c) { return c.getUserPacks(username); });
 }
 
-FSPack::FSPack()
+FSAsyncHandle<FSPack> FreesoundClient::getPackAsync(String id)
 {
+	return runAsync<FSPack>([=](FreesoundClient& c) { return c.getPack(id); });
 }
 
-FSPack::FSPack(var pack)
+FSAsyncHandle<SoundList> FreesoundClient::getPackSoundsAsync(String id, String descriptorsFilter, int page, int pageSize, String fields, String descriptors, int normalized)
 {
-	id = pack["id"];
-	url = URL(pack["url"]);
-	description = pack["description"];
-	created = pack["created"];
-	name = pack["name"];
+	return runAsync<SoundList>([=](FreesoundClient& c) { return c.getPackSounds(id, descriptorsFilter, page, pageSize, fields, descriptors, normalized); });
+}
+
+FSAsyncHandle<FSUser> FreesoundClient::getMeAsync()
+{
+	return runAsync<FSUser>([](FreesoundClient& c) { return c.getMe(); });
+}
+
+class FSWorkerPool::Job : public ThreadPoolJob {
+public:
+	Job(FSWorkerPool& ownerPool, std::function<void()> jobToRun, std::function<void()> onDroppedToUse)
+		: ThreadPoolJob("FSWorkerPool job"),
+		owner(ownerPool),
+		job(std::move(jobToRun)),
+		onDropped(std::move(onDroppedToUse))
+	{
+	}
+
+	~Job() override
+	{
+		if (!hasRun && onDropped != nullptr)
+			onDropped();
+		owner.jobFinished();
+	}
+
+	JobStatus runJob() override
+	{
+		hasRun = true;
+		job();
+		return jobHasFinished;
+	}
+
+	FSWorkerPool& owner;
+
+private:
+	std::function<void()> job;
+	std::function<void()> onDropped;
+	bool hasRun = false;
+};
+
+FSWorkerPool::FSWorkerPool(int numThreadsToUse)
+	: numThreads(jmax(1, numThreadsToUse))
+{
+	pool = std::make_unique<ThreadPool>(numThreads);
+}
+
+FSWorkerPool::~FSWorkerPool()
+{
+	//Deletes the queued jobs, which resolves their handles as cancelled
+	pool->removeAllJobs(true, 10000);
+}
+
+void FSWorkerPool::submit(std::function<void()> job, std::function<void()> onDropped)
+{
+	{
+		const ScopedLock sl(pendingJobsLock);
+		if (numPendingJobs++ == 0)
+			allJobsFinished.reset();
+	}
+	pool->addJob(new Job(*this, std::move(job), std::move(onDropped)), true);
+}
+
+int FSWorkerPool::getNumThreads() const
+{
+	return numThreads;
+}
+
+int FSWorkerPool::getNumPendingJobs() const
+{
+	return pool->getNumJobs();
+}
+
+void FSWorkerPool::waitForAllJobs()
+{
+	//A job waiting for all the jobs would wait for itself
+	jassert(!isPoolThread());
+	if (isPoolThread())
+		return;
+
+	allJobsFinished.wait(-1);
+}
+
+bool FSWorkerPool::isPoolThread() const
+{
+	auto* job = dynamic_cast<Job*>(ThreadPoolJob::getCurrentThreadPoolJob());
+	return job != nullptr && &job->owner == this;
+}
+
+void FSWorkerPool::jobFinished()
+{
+	const ScopedLock sl(pendingJobsLock);
+	if (--numPendingJobs == 0)
+		allJobsFinished.signal();
+}
+
+static std::shared_ptr<FSWorkerPool>& getDefaultWorkerPoolStorage()
+{
+	static std::shared_ptr<FSWorkerPool> defaultPool;
+	return defaultPool;
+}
+
+static CriticalSection defaultWorkerPoolLock;
+
+std::shared_ptr<FSWorkerPool> FSWorkerPool::getDefault()
+{
+	const ScopedLock sl(defaultWorkerPoolLock);
+	auto& defaultPool = getDefaultWorkerPoolStorage();
+	if (defaultPool == nullptr)
+		defaultPool = std::make_shared<FSWorkerPool>();
+	return defaultPool;
+}
+
+void FSWorkerPool::setDefaultNumThreads(int numThreads)
+{
+	std::shared_ptr<FSWorkerPool> previousPool;
+	{
+		const ScopedLock sl(defaultWorkerPoolLock);
+		previousPool = getDefaultWorkerPoolStorage();
+		getDefaultWorkerPoolStorage() = std::make_shared<FSWorkerPool>(numThreads);
+	}
+
+	if (previousPool == nullptr)
+		return;
+
+	//The destructor would cancel the queued jobs, so let them run first. From one of the
+	//previous pool's own jobs that would wait for itself, so it is left to a thread of its own.
+	if (previousPool->isPoolThread())
+		Thread::launch([previousPool] { previousPool->waitForAllJobs(); });
+	else
+		previousPool->waitForAllJobs();
+}
+
+FSHostLimiter::Lease::Lease(FSHostLimiter& ownerLimiter, const String& hostName)
+	: owner(ownerLimiter),
+	host(hostName)
+{
+}
+
+FSHostLimiter::Lease::~Lease()
+{
+	owner.release(host);
+}
+
+FSHostLimiter::FSHostLimiter(int maxRequestsPerHostToUse)
+	: maxRequestsPerHost(jmax(1, maxRequestsPerHostToUse))
+{
+}
+
+std::unique_ptr<FSHostLimiter::Lease> FSHostLimiter::acquire(const URL& url, int timeoutMs)
+{
+	const String host = getHostFor(url);
+	const uint32 startTime = Time::getMillisecondCounter();
+	bool hadToWait = false;
+
+	for (;;)
+	{
+		{
+			const ScopedLock sl(lock);
+			HostStats& stats = hosts[host];
+
+			if (stats.activeRequests < maxRequestsPerHost.load())
+			{
+				stats.activeRequests++;
+				stats.totalRequests++;
+				return std::unique_ptr<Lease>(new Lease(*this, host));
+			}
+
+			if (!hadToWait)
+			{
+				stats.waitsForSlot++;
+				hadToWait = true;
+			}
+		}
+
+		// Slots of other hosts also signal the event, so wait in short slices and check again
+		int waitTime = 50;
+		if (timeoutMs >= 0)
+		{
+			const int elapsed = (int) (Time::getMillisecondCounter() - startTime);
+			if (elapsed >= timeoutMs)
+				return nullptr;
+			waitTime = jmin(waitTime, timeoutMs - elapsed);
+		}
+		slotReleased.wait(waitTime);
+	}
+}
+
+void FSHostLimiter::recordDetachedRequest(const URL& url)
+{
+	const ScopedLock sl(lock);
+	hosts[getHostFor(url)].totalRequests++;
+}
+
+void FSHostLimiter::setMaxRequestsPerHost(int maxRequests)
+{
+	maxRequestsPerHost = jmax(1, maxRequests);
+	slotReleased.signal();
+}
+
+//Splits a URL path into its segments
+static StringArray getPathSegments(const String& path)
+{
+	StringArray segments = StringArray::fromTokens(path, "/", "");
+	segments.removeEmptyStrings();
+	return segments;
+}
+
+//Matches an endpoint against the start of the API path of a request. Returns how specific the
+//match is (more segments first, then more literal segments), or -1 if it does not match
+static int matchEndpoint(const StringArray& pathSegments, const String& endpoint)
+{
+	const StringArray endpointSegments = getPathSegments(endpoint);
+	if (endpointSegments.isEmpty() || endpointSegments.size() > pathSegments.size())
+		return -1;
+
+	int literalSegments = 0;
+	for (int i = 0; i < endpointSegments.size(); ++i)
+	{
+		const String& segment = endpointSegments[i];
+		if (segment.startsWithChar('<') && segment.endsWithChar('>'))
+			continue;
+		if (segment != pathSegments[i])
+			return -1;
+		literalSegments++;
+	}
+	return endpointSegments.size() * 1000 + literalSegments;
+}
+
+//Splits the path of a request into its segments, relative to the API root: the path of
+//URIS::getBaseURL() (e.g. /apiv2) is dropped, as endpoints are given without it
+static StringArray getApiPathSegments(const URL& url)
+{
+	StringArray pathSegments = getPathSegments(url.getSubPath());
+	const StringArray baseSegments = getPathSegments(URL(URIS::getBaseURL()).getSubPath());
+	int numBaseSegments = 0;
+	while (numBaseSegments < baseSegments.size() && numBaseSegments < pathSegments.size()
+		&& baseSegments[numBaseSegments] == pathSegments[numBaseSegments])
+		numBaseSegments++;
+	if (numBaseSegments == baseSegments.size())
+		pathSegments.removeRange(0, numBaseSegments);
+	return pathSegments;
+}
+
+FSRateLimiter::FSRateLimiter()
+{
+	// The standard API quota is 60 requests per minute
+	setBudget(String(), 60.0, 20);
+}
+
+void FSRateLimiter::setBudget(const String& endpoint, double requestsPerMinute, int burst)
+{
+	const ScopedLock sl(lock);
+	Bucket& bucket = buckets[endpoint];
+	bucket.capacity = jmax(1.0, (double) burst);
+	bucket.tokens = bucket.capacity;
+	bucket.tokensPerMs = jmax(0.000001, requestsPerMinute / 60000.0);
+	bucket.lastRefill = Time::currentTimeMillis();
+}
+
+int64 FSRateLimiter::acquire(const URL& url)
+{
+	int64 waited = 0;
+
+	for (;;)
+	{
+		int64 waitTime = 0;
+		{
+			const ScopedLock sl(lock);
+			Bucket& bucket = getBucketFor(url);
+			const int64 now = Time::currentTimeMillis();
+			refill(bucket, now);
+
+			//Waiting out a pause this long would hang the caller, e.g. for hours after the
+			//daily quota ran out, so the request fails instead
+			if (bucket.pausedUntil - now > maxRetryAfterMs)
+			{
+				stats.refusedRequests++;
+				return -1;
+			}
+
+			if (now < bucket.pausedUntil)
+			{
+				waitTime = bucket.pausedUntil - now;
+			}
+			else if (bucket.tokens >= 1.0)
+			{
+				bucket.tokens -= 1.0;
+				stats.requests++;
+				if (waited > 0)
+				{
+					stats.throttledRequests++;
+					stats.throttledMilliseconds += waited;
+				}
+				return waited;
+			}
+			else
+			{
+				waitTime = (int64) std::ceil((1.0 - bucket.tokens) / bucket.tokensPerMs);
+			}
+		}
+
+		// Synchronous calls on the message thread block the UI while they wait here
+		if (waited == 0 && MessageManager::existsAndIsCurrentThread())
+			DBG("FSRateLimiter: throttling a request made on the message thread");
+
+		// Wake up at least once a second, so budget changes are picked up
+		const int sleepTime = (int) jlimit((int64) 1, (int64) 1000, waitTime);
+		Thread::sleep(sleepTime);
+		waited += sleepTime;
+	}
+}
+
+bool FSRateLimiter::shouldRetry(const URL& url, int statusCode, int attempt, const String& retryAfter, int& delayMs)
+{
+	const bool rateLimited = statusCode == 429;
+	const bool serverError = statusCode >= 500 && statusCode < 600;
+
+	const ScopedLock sl(lock);
+	if (rateLimited)
+		stats.rateLimitedResponses++;
+	if (serverError)
+		stats.serverErrorResponses++;
+	if (!rateLimited && !serverError)
+		return false;
+
+	// Exponential backoff with equal jitter, so that concurrent retries spread out
+	const int backoff = (int) jmin((int64) maxBackoffMs, (int64) baseBackoffMs << jmin(attempt, 20));
+	delayMs = backoff / 2 + random.nextInt(backoff / 2 + 1);
+
+	// The server's Retry-After is honoured as given: retrying any earlier only earns another
+	// 429. When it is longer than we are willing to wait, the request fails instead.
+	const int serverDelay = parseRetryAfter(retryAfter);
+	if (serverDelay >= 0)
+		delayMs = jmax(delayMs, serverDelay);
+
+	if (rateLimited)
+	{
+		Bucket& bucket = getBucketFor(url);
+		bucket.pausedUntil = jmax(bucket.pausedUntil, Time::currentTimeMillis() + delayMs);
+		bucket.tokens = 0.0;
+	}
+
+	if (attempt >= maxRetries || serverDelay > maxRetryAfterMs)
+	{
+		stats.failedAfterRetries++;
+		return false;
+	}
+
+	stats.retries++;
+	return true;
+}
+
+void FSRateLimiter::recordBackoff(int delayMs)
+{
+	const ScopedLock sl(lock);
+	stats.backoffMilliseconds += delayMs;
+}
+
+void FSRateLimiter::setRetryPolicy(int maxRetriesToUse, int baseBackoffMsToUse, int maxBackoffMsToUse, int maxRetryAfterMsToUse)
+{
+	const ScopedLock sl(lock);
+	maxRetries = jmax(0, maxRetriesToUse);
+	baseBackoffMs = jmax(1, baseBackoffMsToUse);
+	maxBackoffMs = jmax(baseBackoffMs, maxBackoffMsToUse);
+	maxRetryAfterMs = jmax(0, maxRetryAfterMsToUse);
+}
+
+int FSRateLimiter::getMaxRetries() const
+{
+	const ScopedLock sl(lock);
+	return maxRetries;
+}
+
+FSRateLimiter::Stats FSRateLimiter::getStats() const
+{
+	const ScopedLock sl(lock);
+	return stats;
+}
+
+void FSRateLimiter::resetStats()
+{
+	const ScopedLock sl(lock);
+	stats = Stats();
+}
+
+int FSRateLimiter::parseRetryAfter(const String& retryAfter)
+{
+	const String value = retryAfter.trim();
+	if (value.isEmpty())
+		return -1;
+
+	if (value.containsOnly("0123456789"))
+		return (int) jmin((int64) std::numeric_limits<int>::max(), value.getLargeIntValue() * 1000);
+
+	// HTTP date, e.g. "Wed, 21 Oct 2015 07:28:00 GMT"
+	StringArray tokens;
+	tokens.addTokens(value.fromFirstOccurrenceOf(",", false, false), " :", "");
+	tokens.removeEmptyStrings();
+	if (tokens.size() < 6)
+		return -1;
+
+	const int month = StringArray({ "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" }).indexOf(tokens[1], true);
+	if (month < 0)
+		return -1;
+
+	Time date(tokens[2].getIntValue(), month, tokens[0].getIntValue(),
+		tokens[3].getIntValue(), tokens[4].getIntValue(), tokens[5].getIntValue(), 0, false);
+	return (int) jlimit((int64) 0, (int64) std::numeric_limits<int>::max(), date.toMilliseconds() - Time::currentTimeMillis());
+}
+
+FSRateLimiter& FSRateLimiter::getShared()
+{
+	static FSRateLimiter sharedLimiter;
+	return sharedLimiter;
+}
+
+FSRateLimiter::Bucket& FSRateLimiter::getBucketFor(const URL& url)
+{
+	//Endpoints match like the time to live rules of FSResponseCache, so that /users/x/sounds/
+	//is not taken for /sounds/ and templates such as URIS::SOUND work
+	const StringArray pathSegments = getApiPathSegments(url);
+	auto match = buckets.find(String());
+	int bestMatch = -1;
+
+	for (auto it = buckets.begin(); it != buckets.end(); ++it)
+	{
+		const int score = matchEndpoint(pathSegments, it->first);
+		if (score > bestMatch)
+		{
+			bestMatch = score;
+			match = it;
+		}
+	}
+
+	return match->second;
+}
+
+void FSRateLimiter::refill(Bucket& bucket, int64 now)
+{
+	if (now > bucket.lastRefill)
+	{
+		bucket.tokens = jmin(bucket.capacity, bucket.tokens + (double) (now - bucket.lastRefill) * bucket.tokensPerMs);
+		bucket.lastRefill = now;
+	}
+}
+
+std::shared_ptr<FSInFlightRequests::Flight> FSInFlightRequests::join(const String& key, bool& isLeader)
+{
+	const ScopedLock sl(lock);
+	auto it = flights.find(key);
+	if (it != flights.end())
+	{
+		isLeader = false;
+		numCoalesced++;
+		it->second->numFollowers++;
+		return it->second;
+	}
+
+	isLeader = true;
+	auto flight = std::make_shared<Flight>();
+	flight->key = key;
+	flights[key] = flight;
+	return flight;
+}
+
+bool FSInFlightRequests::close(Flight& flight)
+{
+	const ScopedLock sl(lock);
+	auto it = flights.find(flight.key);
+	if (it != flights.end() && it->second.get() == &flight)
+		flights.erase(it);
+	return flight.numFollowers > 0;
+}
+
+void FSInFlightRequests::finish(const String& key, const std::shared_ptr<Flight>& flight)
+{
+	{
+		const ScopedLock sl(lock);
+		auto it = flights.find(key);
+		if (it != flights.end() && it->second == flight)
+			flights.erase(it);
+	}
+	flight->finished.signal();
+}
+
+void FSInFlightRequests::setEnabled(bool shouldBeEnabled)
+{
+	enabled = shouldBeEnabled;
+}
+
+bool FSInFlightRequests::isEnabled() const
+{
+	return enabled.load();
+}
+
+int64 FSInFlightRequests::getNumCoalesced() const
+{
+	const ScopedLock sl(lock);
+	return numCoalesced;
+}
+
+int FSInFlightRequests::getNumInFlight() const
+{
+	const ScopedLock sl(lock);
+	return (int) flights.size();
+}
+
+FSInFlightRequests& FSInFlightRequests::getShared()
+{
+	static FSInFlightRequests sharedRequests;
+	return sharedRequests;
+}
+
+int FSHostLimiter::getMaxRequestsPerHost() const
+{
+	return maxRequestsPerHost.load();
+}
+
+FSHostLimiter::HostStats FSHostLimiter::getHostStats(const String& host) const
+{
+	const ScopedLock sl(lock);
+	auto it = hosts.find(host);
+	return it != hosts.end() ? it->second : HostStats();
+}
+
+FSHostLimiter::HostStats FSHostLimiter::getTotalStats() const
+{
+	const ScopedLock sl(lock);
+	HostStats total;
+	for (const auto& entry : hosts)
+	{
+		const HostStats& stats = entry.second;
+		total.activeRequests += stats.activeRequests;
+		total.totalRequests += stats.totalRequests;
+		total.waitsForSlot += stats.waitsForSlot;
+	}
+	return total;
+}
+
+StringArray FSHostLimiter::getHosts() const
+{
+	const ScopedLock sl(lock);
+	StringArray hostNames;
+	for (const auto& entry : hosts)
+		hostNames.add(entry.first);
+	return hostNames;
+}
+
+String FSHostLimiter::getHostFor(const URL& url)
+{
+	return url.getScheme() + "://" + url.getDomain();
+}
+
+FSHostLimiter& FSHostLimiter::getShared()
+{
+	static FSHostLimiter sharedLimiter;
+	return sharedLimiter;
+}
+
+void FSHostLimiter::release(const String& host)
+{
+	{
+		const ScopedLock sl(lock);
+		HostStats& stats = hosts[host];
+		stats.activeRequests = jmax(0, stats.activeRequests - 1);
+	}
+	slotReleased.signal();
+}
+
+FSResponseCache::FSResponseCache(const File& directoryToUse, int64 maxSizeBytes)
+	: directory(directoryToUse),
+	maxSize(jmax((int64) 0, maxSizeBytes)),
+	defaultTimeToLive(RelativeTime::hours(1))
+{
+	// Sound and pack metadata almost never changes, while anything tied to the
+	// authenticated user must always come from the server
+	setTimeToLive("/sounds/", RelativeTime::days(7));
+	setTimeToLive(URIS::COMMENTS, RelativeTime::hours(1));
+	setTimeToLive("/packs/", RelativeTime::days(7));
+	setTimeToLive("/users/", RelativeTime::days(1));
+	setTimeToLive(URIS::TEXT_SEARCH, RelativeTime::hours(1));
+	setTimeToLive(URIS::CONTENT_SEARCH, RelativeTime::hours(1));
+	setTimeToLive(URIS::PENDING, RelativeTime());
+	setTimeToLive(URIS::ME, RelativeTime());
+	setTimeToLive("/oauth2/", RelativeTime());
+}
+
+FSResponseCache::Entry FSResponseCache::lookup(const String& key)
+{
+	const ScopedLock sl(lock);
+	loadIndexIfNeeded();
+
+	Entry entry;
+	const String name = getNameFor(key);
+	auto it = index.find(name);
+	if (it == index.end() || it->second.key != key)
+		return entry;
+
+	File bodyFile = getBodyFile(name);
+	if (!bodyFile.existsAsFile())
+	{
+		removeEntry(name);
+		return entry;
+	}
+
+	const int64 now = Time::currentTimeMillis();
+	IndexEntry& indexEntry = it->second;
+	indexEntry.lastUsed = now;
+	bodyFile.setLastModificationTime(Time(now));
+
+	entry.found = true;
+	entry.fresh = now - indexEntry.storedAt < getTimeToLive(key).inMilliseconds();
+	entry.file = bodyFile;
+	entry.eTag = indexEntry.eTag;
+	entry.lastModified = indexEntry.lastModified;
+	return entry;
+}
+
+void FSResponseCache::store(const String& key, const String& body, const String& eTag, const String& lastModified)
+{
+	if (getTimeToLive(key).inMilliseconds() <= 0)
+		return;
+
+	File bodyFile = createTemporaryFile();
+	if (bodyFile.replaceWithText(body))
+		storeFile(key, bodyFile, eTag, lastModified);
+	else
+		bodyFile.deleteFile();
+}
+
+void FSResponseCache::storeFile(const String& key, const File& bodyFile, const String& eTag, const String& lastModified)
+{
+	if (getTimeToLive(key).inMilliseconds() <= 0)
+	{
+		bodyFile.deleteFile();
+		return;
+	}
+
+	const ScopedLock sl(lock);
+	loadIndexIfNeeded();
+
+	const String name = getNameFor(key);
+	if (index.find(name) != index.end())
+		removeEntry(name);
+
+	if (!directory.createDirectory() || !bodyFile.moveFileTo(getBodyFile(name)))
+	{
+		bodyFile.deleteFile();
+		return;
+	}
+
+	IndexEntry entry;
+	entry.key = key;
+	entry.storedAt = Time::currentTimeMillis();
+	entry.lastUsed = entry.storedAt;
+	entry.size = getBodyFile(name).getSize();
+	entry.eTag = eTag;
+	entry.lastModified = lastModified;
+	writeMetadata(name, entry);
+
+	index[name] = entry;
+	totalSize += entry.size;
+	evictIfNeeded();
+}
+
+void FSResponseCache::markRevalidated(const String& key)
+{
+	const ScopedLock sl(lock);
+	loadIndexIfNeeded();
+
+	const String name = getNameFor(key);
+	auto it = index.find(name);
+	if (it == index.end() || it->second.key != key)
+		return;
+
+	it->second.storedAt = Time::currentTimeMillis();
+	writeMetadata(name, it->second);
+}
+
+void FSResponseCache::setDefaultTimeToLive(RelativeTime ttl)
+{
+	const ScopedLock sl(lock);
+	defaultTimeToLive = ttl;
+}
+
+void FSResponseCache::setTimeToLive(const String& endpoint, RelativeTime ttl)
+{
+	const ScopedLock sl(lock);
+	endpointTimesToLive.set(endpoint, String(ttl.inMilliseconds()));
+}
+
+RelativeTime FSResponseCache::getTimeToLive(const String& key) const
+{
+	const ScopedLock sl(lock);
+	const StringArray pathSegments = getApiPathSegments(URL(key));
+
+	int bestMatch = -1;
+	RelativeTime ttl = defaultTimeToLive;
+
+	for (int i = 0; i < endpointTimesToLive.size(); ++i)
+	{
+		const int match = matchEndpoint(pathSegments, endpointTimesToLive.getAllKeys()[i]);
+		if (match > bestMatch)
+		{
+			bestMatch = match;
+			ttl = RelativeTime::milliseconds(endpointTimesToLive.getAllValues()[i].getLargeIntValue());
+		}
+	}
+	return ttl;
+}
+
+void FSResponseCache::setMaxSize(int64 maxSizeBytes)
+{
+	const ScopedLock sl(lock);
+	maxSize = jmax((int64) 0, maxSizeBytes);
+	loadIndexIfNeeded();
+	evictIfNeeded();
+}
+
+int64 FSResponseCache::getTotalSize()
+{
+	const ScopedLock sl(lock);
+	loadIndexIfNeeded();
+	return totalSize;
+}
+
+void FSResponseCache::clear()
+{
+	const ScopedLock sl(lock);
+	loadIndexIfNeeded();
+	while (!index.empty())
+		removeEntry(index.begin()->first);
+}
+
+File FSResponseCache::getDirectory() const
+{
+	return directory;
+}
+
+File FSResponseCache::createTemporaryFile()
+{
+	directory.createDirectory();
+	File file = directory.getNonexistentChildFile("incoming", ".tmp", false);
+	file.create();
+	return file;
+}
+
+String FSResponseCache::getKeyFor(const URL& url)
+{
+	StringArray parameters;
+	for (int i = 0; i < url.getParameterNames().size(); ++i)
+		parameters.add(url.getParameterNames()[i] + "=" + url.getParameterValues()[i]);
+	parameters.sort(false);
+
+	String key = url.toString(false);
+	if (parameters.size() > 0)
+		key << "?" << parameters.joinIntoString("&");
+	return key;
+}
+
+static std::shared_ptr<FSResponseCache>& getDefaultResponseCacheStorage()
+{
+	static std::shared_ptr<FSResponseCache> defaultCache;
+	return defaultCache;
+}
+
+static CriticalSection defaultResponseCacheLock;
+
+std::shared_ptr<FSResponseCache> FSResponseCache::getDefault()
+{
+	const ScopedLock sl(defaultResponseCacheLock);
+	return getDefaultResponseCacheStorage();
+}
+
+void FSResponseCache::setDefault(std::shared_ptr<FSResponseCache> cache)
+{
+	const ScopedLock sl(defaultResponseCacheLock);
+	getDefaultResponseCacheStorage() = cache;
+}
+
+void FSResponseCache::loadIndexIfNeeded()
+{
+	if (indexLoaded)
+		return;
+	indexLoaded = true;
+
+	// Bodies left half-written by an interrupted request
+	for (const auto& temporaryFile : directory.findChildFiles(File::findFiles, false, "*.tmp"))
+		if (Time::getCurrentTime() - temporaryFile.getLastModificationTime() > RelativeTime::hours(1))
+			temporaryFile.deleteFile();
+
+	for (const auto& metadataFile : directory.findChildFiles(File::findFiles, false, "*.meta"))
+	{
+		const String name = metadataFile.getFileNameWithoutExtension();
+		var metadata = JSON::parse(metadataFile);
+		File bodyFile = getBodyFile(name);
+
+		if (!metadata.isObject() || !bodyFile.existsAsFile())
+		{
+			metadataFile.deleteFile();
+			bodyFile.deleteFile();
+			continue;
+		}
+
+		IndexEntry entry;
+		entry.key = metadata["key"];
+		entry.storedAt = metadata["storedAt"];
+		entry.lastUsed = bodyFile.getLastModificationTime().toMilliseconds();
+		entry.size = bodyFile.getSize();
+		entry.eTag = metadata["eTag"];
+		entry.lastModified = metadata["lastModified"];
+
+		index[name] = entry;
+		totalSize += entry.size;
+	}
+
+	evictIfNeeded();
+}
+
+void FSResponseCache::writeMetadata(const String& name, const IndexEntry& entry)
+{
+	DynamicObject::Ptr metadata = new DynamicObject();
+	metadata->setProperty("key", entry.key);
+	metadata->setProperty("storedAt", entry.storedAt);
+	metadata->setProperty("eTag", entry.eTag);
+	metadata->setProperty("lastModified", entry.lastModified);
+	getMetadataFile(name).replaceWithText(JSON::toString(var(metadata.get())));
+}
+
+void FSResponseCache::removeEntry(const String& name)
+{
+	auto it = index.find(name);
+	if (it != index.end())
+	{
+		totalSize -= it->second.size;
+		index.erase(it);
+	}
+	getBodyFile(name).deleteFile();
+	getMetadataFile(name).deleteFile();
+}
+
+void FSResponseCache::evictIfNeeded()
+{
+	while (totalSize > maxSize && !index.empty())
+	{
+		auto leastRecentlyUsed = index.begin();
+		for (auto it = index.begin(); it != index.end(); ++it)
+			if (it->second.lastUsed < leastRecentlyUsed->second.lastUsed)
+				leastRecentlyUsed = it;
+		removeEntry(leastRecentlyUsed->first);
+	}
+}
+
+File FSResponseCache::getBodyFile(const String& name) const
+{
+	return directory.getChildFile(name + ".json");
+}
+
+File FSResponseCache::getMetadataFile(const String& name) const
+{
+	return directory.getChildFile(name + ".meta");
+}
+
+String FSResponseCache::getNameFor(const String& key)
+{
+	return String::toHexString(key.hashCode64());
+}
+
+FSJsonStreamReader::FSJsonStreamReader(InputStream& sourceToRead)
+	: source(sourceToRead),
+	buffer(8192)
+{
+}
+
+int FSJsonStreamReader::peekChar()
+{
+	if (bufferPosition >= bufferSize)
+	{
+		bufferSize = jmax(0, source.read(buffer, 8192));
+		bufferPosition = 0;
+		if (bufferSize == 0)
+			return -1;
+	}
+	return (unsigned char) buffer[bufferPosition];
+}
+
+int FSJsonStreamReader::nextChar()
+{
+	const int c = peekChar();
+	if (c >= 0)
+		advance();
+	return c;
+}
+
+void FSJsonStreamReader::advance()
+{
+	if (capture != nullptr)
+		*capture += buffer[bufferPosition];
+	++bufferPosition;
+}
+
+int FSJsonStreamReader::peekToken()
+{
+	for (;;)
+	{
+		const int c = peekChar();
+		if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+			return c;
+		advance();
+	}
+}
+
+bool FSJsonStreamReader::expect(char expected)
+{
+	if (failed)
+		return false;
+	if (peekToken() != expected)
+	{
+		fail();
+		return false;
+	}
+	advance();
+	return true;
+}
+
+bool FSJsonStreamReader::beginObject()
+{
+	if (!expect('{'))
+		return false;
+	hasPreviousItem.add(false);
+	return true;
+}
+
+bool FSJsonStreamReader::nextKey(String& key)
+{
+	if (failed || hasPreviousItem.isEmpty())
+		return false;
+
+	if (peekToken() == '}')
+	{
+		advance();
+		hasPreviousItem.removeLast();
+		return false;
+	}
+
+	if (hasPreviousItem.getLast() && !expect(','))
+		return false;
+	hasPreviousItem.setUnchecked(hasPreviousItem.size() - 1, true);
+
+	if (peekToken() != '"')
+	{
+		fail();
+		return false;
+	}
+
+	std::string bytes;
+	readStringInto(bytes, true);
+	key = String::fromUTF8(bytes.data(), (int) bytes.size());
+	return expect(':');
+}
+
+bool FSJsonStreamReader::beginArray()
+{
+	if (!expect('['))
+		return false;
+	hasPreviousItem.add(false);
+	return true;
+}
+
+bool FSJsonStreamReader::nextElement()
+{
+	if (failed || hasPreviousItem.isEmpty())
+		return false;
+
+	if (peekToken() == ']')
+	{
+		advance();
+		hasPreviousItem.removeLast();
+		return false;
+	}
+
+	if (hasPreviousItem.getLast() && !expect(','))
+		return false;
+	hasPreviousItem.setUnchecked(hasPreviousItem.size() - 1, true);
+	return !failed;
+}
+
+var FSJsonStreamReader::readValue()
+{
+	if (failed)
+		return var();
+
+	switch (peekToken())
+	{
+	case '{':
+	{
+		DynamicObject::Ptr object = new DynamicObject();
+		beginObject();
+		String key;
+		while (nextKey(key))
+			object->setProperty(key, readValue());
+		return var(object.get());
+	}
+	case '[':
+	{
+		Array<var> elements;
+		beginArray();
+		while (nextElement())
+			elements.add(readValue());
+		return var(elements);
+	}
+	case '"':
+	{
+		std::string bytes;
+		readStringInto(bytes, true);
+		return var(String::fromUTF8(bytes.data(), (int) bytes.size()));
+	}
+	case 't':
+		readLiteral("true");
+		return var(true);
+	case 'f':
+		readLiteral("false");
+		return var(false);
+	case 'n':
+		readLiteral("null");
+		return var();
+	default:
+		return readNumber();
+	}
+}
+
+String FSJsonStreamReader::readString()
+{
+	if (!failed && peekToken() == '"')
+	{
+		std::string bytes;
+		readStringInto(bytes, true);
+		return String::fromUTF8(bytes.data(), (int) bytes.size());
+	}
+	return readValue().toString();
+}
+
+String FSJsonStreamReader::readRawValue()
+{
+	if (failed || nextIsNull())
+	{
+		skipValue();
+		return String();
+	}
+
+	std::string bytes;
+	peekToken();
+	capture = &bytes;
+	skipValue();
+	capture = nullptr;
+	return String::fromUTF8(bytes.data(), (int) bytes.size());
+}
+
+void FSJsonStreamReader::skipValue()
+{
+	if (failed)
+		return;
+
+	switch (peekToken())
+	{
+	case '{':
+	{
+		beginObject();
+		String key;
+		while (nextKey(key))
+			skipValue();
+		break;
+	}
+	case '[':
+		beginArray();
+		while (nextElement())
+			skipValue();
+		break;
+	case '"':
+	{
+		std::string unused;
+		readStringInto(unused, false);
+		break;
+	}
+	default:
+		readValue();
+		break;
+	}
+}
+
+bool FSJsonStreamReader::nextIsNull()
+{
+	return !failed && peekToken() == 'n';
+}
+
+//Appends a code point to a string as UTF-8
+static void appendUTF8(std::string& bytes, uint32 codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		bytes += (char) codePoint;
+	}
+	else if (codePoint < 0x800)
+	{
+		bytes += (char) (0xc0 | (codePoint >> 6));
+		bytes += (char) (0x80 | (codePoint & 0x3f));
+	}
+	else if (codePoint < 0x10000)
+	{
+		bytes += (char) (0xe0 | (codePoint >> 12));
+		bytes += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+		bytes += (char) (0x80 | (codePoint & 0x3f));
+	}
+	else
+	{
+		bytes += (char) (0xf0 | (codePoint >> 18));
+		bytes += (char) (0x80 | ((codePoint >> 12) & 0x3f));
+		bytes += (char) (0x80 | ((codePoint >> 6) & 0x3f));
+		bytes += (char) (0x80 | (codePoint & 0x3f));
+	}
+}
+
+static bool isHighSurrogate(uint32 codePoint) { return codePoint >= 0xd800 && codePoint < 0xdc00; }
+static bool isLowSurrogate(uint32 codePoint) { return codePoint >= 0xdc00 && codePoint < 0xe000; }
+
+void FSJsonStreamReader::readStringInto(std::string& bytes, bool keep)
+{
+	nextChar(); // opening quote
+
+	for (;;)
+	{
+		int c = nextChar();
+		if (c < 0)
+		{
+			fail();
+			return;
+		}
+		if (c == '"')
+			return;
+		if (c != '\\')
+		{
+			if (keep)
+				bytes += (char) c;
+			continue;
+		}
+
+		uint32 codePoint = 0;
+		if (!readEscape(codePoint))
+		{
+			fail();
+			return;
+		}
+
+		// A high surrogate only stands for a character together with the low half escaped
+		// right after it. Halves which are not part of such a pair become U+FFFD, as they
+		// can not be encoded as UTF-8.
+		while (isHighSurrogate(codePoint) && peekChar() == '\\')
+		{
+			nextChar();
+			uint32 nextCodePoint = 0;
+			if (!readEscape(nextCodePoint))
+			{
+				fail();
+				return;
+			}
+			if (isLowSurrogate(nextCodePoint))
+			{
+				codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (nextCodePoint - 0xdc00);
+				break;
+			}
+			if (keep)
+				appendUTF8(bytes, 0xfffd);
+			codePoint = nextCodePoint;
+		}
+		if (isHighSurrogate(codePoint) || isLowSurrogate(codePoint))
+			codePoint = 0xfffd;
+
+		if (keep)
+			appendUTF8(bytes, codePoint);
+	}
+}
+
+bool FSJsonStreamReader::readEscape(uint32& codePoint)
+{
+	const int c = nextChar();
+	switch (c)
+	{
+	case '"': case '\\': case '/': codePoint = (uint32) c; return true;
+	case 'b': codePoint = '\b'; return true;
+	case 'f': codePoint = '\f'; return true;
+	case 'n': codePoint = '\n'; return true;
+	case 'r': codePoint = '\r'; return true;
+	case 't': codePoint = '\t'; return true;
+	case 'u':
+		codePoint = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const int digit = CharacterFunctions::getHexDigitValue((juce_wchar) nextChar());
+			if (digit < 0)
+				return false;
+			codePoint = (codePoint << 4) | (uint32) digit;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+void FSJsonStreamReader::readLiteral(const char* literal)
+{
+	for (; *literal != 0; ++literal)
+	{
+		if (nextChar() != *literal)
+		{
+			fail();
+			return;
+		}
+	}
+}
+
+var FSJsonStreamReader::readNumber()
+{
+	char text[64];
+	int length = 0;
+	bool isFloatingPoint = false;
+
+	for (;;)
+	{
+		const int c = peekChar();
+		if ((c >= '0' && c <= '9') || c == '-' || c == '+')
+		{
+		}
+		else if (c == '.' || c == 'e' || c == 'E')
+		{
+			isFloatingPoint = true;
+		}
+		else
+		{
+			break;
+		}
+
+		if (length == (int) sizeof(text) - 1)
+		{
+			fail();
+			return var();
+		}
+		text[length++] = (char) nextChar();
+	}
+
+	if (length == 0)
+	{
+		fail();
+		return var();
+	}
+
+	text[length] = 0;
+	if (isFloatingPoint)
+		return var(String(text).getDoubleValue());
+
+	const int64 value = String(text).getLargeIntValue();
+	if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max())
+		return var((int) value);
+	return var(value);
+}
+
+
+
+
+void FreesoundClientComponent::startAuthentication(int mode)
+{
+	URL url;
+	if (mode == 0) { url = URIS::uri(URIS::LOGOUT_AUTHORIZE, StringArray()); }
+	else { url = URIS::uri(URIS::AUTHORIZE, StringArray()); }
+	url = url.withParameter("client_id", getClientID());
+	url = url.withParameter("response_type", "code");
+	goToURL(url.toString(true));
+}
+
+
+
+void FreesoundClientComponent::pageFinishedLoading(const String &url) {
+	if (url.startsWith("https://freesound.org/home/app_permissions/permission_granted/")) {
+		URL recUrl(url);
+		StringArray paramNames = recUrl.getParameterNames();
+		StringArray paramVals = recUrl.getParameterValues();
+
+		int codeInd = paramNames.indexOf("code", true, 0);
+		authCode = paramVals[codeInd];
+		if (finishedLoadingCallback != nullptr) {
+			finishedLoadingCallback();
+		}
+
+	}
+
+}
+
+void FreesoundClientComponent::exchangeToken(Callback cb)
+{
+	StringPairArray params;
+	params.set("client_id", clientID);
+	params.set("client_secret", clientSecret);
+	params.set("grant_type", "authorization_code");
+	params.set("code", authCode);
+
+	URL url = URIS::uri(URIS::ACCESS_TOKEN, StringArray());
+	FSRequest request(url, *this);
+	Response resp = request.request(params);
+	int resultCode = resp.first;
+	if (resultCode == 200) {
+		var response = resp.second;
+		accessToken = response["access_token"];
+		refreshToken = response["refresh_token"];
+		header = "Bearer " + accessToken;
+	}
+	cb();
+}
+
+
+void FreesoundClientComponent::pageLoadHadNetworkError() {
+	startAuthentication();
+}
+
+void FreesoundClientComponent::setCallback(Callback cb)
+{
+	finishedLoadingCallback = cb;
+}
+
+
+
+//Input stream which copies everything read from its source into an output stream
+class FSTeeInputStream : public InputStream
+{
+public:
+	FSTeeInputStream(InputStream& sourceStream, OutputStream& copyStream)
+		: source(sourceStream), copy(copyStream) {}
+
+	int64 getTotalLength() override { return source.getTotalLength(); }
+	bool isExhausted() override { return source.isExhausted(); }
+	int64 getPosition() override { return source.getPosition(); }
+	bool setPosition(int64 newPosition) override { return newPosition == source.getPosition(); }
+
+	int read(void* destBuffer, int maxBytesToRead) override
+	{
+		const int bytesRead = source.read(destBuffer, maxBytesToRead);
+		if (bytesRead > 0 && !copy.write(destBuffer, (size_t) bytesRead))
+			copyFailed = true;
+		return bytesRead;
+	}
+
+	bool copyFailed = false;
+
+private:
+	InputStream& source;
+	OutputStream& copy;
+};
+
+Response FSRequest::request(StringPairArray params, String data, bool postLikeRequest)
+{
+	var response;
+	int statusCode = requestStream([&response](InputStream& stream, int) {
+		//Store the response, it is returned in a pair containing (statusCode, response)
+		response = JSON::parse(stream.readEntireStreamAsString());
+		return !response.isVoid();
+	}, params, data, postLikeRequest);
+	return Response(statusCode, response);
+}
+
+//Marks a flight as finished when the leading request returns, even if its consumer throws
+struct FSFlightFinisher
+{
+	FSFlightFinisher(const String& keyToFinish, std::shared_ptr<FSInFlightRequests::Flight> flightToFinish)
+		: key(keyToFinish), flight(flightToFinish) {}
+	~FSFlightFinisher() { FSInFlightRequests::getShared().finish(key, flight); }
+
+	String key;
+	std::shared_ptr<FSInFlightRequests::Flight> flight;
+};
+
+int FSRequest::requestStream(std::function<bool(InputStream&, int)> consumer, StringPairArray params, String data, bool postLikeRequest)
+{
+	FSInFlightRequests& inFlight = FSInFlightRequests::getShared();
+	if (postLikeRequest || data.isNotEmpty() || !inFlight.isEnabled())
+		return performRequest(consumer, params, data, postLikeRequest, nullptr);
+
+	//Identical GETs in flight at the same time are coalesced into the first one
+	URL url = params.size() != 0 ? uri.withParameters(params) : uri;
+	const String key = FSResponseCache::getKeyFor(url) + "\n" + client.getHeader();
+	bool isLeader = false;
+	auto flight = inFlight.join(key, isLeader);
+
+	if (isLeader)
+	{
+		FSFlightFinisher finisher(key, flight);
+		return performRequest(consumer, params, data, postLikeRequest, flight.get());
+	}
+
+	flight->finished.wait();
+	if (flight->hasBody)
+	{
+		MemoryInputStream bodyStream(flight->body, false);
+		consumer(bodyStream, flight->statusCode);
+		return flight->statusCode;
+	}
+	if (flight->storedInCache)
+		return performRequest(consumer, params, data, postLikeRequest, nullptr);
+	return flight->statusCode;
+}
+
+int FSRequest::performRequest(std::function<bool(InputStream&, int)> consumer, StringPairArray params, String data, bool postLikeRequest, FSInFlightRequests::Flight* flight)
+{
+
+	URL url = uri;
+	String header;
+	int statusCode = -1;
+	StringPairArray responseHeaders;
+	if (data.isNotEmpty()) { url = url.withPOSTData(data); }
+	if (params.size() != 0) { url = url.withParameters(params); }
+	if (client.isTokenNotEmpty()) { header = "Authorization: " + client.getHeader(); }
+
+	//Plain GET requests go through the response cache, if any
+	auto cache = (!postLikeRequest && data.isEmpty()) ? client.getResponseCache() : nullptr;
+	String cacheKey;
+	FSResponseCache::Entry cached;
+	if (cache != nullptr)
+	{
+		cacheKey = FSResponseCache::getKeyFor(url);
+		cached = cache->lookup(cacheKey);
+		if (cached.found && cached.fresh)
+		{
+			FileInputStream cachedStream(cached.file);
+			if (cachedStream.openedOk() && consumer(cachedStream, 200))
+			{
+				if (flight != nullptr) { flight->statusCode = 200; flight->storedInCache = true; }
+				return 200;
+			}
+			cached = FSResponseCache::Entry();
+		}
+		if (cached.found && cached.eTag.isNotEmpty())
+			header += (header.isEmpty() ? "" : "\r\n") + String("If-None-Match: ") + cached.eTag;
+		if (cached.found && cached.lastModified.isNotEmpty())
+			header += (header.isEmpty() ? "" : "\r\n") + String("If-Modified-Since: ") + cached.lastModified;
+	}
+
+	//Open the stream within the rate limits, retrying throttled and failed responses. POST like
+	//requests are only retried on 429, as a server error may come after they took effect
+	FSRateLimiter& limiter = FSRateLimiter::getShared();
+	std::unique_ptr<FSHostLimiter::Lease> lease;
+	std::unique_ptr<InputStream> stream;
+	for (int attempt = 0;; ++attempt)
+	{
+		//The endpoint is paused for longer than requests wait, so this one fails at once
+		if (limiter.acquire(url) < 0)
+		{
+			statusCode = 429;
+			break;
+		}
+
+		//Take a request slot for the host, so that concurrent requests to it are bounded
+		lease = FSHostLimiter::getShared().acquire(url, 10000);
+		if (lease == nullptr)
+			return statusCode;
+
+		//Try to open a stream with this information.
+		statusCode = -1;
+		responseHeaders.clear();
+		stream = std::unique_ptr<InputStream>(url.createInputStream(postLikeRequest, nullptr, nullptr, header,
+			10000, // timeout in millisecs
+			&responseHeaders, &statusCode));
+
+		int delayMs = 0;
+		if ((postLikeRequest && statusCode != 429)
+			|| !limiter.shouldRetry(url, statusCode, attempt, responseHeaders["Retry-After"], delayMs))
+			break;
+
+		stream.reset();
+		lease.reset();
+		limiter.recordBackoff(delayMs);
+		Thread::sleep(delayMs);
+	}
+
+	if (stream != nullptr)
+	{
+		//The cached response is still valid, only its time to live is restarted
+		if (statusCode == 304 && cached.found)
+		{
+			FileInputStream cachedStream(cached.file);
+			if (cachedStream.openedOk())
+			{
+				cache->markRevalidated(cacheKey);
+				if (flight != nullptr) { flight->statusCode = 200; flight->storedInCache = true; }
+				consumer(cachedStream, 200);
+				return 200;
+			}
+		}
+
+		if (cache == nullptr || statusCode != 200)
+		{
+			//Requests made from now on open their own stream, so the body is only copied
+			//when some are already waiting for it
+			if (flight == nullptr || !FSInFlightRequests::getShared().close(*flight))
+			{
+				consumer(*stream, statusCode);
+				if (flight != nullptr) { flight->statusCode = statusCode; }
+				return statusCode;
+			}
+
+			//Keep a copy of the body for the requests coalesced into this one
+			MemoryOutputStream bodyCopy(flight->body, false);
+			FSTeeInputStream tee(*stream, bodyCopy);
+			consumer(tee, statusCode);
+			bodyCopy.flush();
+			flight->statusCode = statusCode;
+			flight->hasBody = !tee.copyFailed;
+			return statusCode;
+		}
+
+		//Stream the body to the consumer and, at the same time, into the cache
+		File bodyFile = cache->createTemporaryFile();
+		bool cacheable = false;
+		{
+			FileOutputStream bodyCopy(bodyFile);
+			FSTeeInputStream tee(*stream, bodyCopy);
+			cacheable = consumer(tee, statusCode) && bodyCopy.openedOk() && !tee.copyFailed;
+			bodyCopy.flush();
+		}
+
+		if (cacheable)
+			cache->storeFile(cacheKey, bodyFile, responseHeaders["ETag"], responseHeaders["Last-Modified"]);
+		else
+			bodyFile.deleteFile();
+		if (flight != nullptr) { flight->statusCode = statusCode; flight->storedInCache = cacheable; }
+		return statusCode;
+	}
+	//Couldnt create stream, return -1
+	if (flight != nullptr) { flight->statusCode = statusCode; }
+	return statusCode;
+}
+
+FSList::FSList()
+{
+	count = 0;
+}
+
+FSList::FSList(var response)
+{
+	count = response["count"]; //getIntValue
+	nextPage = response["next"];
+	previousPage = response["previous"];
+	results = response["results"];
+}
+
+String FSList::getNextPage()
+{
+	return nextPage;
+}
+
+String FSList::getPreviousPage()
+{
+	return previousPage;
+}
+
+var FSList::getResults()
+{
+	return results;
+}
+
+int FSList::getCount()
+{
+	return count;
+}
+
+//Gets the value of the page or page_size parameter of a page URL, or fallback if missing
+static int getPageParameter(const String& pageURL, const String& parameter, int fallback)
+{
+	URL url(pageURL);
+	const int index = url.getParameterNames().indexOf(parameter);
+	return index >= 0 ? url.getParameterValues()[index].getIntValue() : fallback;
+}
+
+int FSList::getPageSize() const
+{
+	const String neighbour = nextPage.isNotEmpty() ? nextPage : previousPage;
+	return jmax(1, getPageParameter(neighbour, "page_size", 15));
+}
+
+int FSList::getPageNumber() const
+{
+	if (nextPage.isNotEmpty())
+		return getPageParameter(nextPage, "page", 2) - 1;
+	if (previousPage.isNotEmpty())
+		return getPageParameter(previousPage, "page", 1) + 1;
+	return 1;
+}
+
+int FSList::getNumPages() const
+{
+	if (nextPage.isEmpty() && previousPage.isEmpty())
+		return 1;
+	const int pageSize = getPageSize();
+	return jmax(1, (count + pageSize - 1) / pageSize);
+}
+
+String FSList::getPageURL(int page) const
+{
+	const String neighbour = nextPage.isNotEmpty() ? nextPage : previousPage;
+	if (neighbour.isEmpty())
+		return String();
+
+	URL url(neighbour);
+	StringPairArray params;
+	for (int i = 0; i < url.getParameterNames().size(); i++)
+		params.set(url.getParameterNames()[i], url.getParameterValues()[i]);
+	params.set("page", String(page));
+
+	return URL(url.toString(false)).withParameters(params).toString(true);
+}
+
+FSSound::FSSound()
+{
+}
+
+FSSound::FSSound(var sound)
+{
+	id = sound["id"];
+	url = URL(sound["url"]);
+	name = sound["name"];
+	tags = StringArray();
+	for (int i = 0; i < sound["tags"].size(); i++) {
+		tags.add(sound["tags"][i]);
+	}
+	description = sound["description"];
+	geotag = sound["geotag"];
+	created = sound["created"];
+	license = sound["license"];
+	format = sound["type"];
+	channels = sound["channels"];
+	filesize = sound["filesize"];
+	bitrate = sound["bitrate"];
+	bitdepth = sound["bitdepth"];
+	duration = sound["duration"];
+	samplerate = sound["samplerate"];
+	user = sound["username"];
+	pack = URL(sound["pack"]);
+	download = URL(sound["download"]);
+	bookmark = URL(sound["bookmark"]);
+	previews = sound["previews"];
+	images = sound["images"];
+	numDownloads = sound["num_downloads"];
+	avgRating = sound["avg_rating"];
+	numRatings = sound["num_ratings"];
+	rate = URL(sound["rate"]);
+	comments = URL(sound["comments"]);
+	numComments = sound["num_comments"];
+	comment = URL(sound["comment"]);
+	similarSounds = URL(sound["similar_sounds"]);
+	analysis = sound["analysis"];
+	analysisStats = URL(sound["analysis_stats"]);
+	analysisFrames = URL(sound["analysis_frames"]);
+	acAnalysis = sound["ac_analysis"];
+}
+
+URL FSSound::getDownload()
+{
+	return download;
+}
+
+URL FSSound::getOGGPreviewURL()
+{
+    if (!previews.hasProperty("preview-hq-ogg")){
+        /*
+         If you reached this bit of code is because you're trying to download the preview of a sound
+         but the freesound-juce client does not know the URL where to find that preview.
+         
+         It can happen that the FSSound object does not have "previews" property if the object was
+         constructed from the results of a SoundList (e.g. using SoundList::toSoundArray method) and
+         the "previews" field was not initially requested in the query that created the SoundList
+         object. If you just reached this bit of code, make sure that you include the "previews" field
+         in the "fields" parameter of the function that generated the SoundList.
+         */
+        throw;
+    }
+    return URL(previews["preview-hq-ogg"]);
+}
+
+
+
+FSUser::FSUser()
+{
+}
+
+FSUser::FSUser(var user)
+{
+	profile = URL(user["url"]);
+	about = user["about"];
+	username = user["username"];
+	homepage = URL(user["homepage"]);
+	avatar = user["avatar"];
+	dateJoined = user["date_joined"];
+	numSounds = user["num_sounds"];
+	sounds = URL(user["sounds"]);
+	numPacks = user["num_packs"];
+	packs = URL(user["packs"]);
+	numPosts = user["num_posts"];
+	numComments = user["num_comments"];
+	bookmarks = URL(user["bookmarks"]);
+
+}
+
+FSPack::FSPack()
+{
+}
+
+FSPack::FSPack(var pack)
+{
+	id = pack["id"];
+	url = URL(pack["url"]);
+	description = pack["description"];
+	created = pack["created"];
+	name = pack["name"];
 	username = pack["username"];
 	numSounds = pack["num_sounds"];
 	sounds = URL(pack["sounds"]);
@@ -965,12 +2689,175 @@ String FSPack::getID()
 	return id;
 }
 
-Array<FSSound> SoundList::toArrayOfSounds()
+//Gets the number at the end of an API URL such as https://freesound.org/apiv2/packs/1234/
+static int getTrailingIdentifier(const String& url)
+{
+	return url.trimCharactersAtEnd("/").fromLastOccurrenceOf("/", false, false).getIntValue();
+}
+
+FSCompactSound::FSCompactSound()
+{
+}
+
+FSCompactSound::FSCompactSound(var sound)
+{
+	id = sound["id"];
+	name = sound["name"];
+	for (int i = 0; i < sound["tags"].size(); i++) {
+		tags.add(sound["tags"][i]);
+	}
+	description = sound["description"];
+	geotag = sound["geotag"];
+	created = sound["created"];
+	license = intern(sound["license"]);
+	format = intern(sound["type"]);
+	username = intern(sound["username"]);
+	duration = sound["duration"];
+	avgRating = sound["avg_rating"];
+	filesize = sound["filesize"];
+	bitrate = sound["bitrate"];
+	samplerate = sound["samplerate"];
+	numDownloads = sound["num_downloads"];
+	numRatings = sound["num_ratings"];
+	numComments = sound["num_comments"];
+	packId = getTrailingIdentifier(sound["pack"]);
+	channels = (int16) (int) sound["channels"];
+	bitdepth = (int16) (int) sound["bitdepth"];
+	previews = sound["previews"];
+	images = sound["images"];
+	analysis = sound["analysis"];
+	acAnalysis = sound["ac_analysis"];
+}
+
+FSCompactSound::FSCompactSound(const FSSound& sound)
+{
+	id = sound.id.getIntValue();
+	name = sound.name;
+	tags = sound.tags;
+	description = sound.description;
+	geotag = sound.geotag;
+	created = sound.created;
+	license = intern(sound.license);
+	format = intern(sound.format);
+	username = intern(sound.user);
+	duration = (float) sound.duration;
+	avgRating = sound.avgRating;
+	filesize = sound.filesize;
+	bitrate = sound.bitrate;
+	samplerate = sound.samplerate;
+	numDownloads = sound.numDownloads;
+	numRatings = sound.numRatings;
+	numComments = sound.numComments;
+	packId = getTrailingIdentifier(sound.pack.toString(false));
+	channels = (int16) sound.channels;
+	bitdepth = (int16) sound.bitdepth;
+	previews = sound.previews;
+	images = sound.images;
+	analysis = sound.analysis;
+	acAnalysis = sound.acAnalysis;
+}
+
+FSSound FSCompactSound::toFSSound() const
+{
+	FSSound sound;
+	sound.id = getIDString();
+	sound.url = getURL();
+	sound.name = name;
+	sound.tags = tags;
+	sound.description = description;
+	sound.geotag = geotag;
+	sound.created = created;
+	sound.license = license;
+	sound.format = format;
+	sound.channels = channels;
+	sound.filesize = filesize;
+	sound.bitrate = bitrate;
+	sound.bitdepth = bitdepth;
+	sound.duration = duration;
+	sound.samplerate = samplerate;
+	sound.user = username;
+	if (packId != 0)
+		sound.pack = URIS::uri(URIS::PACK, StringArray(String(packId)));
+	sound.download = getDownload();
+	sound.bookmark = getResourceURL(URIS::BOOKMARK);
+	sound.previews = previews;
+	sound.images = images;
+	sound.numDownloads = numDownloads;
+	sound.avgRating = avgRating;
+	sound.numRatings = numRatings;
+	sound.rate = getResourceURL(URIS::RATE);
+	sound.comments = getResourceURL(URIS::COMMENTS);
+	sound.numComments = numComments;
+	sound.comment = getResourceURL(URIS::COMMENT);
+	sound.similarSounds = getResourceURL(URIS::SIMILAR_SOUNDS);
+	sound.analysis = analysis;
+	sound.analysisStats = getResourceURL(URIS::SOUND_ANALYSIS);
+	sound.acAnalysis = acAnalysis;
+	return sound;
+}
+
+String FSCompactSound::getIDString() const
+{
+	return String(id);
+}
+
+URL FSCompactSound::getURL() const
+{
+	return URL("https://" + URIS::HOST + "/people/" + username + "/sounds/" + getIDString() + "/");
+}
+
+URL FSCompactSound::getDownload() const
+{
+	return getResourceURL(URIS::DOWNLOAD);
+}
+
+URL FSCompactSound::getResourceURL(const String& resource) const
+{
+	return URIS::uri(resource, StringArray(getIDString()));
+}
+
+URL FSCompactSound::getOGGPreviewURL() const
+{
+	return URL(previews["preview-hq-ogg"].toString());
+}
+
+var FSCompactSound::getPreviews() const
+{
+	return previews;
+}
+
+var FSCompactSound::getImages() const
+{
+	return images;
+}
+
+var FSCompactSound::getAnalysis() const
 {
+	return analysis;
+}
+
+var FSCompactSound::getAcAnalysis() const
+{
+	return acAnalysis;
+}
 
+String FSCompactSound::intern(const String& text)
+{
+	return StringPool::getGlobalPool().getPooledString(text);
+}
 
+Array<FSSound> SoundList::toArrayOfSounds()
+{
 	Array<FSSound> arrayOfSounds;
 
+	if (parsedSounds != nullptr)
+	{
+		arrayOfSounds.ensureStorageAllocated(parsedSounds->size());
+		for (const auto& sound : *parsedSounds)
+			arrayOfSounds.add(sound.toFSSound());
+		return arrayOfSounds;
+	}
+
 	for (int i = 0; i < results.size(); i++)
 	{
 		arrayOfSounds.add(FSSound(results[i]));
@@ -978,3 +2865,93 @@ Array<FSSound> SoundList::toArrayOfSounds()
 
 	return arrayOfSounds;
 }
+
+Array<FSCompactSound> SoundList::toArrayOfCompactSounds()
+{
+	if (parsedSounds != nullptr)
+		return *parsedSounds;
+
+	Array<FSCompactSound> arrayOfSounds;
+	arrayOfSounds.ensureStorageAllocated(results.size());
+	for (int i = 0; i < results.size(); i++)
+		arrayOfSounds.add(FSCompactSound(results[i]));
+	return arrayOfSounds;
+}
+
+//Builds a compact sound member by member while its JSON object is being read
+static FSCompactSound readCompactSoundFromStream(FSJsonStreamReader& reader)
+{
+	FSCompactSound sound;
+	if (!reader.beginObject())
+		return sound;
+
+	String key;
+	while (reader.nextKey(key))
+	{
+		if (key == "id") { sound.id = reader.readValue(); }
+		else if (key == "name") { sound.name = reader.readString(); }
+		else if (key == "tags")
+		{
+			if (reader.nextIsNull()) { reader.skipValue(); continue; }
+			reader.beginArray();
+			while (reader.nextElement())
+				sound.tags.add(reader.readString());
+		}
+		else if (key == "description") { sound.description = reader.readString(); }
+		else if (key == "geotag") { sound.geotag = reader.readString(); }
+		else if (key == "created") { sound.created = reader.readString(); }
+		else if (key == "license") { sound.license = FSCompactSound::intern(reader.readString()); }
+		else if (key == "type") { sound.format = FSCompactSound::intern(reader.readString()); }
+		else if (key == "username") { sound.username = FSCompactSound::intern(reader.readString()); }
+		else if (key == "channels") { sound.channels = (int16) (int) reader.readValue(); }
+		else if (key == "filesize") { sound.filesize = reader.readValue(); }
+		else if (key == "bitrate") { sound.bitrate = reader.readValue(); }
+		else if (key == "bitdepth") { sound.bitdepth = (int16) (int) reader.readValue(); }
+		else if (key == "duration") { sound.duration = reader.readValue(); }
+		else if (key == "samplerate") { sound.samplerate = reader.readValue(); }
+		else if (key == "pack") { sound.packId = getTrailingIdentifier(reader.readString()); }
+		else if (key == "previews") { sound.previews = reader.readValue(); }
+		else if (key == "images") { sound.images = reader.readValue(); }
+		else if (key == "num_downloads") { sound.numDownloads = reader.readValue(); }
+		else if (key == "avg_rating") { sound.avgRating = reader.readValue(); }
+		else if (key == "num_ratings") { sound.numRatings = reader.readValue(); }
+		else if (key == "num_comments") { sound.numComments = reader.readValue(); }
+		else if (key == "analysis") { sound.analysis = reader.readValue(); }
+		else if (key == "ac_analysis") { sound.acAnalysis = reader.readValue(); }
+		else { reader.skipValue(); } // URLs are derived from the id
+	}
+	return sound;
+}
+
+SoundList SoundList::fromStream(InputStream& stream, bool* parsedOk)
+{
+	SoundList list;
+	auto sounds = std::make_shared<Array<FSCompactSound>>();
+	FSJsonStreamReader reader(stream);
+
+	if (reader.beginObject())
+	{
+		String key;
+		while (reader.nextKey(key))
+		{
+			if (key == "count") { list.count = reader.readValue(); }
+			else if (key == "next") { list.nextPage = reader.readString(); }
+			else if (key == "previous") { list.previousPage = reader.readString(); }
+			else if (key == "results" && !reader.nextIsNull())
+			{
+				reader.beginArray();
+				while (reader.nextElement())
+					sounds->add(readCompactSoundFromStream(reader));
+			}
+			else { reader.skipValue(); }
+		}
+	}
+
+	if (parsedOk != nullptr)
+		*parsedOk = !reader.hasFailed();
+	if (reader.hasFailed())
+		return SoundList();
+
+	list.parsedSounds = sounds;
+	return list;
+}
@@ -41,6 +41,1309 @@ typedef std::pair<int, var> Response;
 
 typedef std::function<void()> Callback;
 
+/**
+ * \class	FSWorkerPool
+ *
+ * \brief	A bounded pool of worker threads on which the asynchronous FreesoundClient
+ *			calls are run, so that network round trips never block the calling thread.
+ *			Several clients can share the same pool; by default they all use the pool
+ *			returned by getDefault().
+ */
+
+class FSWorkerPool {
+public:
+
+	/**
+	 * \fn	FSWorkerPool::FSWorkerPool(int numThreads = 4);
+	 *
+	 * \brief	Creates a pool with a fixed number of worker threads
+	 *
+	 * \param	numThreads	(Optional) The maximum number of requests running at the same time.
+	 */
+
+	FSWorkerPool(int numThreads = 4);
+
+	/**
+	 * \fn	FSWorkerPool::~FSWorkerPool();
+	 *
+	 * \brief	Destructor, waits for the running jobs to finish and drops the pending ones
+	 *			(calling their onDropped functions)
+	 */
+
+	~FSWorkerPool();
+
+	/**
+	 * \fn	void FSWorkerPool::submit(std::function<void()> job, std::function<void()> onDropped = nullptr);
+	 *
+	 * \brief	Queues a job to be run on one of the worker threads
+	 *
+	 * \param	job		 	The job to run.
+	 * \param	onDropped	(Optional) Called instead of the job if the pool is destroyed before running it.
+	 */
+
+	void submit(std::function<void()> job, std::function<void()> onDropped = nullptr);
+
+	/**
+	 * \fn	int FSWorkerPool::getNumThreads() const;
+	 *
+	 * \brief	Gets the number of worker threads of the pool
+	 *
+	 * \returns	The number of worker threads.
+	 */
+
+	int getNumThreads() const;
+
+	/**
+	 * \fn	int FSWorkerPool::getNumPendingJobs() const;
+	 *
+	 * \brief	Gets the number of jobs queued or running in the pool
+	 *
+	 * \returns	The number of jobs queued or running.
+	 */
+
+	int getNumPendingJobs() const;
+
+	/**
+	 * \fn	void FSWorkerPool::waitForAllJobs();
+	 *
+	 * \brief	Blocks until every job queued or running in the pool has finished. Must not
+	 *			be called from one of the pool's own jobs, which would wait for itself.
+	 */
+
+	void waitForAllJobs();
+
+	/**
+	 * \fn	bool FSWorkerPool::isPoolThread() const;
+	 *
+	 * \brief	Query if the calling thread is running one of the jobs of this pool
+	 *
+	 * \returns	True if called from a job of this pool.
+	 */
+
+	bool isPoolThread() const;
+
+	/**
+	 * \fn	static std::shared_ptr<FSWorkerPool> FSWorkerPool::getDefault();
+	 *
+	 * \brief	Gets the pool shared by all the clients which were not given a specific one
+	 *
+	 * \returns	The default worker pool.
+	 */
+
+	static std::shared_ptr<FSWorkerPool> getDefault();
+
+	/**
+	 * \fn	static void FSWorkerPool::setDefaultNumThreads(int numThreads);
+	 *
+	 * \brief	Replaces the default pool by one with the given number of threads. Clients
+	 *			which already hold the previous default pool keep using it. The jobs already
+	 *			queued on the previous pool are run before this returns, unless it is called
+	 *			from one of them, in which case they finish in the background.
+	 *
+	 * \param	numThreads	The number of worker threads of the new default pool.
+	 */
+
+	static void setDefaultNumThreads(int numThreads);
+
+private:
+	class Job;
+
+	void jobFinished();
+
+	/** \brief	Guards the count of pending jobs and the event signalled when it drops to zero */
+	CriticalSection pendingJobsLock;
+	/** \brief	The number of jobs queued or running */
+	int numPendingJobs = 0;
+	/** \brief	Signalled while no job is queued or running */
+	WaitableEvent allJobsFinished{ true };
+	/** \brief	The threads running the jobs */
+	std::unique_ptr<ThreadPool> pool;
+	/** \brief	The number of threads of the pool */
+	int numThreads;
+
+	JUCE_DECLARE_NON_COPYABLE(FSWorkerPool)
+};
+
+/**
+ * \class	FSHostLimiter
+ *
+ * \brief	Per-host concurrency limiter shared by FSRequest and the download paths. Every
+ *			request to a host first takes a lease on one of the host's request slots, which
+ *			bounds the number of requests open to the same server at once. It does not hold
+ *			or reuse connections; that is up to the platform HTTP stack.
+ */
+
+class FSHostLimiter {
+public:
+
+	/**
+	 * \struct	HostStats
+	 *
+	 * \brief	Request counters of a host, or of all the hosts together
+	 */
+
+	struct HostStats {
+		/** \brief	Leases currently held */
+		int activeRequests = 0;
+		/** \brief	Total number of requests made, leased or detached */
+		int64 totalRequests = 0;
+		/** \brief	Leases which had to wait because the host was at its request limit */
+		int64 waitsForSlot = 0;
+	};
+
+	/**
+	 * \class	Lease
+	 *
+	 * \brief	A request slot of a host, returned to the limiter when destroyed
+	 */
+
+	class Lease {
+	public:
+		~Lease();
+
+		/**
+		 * \fn	const String& FSHostLimiter::Lease::getHost() const;
+		 *
+		 * \brief	Gets the host this lease belongs to
+		 *
+		 * \returns	The host, as scheme and domain.
+		 */
+
+		const String& getHost() const { return host; }
+
+	private:
+		friend class FSHostLimiter;
+		Lease(FSHostLimiter& ownerLimiter, const String& hostName);
+
+		FSHostLimiter& owner;
+		String host;
+
+		JUCE_DECLARE_NON_COPYABLE(Lease)
+	};
+
+	/**
+	 * \fn	FSHostLimiter::FSHostLimiter(int maxRequestsPerHost = 4);
+	 *
+	 * \brief	Creates a limiter which has not seen any host yet
+	 *
+	 * \param	maxRequestsPerHost	(Optional) The maximum number of requests open at the same time to a host.
+	 */
+
+	FSHostLimiter(int maxRequestsPerHost = 4);
+
+	/**
+	 * \fn	std::unique_ptr<Lease> FSHostLimiter::acquire(const URL& url, int timeoutMs = -1);
+	 *
+	 * \brief	Takes a request slot for the host of the URL, waiting if all of them are in use
+	 *
+	 * \param	url		 	The URL about to be requested.
+	 * \param	timeoutMs	(Optional) The maximum time to wait for a slot, or -1 to wait forever.
+	 *
+	 * \returns	The lease, or nullptr if no slot was freed before the timeout.
+	 */
+
+	std::unique_ptr<Lease> acquire(const URL& url, int timeoutMs = -1);
+
+	/**
+	 * \fn	void FSHostLimiter::recordDetachedRequest(const URL& url);
+	 *
+	 * \brief	Accounts for a request whose connection is managed elsewhere (e.g. by a
+	 *			URL::DownloadTask). It is counted, but not subject to the per-host limit.
+	 *
+	 * \param	url	The URL being requested.
+	 */
+
+	void recordDetachedRequest(const URL& url);
+
+	/**
+	 * \fn	void FSHostLimiter::setMaxRequestsPerHost(int maxRequests);
+	 *
+	 * \brief	Sets the maximum number of requests open at the same time to a host
+	 *
+	 * \param	maxRequests	The maximum number of requests.
+	 */
+
+	void setMaxRequestsPerHost(int maxRequests);
+
+	/**
+	 * \fn	int FSHostLimiter::getMaxRequestsPerHost() const;
+	 *
+	 * \brief	Gets the maximum number of requests open at the same time to a host
+	 *
+	 * \returns	The maximum number of requests.
+	 */
+
+	int getMaxRequestsPerHost() const;
+
+	/**
+	 * \fn	HostStats FSHostLimiter::getHostStats(const String& host) const;
+	 *
+	 * \brief	Gets the counters of a host
+	 *
+	 * \param	host	The host, as returned by getHostFor().
+	 *
+	 * \returns	The counters of the host.
+	 */
+
+	HostStats getHostStats(const String& host) const;
+
+	/**
+	 * \fn	HostStats FSHostLimiter::getTotalStats() const;
+	 *
+	 * \brief	Gets the counters of all the hosts added together
+	 *
+	 * \returns	The total counters.
+	 */
+
+	HostStats getTotalStats() const;
+
+	/**
+	 * \fn	StringArray FSHostLimiter::getHosts() const;
+	 *
+	 * \brief	Gets the hosts the limiter has seen
+	 *
+	 * \returns	The hosts, as scheme and domain.
+	 */
+
+	StringArray getHosts() const;
+
+	/**
+	 * \fn	static String FSHostLimiter::getHostFor(const URL& url);
+	 *
+	 * \brief	Gets the key under which the requests to the server of a URL are counted
+	 *
+	 * \param	url	The URL.
+	 *
+	 * \returns	The scheme and domain of the URL.
+	 */
+
+	static String getHostFor(const URL& url);
+
+	/**
+	 * \fn	static FSHostLimiter& FSHostLimiter::getShared();
+	 *
+	 * \brief	Gets the limiter used by FSRequest and the download paths
+	 *
+	 * \returns	The shared limiter.
+	 */
+
+	static FSHostLimiter& getShared();
+
+private:
+	void release(const String& host);
+
+	/** \brief	The counters of each host */
+	std::map<String, HostStats> hosts;
+	/** \brief	Guards the host counters */
+	CriticalSection lock;
+	/** \brief	Signalled whenever a slot is released */
+	WaitableEvent slotReleased;
+	/** \brief	The maximum number of requests open at the same time to a host */
+	std::atomic<int> maxRequestsPerHost;
+
+	JUCE_DECLARE_NON_COPYABLE(FSHostLimiter)
+};
+
+/**
+ * \class	FSRateLimiter
+ *
+ * \brief	Client-side limiter for the requests made by FSRequest, so that bursts of searches
+ *			and lookups stay within the API quotas instead of being throttled by the server.
+ *			Each endpoint draws from a token bucket (endpoints without a budget of their own
+ *			share the default one). Responses with status 429 or 5xx are retried with jittered
+ *			exponential backoff, honouring the Retry-After header, and a 429 also pauses the
+ *			endpoint's bucket for everyone. Counters tell how often and for how long requests
+ *			were held back.
+ *
+ *			Waiting for tokens and backing off both sleep the thread making the request, so
+ *			synchronous FreesoundClient calls made on the message thread freeze the UI while
+ *			they are throttled; use the asynchronous calls there.
+ */
+
+class FSRateLimiter {
+public:
+
+	/**
+	 * \struct	Stats
+	 *
+	 * \brief	Counters of the limiter
+	 */
+
+	struct Stats {
+		/** \brief	Requests which went through the limiter, retries included */
+		int64 requests = 0;
+		/** \brief	Requests which had to wait for a token or for a pause to end */
+		int64 throttledRequests = 0;
+		/** \brief	Total time spent waiting for tokens or pauses, in milliseconds */
+		int64 throttledMilliseconds = 0;
+		/** \brief	Requests retried after a 429 or 5xx response */
+		int64 retries = 0;
+		/** \brief	Total time spent in backoff before retries, in milliseconds */
+		int64 backoffMilliseconds = 0;
+		/** \brief	Responses with status 429 */
+		int64 rateLimitedResponses = 0;
+		/** \brief	Responses with a 5xx status */
+		int64 serverErrorResponses = 0;
+		/** \brief	Requests which still failed after the last retry */
+		int64 failedAfterRetries = 0;
+		/** \brief	Requests refused because their endpoint was paused for longer than maxRetryAfterMs */
+		int64 refusedRequests = 0;
+	};
+
+	/**
+	 * \fn	FSRateLimiter::FSRateLimiter();
+	 *
+	 * \brief	Creates a limiter with the default budget of the API (60 requests per minute)
+	 */
+
+	FSRateLimiter();
+
+	/**
+	 * \fn	void FSRateLimiter::setBudget(const String& endpoint, double requestsPerMinute, int burst);
+	 *
+	 * \brief	Sets the budget of the URLs under the given endpoint. Endpoints are matched as
+	 *			in FSResponseCache::setTimeToLive(): against the start of the path after
+	 *			URIS::getBaseURL(), one segment at a time, with segments in angle brackets such as
+	 *			<sound_id> matching any segment. The most specific match wins, and URLs no
+	 *			endpoint matches use the default budget.
+	 *
+	 * \param	endpoint		 	The endpoint, e.g. URIS::TEXT_SEARCH or URIS::SOUND, or an empty string for the default budget.
+	 * \param	requestsPerMinute	The sustained number of requests per minute.
+	 * \param	burst			 	The number of requests which can be made at once after a quiet period.
+	 */
+
+	void setBudget(const String& endpoint, double requestsPerMinute, int burst);
+
+	/**
+	 * \fn	int64 FSRateLimiter::acquire(const URL& url);
+	 *
+	 * \brief	Waits until the budget of the URL's endpoint allows another request. This
+	 *			sleeps the calling thread, which should not be the message thread. When the
+	 *			endpoint is paused for longer than the longest Retry-After that is waited for
+	 *			(see setRetryPolicy()), e.g. after a 429 for a daily quota, it returns at once
+	 *			and the request should not be made.
+	 *
+	 * \param	url	The URL about to be requested.
+	 *
+	 * \returns	The time waited, in milliseconds, or -1 if the request is refused.
+	 */
+
+	int64 acquire(const URL& url);
+
+	/**
+	 * \fn	bool FSRateLimiter::shouldRetry(const URL& url, int statusCode, int attempt, const String& retryAfter, int& delayMs);
+	 *
+	 * \brief	Records a response and decides whether the request should be retried. After a 429
+	 *			the endpoint's bucket is paused for the returned delay, or for the Retry-After
+	 *			delay when that is too long to retry at all. acquire() refuses the requests
+	 *			made during such a long pause rather than waiting for it.
+	 *
+	 * \param 		   	url		  	The URL that was requested.
+	 * \param 		   	statusCode	The status of the response.
+	 * \param 		   	attempt   	The number of retries already made for this request.
+	 * \param 		   	retryAfter	The Retry-After header of the response, if any.
+	 * \param [out]	delayMs   	The time to wait before retrying.
+	 *
+	 * \returns	True if the request should be retried after delayMs.
+	 */
+
+	bool shouldRetry(const URL& url, int statusCode, int attempt, const String& retryAfter, int& delayMs);
+
+	/**
+	 * \fn	void FSRateLimiter::recordBackoff(int delayMs);
+	 *
+	 * \brief	Accounts for the time slept before a retry
+	 *
+	 * \param	delayMs	The time slept, in milliseconds.
+	 */
+
+	void recordBackoff(int delayMs);
+
+	/**
+	 * \fn	void FSRateLimiter::setRetryPolicy(int maxRetries, int baseBackoffMs = 500, int maxBackoffMs = 30000, int maxRetryAfterMs = 120000);
+	 *
+	 * \brief	Sets how failed requests are retried
+	 *
+	 * \param	maxRetries	   	The maximum number of retries of a request, 0 to never retry.
+	 * \param	baseBackoffMs  	(Optional) The backoff before the first retry, doubled for each of the next ones.
+	 * \param	maxBackoffMs   	(Optional) The maximum backoff the limiter picks by itself.
+	 * \param	maxRetryAfterMs	(Optional) The longest Retry-After that is waited for; requests asked
+	 *							to wait longer are not retried. A shorter one is always honoured in full.
+	 */
+
+	void setRetryPolicy(int maxRetries, int baseBackoffMs = 500, int maxBackoffMs = 30000, int maxRetryAfterMs = 120000);
+
+	/**
+	 * \fn	int FSRateLimiter::getMaxRetries() const;
+	 *
+	 * \brief	Gets the maximum number of retries of a request
+	 *
+	 * \returns	The maximum number of retries.
+	 */
+
+	int getMaxRetries() const;
+
+	/**
+	 * \fn	Stats FSRateLimiter::getStats() const;
+	 *
+	 * \brief	Gets the counters of the limiter
+	 *
+	 * \returns	The counters.
+	 */
+
+	Stats getStats() const;
+
+	/**
+	 * \fn	void FSRateLimiter::resetStats();
+	 *
+	 * \brief	Sets all the counters back to zero
+	 */
+
+	void resetStats();
+
+	/**
+	 * \fn	static int FSRateLimiter::parseRetryAfter(const String& retryAfter);
+	 *
+	 * \brief	Parses a Retry-After header, given either in seconds or as an HTTP date
+	 *
+	 * \param	retryAfter	The value of the header.
+	 *
+	 * \returns	The delay in milliseconds, -1 if the header is missing or invalid.
+	 */
+
+	static int parseRetryAfter(const String& retryAfter);
+
+	/**
+	 * \fn	static FSRateLimiter& FSRateLimiter::getShared();
+	 *
+	 * \brief	Gets the limiter used by FSRequest
+	 *
+	 * \returns	The shared rate limiter.
+	 */
+
+	static FSRateLimiter& getShared();
+
+private:
+	struct Bucket {
+		double capacity = 1.0;
+		double tokens = 1.0;
+		double tokensPerMs = 0.001;
+		int64 lastRefill = 0;
+		int64 pausedUntil = 0;
+	};
+
+	Bucket& getBucketFor(const URL& url);
+	static void refill(Bucket& bucket, int64 now);
+
+	/** \brief	The buckets, by endpoint */
+	std::map<String, Bucket> buckets;
+	/** \brief	The counters */
+	Stats stats;
+	/** \brief	The maximum number of retries of a request */
+	int maxRetries = 3;
+	/** \brief	The backoff before the first retry */
+	int baseBackoffMs = 500;
+	/** \brief	The maximum backoff */
+	int maxBackoffMs = 30000;
+	/** \brief	The longest Retry-After which is waited for */
+	int maxRetryAfterMs = 120000;
+	/** \brief	Source of the backoff jitter */
+	Random random;
+	/** \brief	Guards the buckets, the settings and the counters */
+	CriticalSection lock;
+
+	JUCE_DECLARE_NON_COPYABLE(FSRateLimiter)
+};
+
+/**
+ * \class	FSInFlightRequests
+ *
+ * \brief	Registry of the GET requests currently in flight, used by FSRequest to coalesce
+ *			identical concurrent requests (single-flight). The first caller performs the
+ *			request; the callers which ask for the same URL, with the same credentials, before
+ *			it finishes wait for it and are handed its response instead of opening
+ *			connections of their own. Without a response cache a flight only takes followers
+ *			until its response arrives, so the body is only copied in memory for requests
+ *			that actually wait for it.
+ */
+
+class FSInFlightRequests {
+public:
+
+	/**
+	 * \struct	Flight
+	 *
+	 * \brief	The shared outcome of a request in flight
+	 */
+
+	struct Flight {
+		/** \brief	The key the flight was joined with */
+		String key;
+		/** \brief	The number of callers waiting for the response */
+		int numFollowers = 0;
+		/** \brief	Signalled once the request finished */
+		WaitableEvent finished { true };
+		/** \brief	The status of the response */
+		int statusCode = -1;
+		/** \brief	The body of the response, if it was kept in memory */
+		MemoryBlock body;
+		/** \brief	True if body holds the response */
+		bool hasBody = false;
+		/** \brief	True if the response can be read from the response cache instead */
+		bool storedInCache = false;
+	};
+
+	/**
+	 * \fn	std::shared_ptr<Flight> FSInFlightRequests::join(const String& key, bool& isLeader);
+	 *
+	 * \brief	Joins the flight of a request, starting it if there is none
+	 *
+	 * \param 		   	key			The key of the request, its canonical URL and credentials.
+	 * \param [out]	isLeader	Set to true if the caller must perform the request and call finish().
+	 *
+	 * \returns	The flight of the request.
+	 */
+
+	std::shared_ptr<Flight> join(const String& key, bool& isLeader);
+
+	/**
+	 * \fn	void FSInFlightRequests::finish(const String& key, const std::shared_ptr<Flight>& flight);
+	 *
+	 * \brief	Publishes the outcome of a flight to its followers and removes it from the registry
+	 *
+	 * \param	key   	The key the flight was joined with.
+	 * \param	flight	The flight.
+	 */
+
+	void finish(const String& key, const std::shared_ptr<Flight>& flight);
+
+	/**
+	 * \fn	bool FSInFlightRequests::close(Flight& flight);
+	 *
+	 * \brief	Removes a flight from the registry, so that later identical requests start
+	 *			their own instead of joining it
+	 *
+	 * \param [in,out]	flight	The flight.
+	 *
+	 * \returns	True if any caller joined the flight and waits for its response.
+	 */
+
+	bool close(Flight& flight);
+
+	/**
+	 * \fn	void FSInFlightRequests::setEnabled(bool shouldBeEnabled);
+	 *
+	 * \brief	Turns the coalescing of identical requests on or off (it is on by default)
+	 *
+	 * \param	shouldBeEnabled	True to coalesce identical requests.
+	 */
+
+	void setEnabled(bool shouldBeEnabled);
+
+	/**
+	 * \fn	bool FSInFlightRequests::isEnabled() const;
+	 *
+	 * \brief	Query if identical requests are coalesced
+	 *
+	 * \returns	True if identical requests are coalesced.
+	 */
+
+	bool isEnabled() const;
+
+	/**
+	 * \fn	int64 FSInFlightRequests::getNumCoalesced() const;
+	 *
+	 * \brief	Gets the number of requests which were served by another request in flight
+	 *
+	 * \returns	The number of coalesced requests.
+	 */
+
+	int64 getNumCoalesced() const;
+
+	/**
+	 * \fn	int FSInFlightRequests::getNumInFlight() const;
+	 *
+	 * \brief	Gets the number of distinct requests currently in flight
+	 *
+	 * \returns	The number of requests in flight.
+	 */
+
+	int getNumInFlight() const;
+
+	/**
+	 * \fn	static FSInFlightRequests& FSInFlightRequests::getShared();
+	 *
+	 * \brief	Gets the registry used by FSRequest
+	 *
+	 * \returns	The shared registry.
+	 */
+
+	static FSInFlightRequests& getShared();
+
+private:
+	/** \brief	The flights, by request key */
+	std::map<String, std::shared_ptr<Flight>> flights;
+	/** \brief	The number of coalesced requests */
+	int64 numCoalesced = 0;
+	/** \brief	True if identical requests are coalesced */
+	std::atomic<bool> enabled { true };
+	/** \brief	Guards the flights and the counter */
+	CriticalSection lock;
+};
+
+/**
+ * \class	FSResponseCache
+ *
+ * \brief	On-disk cache for the responses of the GET requests made by FSRequest. Entries are
+ *			keyed by the canonical URL of the request (parameters sorted), expire after a
+ *			time to live which can be set per endpoint, and are revalidated with ETag and
+ *			Last-Modified when stale. The total size on disk is capped, evicting the least
+ *			recently used entries first.
+ */
+
+class FSResponseCache {
+public:
+
+	/**
+	 * \struct	Entry
+	 *
+	 * \brief	A cached response as returned by lookup()
+	 */
+
+	struct Entry {
+		/** \brief	True if the cache had a response for the key */
+		bool found = false;
+		/** \brief	True if the response is still within its time to live */
+		bool fresh = false;
+		/** \brief	The file holding the body of the response */
+		File file;
+		/** \brief	The ETag header of the response, if any */
+		String eTag;
+		/** \brief	The Last-Modified header of the response, if any */
+		String lastModified;
+	};
+
+	/**
+	 * \fn	FSResponseCache::FSResponseCache(const File& directory, int64 maxSizeBytes = 64 * 1024 * 1024);
+	 *
+	 * \brief	Creates a cache storing its entries in the given directory
+	 *
+	 * \param	directory   	The directory of the cache, created if needed.
+	 * \param	maxSizeBytes	(Optional) The maximum size of the cached responses on disk.
+	 */
+
+	FSResponseCache(const File& directory, int64 maxSizeBytes = 64 * 1024 * 1024);
+
+	/**
+	 * \fn	Entry FSResponseCache::lookup(const String& key);
+	 *
+	 * \brief	Looks a response up, marking it as recently used
+	 *
+	 * \param	key	The canonical URL of the request, see getKeyFor().
+	 *
+	 * \returns	The cached entry, with found set to false if there is none.
+	 */
+
+	Entry lookup(const String& key);
+
+	/**
+	 * \fn	void FSResponseCache::store(const String& key, const String& body, const String& eTag, const String& lastModified);
+	 *
+	 * \brief	Stores a response, evicting the least recently used ones if over the size cap.
+	 *			Responses of endpoints with a time to live of zero are not stored.
+	 *
+	 * \param	key			The canonical URL of the request.
+	 * \param	body		The body of the response.
+	 * \param	eTag		The ETag header of the response.
+	 * \param	lastModified	The Last-Modified header of the response.
+	 */
+
+	void store(const String& key, const String& body, const String& eTag, const String& lastModified);
+
+	/**
+	 * \fn	void FSResponseCache::storeFile(const String& key, const File& bodyFile, const String& eTag, const String& lastModified);
+	 *
+	 * \brief	Stores a response whose body was already written to a file, which is moved into
+	 *			the cache (or deleted if the endpoint is not cached). The file should be in the
+	 *			cache directory, see createTemporaryFile().
+	 *
+	 * \param	key			The canonical URL of the request.
+	 * \param	bodyFile	The file holding the body of the response.
+	 * \param	eTag		The ETag header of the response.
+	 * \param	lastModified	The Last-Modified header of the response.
+	 */
+
+	void storeFile(const String& key, const File& bodyFile, const String& eTag, const String& lastModified);
+
+	/**
+	 * \fn	File FSResponseCache::createTemporaryFile();
+	 *
+	 * \brief	Creates an empty file in the cache directory, to stream a response body into
+	 *
+	 * \returns	The temporary file.
+	 */
+
+	File createTemporaryFile();
+
+	/**
+	 * \fn	void FSResponseCache::markRevalidated(const String& key);
+	 *
+	 * \brief	Restarts the time to live of an entry the server confirmed as unchanged (304)
+	 *
+	 * \param	key	The canonical URL of the request.
+	 */
+
+	void markRevalidated(const String& key);
+
+	/**
+	 * \fn	void FSResponseCache::setDefaultTimeToLive(RelativeTime ttl);
+	 *
+	 * \brief	Sets the time to live of the endpoints without a specific one
+	 *
+	 * \param	ttl	The time to live.
+	 */
+
+	void setDefaultTimeToLive(RelativeTime ttl);
+
+	/**
+	 * \fn	void FSResponseCache::setTimeToLive(const String& endpoint, RelativeTime ttl);
+	 *
+	 * \brief	Sets the time to live of the URLs under the given endpoint. The endpoint is
+	 *			matched against the start of the path after URIS::getBaseURL(), one segment at a time,
+	 *			and a segment in angle brackets such as <sound_id> matches any segment. When
+	 *			several endpoints match a URL, the one with the most segments wins, then the
+	 *			one with the most literal segments.
+	 *
+	 * \param	endpoint	The endpoint, e.g. URIS::TEXT_SEARCH, URIS::USER_SOUNDS or "/sounds/".
+	 * \param	ttl			The time to live, zero to never cache the endpoint.
+	 */
+
+	void setTimeToLive(const String& endpoint, RelativeTime ttl);
+
+	/**
+	 * \fn	RelativeTime FSResponseCache::getTimeToLive(const String& key) const;
+	 *
+	 * \brief	Gets the time to live that applies to a request
+	 *
+	 * \param	key	The canonical URL of the request.
+	 *
+	 * \returns	The time to live.
+	 */
+
+	RelativeTime getTimeToLive(const String& key) const;
+
+	/**
+	 * \fn	void FSResponseCache::setMaxSize(int64 maxSizeBytes);
+	 *
+	 * \brief	Sets the maximum size of the cached responses on disk
+	 *
+	 * \param	maxSizeBytes	The maximum size in bytes.
+	 */
+
+	void setMaxSize(int64 maxSizeBytes);
+
+	/**
+	 * \fn	int64 FSResponseCache::getTotalSize();
+	 *
+	 * \brief	Gets the size of the cached responses on disk
+	 *
+	 * \returns	The size in bytes.
+	 */
+
+	int64 getTotalSize();
+
+	/**
+	 * \fn	void FSResponseCache::clear();
+	 *
+	 * \brief	Deletes all the cached responses
+	 */
+
+	void clear();
+
+	/**
+	 * \fn	File FSResponseCache::getDirectory() const;
+	 *
+	 * \brief	Gets the directory of the cache
+	 *
+	 * \returns	The directory of the cache.
+	 */
+
+	File getDirectory() const;
+
+	/**
+	 * \fn	static String FSResponseCache::getKeyFor(const URL& url);
+	 *
+	 * \brief	Builds the canonical form of a request URL, with its parameters sorted
+	 *
+	 * \param	url	The URL of the request, parameters included.
+	 *
+	 * \returns	The cache key of the request.
+	 */
+
+	static String getKeyFor(const URL& url);
+
+	/**
+	 * \fn	static std::shared_ptr<FSResponseCache> FSResponseCache::getDefault();
+	 *
+	 * \brief	Gets the cache used by the clients which were not given a specific one
+	 *
+	 * \returns	The default cache, nullptr if caching is disabled (the default).
+	 */
+
+	static std::shared_ptr<FSResponseCache> getDefault();
+
+	/**
+	 * \fn	static void FSResponseCache::setDefault(std::shared_ptr<FSResponseCache> cache);
+	 *
+	 * \brief	Sets the cache used by the clients which were not given a specific one
+	 *
+	 * \param	cache	The cache, or nullptr to disable caching.
+	 */
+
+	static void setDefault(std::shared_ptr<FSResponseCache> cache);
+
+private:
+	struct IndexEntry {
+		String key;
+		int64 storedAt = 0;
+		int64 lastUsed = 0;
+		int64 size = 0;
+		String eTag;
+		String lastModified;
+	};
+
+	void loadIndexIfNeeded();
+	void writeMetadata(const String& name, const IndexEntry& entry);
+	void removeEntry(const String& name);
+	void evictIfNeeded();
+	File getBodyFile(const String& name) const;
+	File getMetadataFile(const String& name) const;
+	static String getNameFor(const String& key);
+
+	/** \brief	The directory of the cache */
+	File directory;
+	/** \brief	The maximum size of the cached responses on disk */
+	int64 maxSize;
+	/** \brief	The size of the cached responses on disk */
+	int64 totalSize = 0;
+	/** \brief	The entries, by file name */
+	std::map<String, IndexEntry> index;
+	/** \brief	True once the index was read from disk */
+	bool indexLoaded = false;
+	/** \brief	The time to live of the endpoints without a specific one */
+	RelativeTime defaultTimeToLive;
+	/** \brief	The time to live of each endpoint */
+	StringPairArray endpointTimesToLive;
+	/** \brief	Guards the index and the files */
+	CriticalSection lock;
+
+	JUCE_DECLARE_NON_COPYABLE(FSResponseCache)
+};
+
+/**
+ * \class	FSJsonStreamReader
+ *
+ * \brief	Streaming JSON reader which pulls tokens straight from an InputStream, so that
+ *			large responses can be turned into objects as they arrive, without reading the
+ *			whole body into a string or building a var tree for it. Objects and arrays are
+ *			walked with nextKey() and nextElement(); values are read with readValue() or
+ *			skipped with skipValue(). Any syntax error puts the reader in a failed state in
+ *			which every call returns immediately.
+ */
+
+class FSJsonStreamReader {
+public:
+
+	/**
+	 * \fn	FSJsonStreamReader::FSJsonStreamReader(InputStream& source);
+	 *
+	 * \brief	Creates a reader for a stream, which must outlive the reader
+	 *
+	 * \param	source	The stream to read the JSON text from.
+	 */
+
+	FSJsonStreamReader(InputStream& source);
+
+	/**
+	 * \fn	bool FSJsonStreamReader::beginObject();
+	 *
+	 * \brief	Reads the opening brace of an object
+	 *
+	 * \returns	True if the next value is an object.
+	 */
+
+	bool beginObject();
+
+	/**
+	 * \fn	bool FSJsonStreamReader::nextKey(String& key);
+	 *
+	 * \brief	Reads the key of the next member of the current object, or its closing brace.
+	 *			The value of the member must then be read or skipped.
+	 *
+	 * \param [out]	key	The key of the member.
+	 *
+	 * \returns	True if there was another member, false at the end of the object.
+	 */
+
+	bool nextKey(String& key);
+
+	/**
+	 * \fn	bool FSJsonStreamReader::beginArray();
+	 *
+	 * \brief	Reads the opening bracket of an array
+	 *
+	 * \returns	True if the next value is an array.
+	 */
+
+	bool beginArray();
+
+	/**
+	 * \fn	bool FSJsonStreamReader::nextElement();
+	 *
+	 * \brief	Moves to the next element of the current array, or reads its closing bracket.
+	 *			The element must then be read or skipped.
+	 *
+	 * \returns	True if there was another element, false at the end of the array.
+	 */
+
+	bool nextElement();
+
+	/**
+	 * \fn	var FSJsonStreamReader::readValue();
+	 *
+	 * \brief	Reads the next value, building a var for it (and for its children, if any)
+	 *
+	 * \returns	The value.
+	 */
+
+	var readValue();
+
+	/**
+	 * \fn	String FSJsonStreamReader::readString();
+	 *
+	 * \brief	Reads the next value as a string, null values giving an empty string
+	 *
+	 * \returns	The string.
+	 */
+
+	String readString();
+
+	/**
+	 * \fn	String FSJsonStreamReader::readRawValue();
+	 *
+	 * \brief	Reads the next value as its JSON text, without decoding it
+	 *
+	 * \returns	The JSON text of the value, empty for null values.
+	 */
+
+	String readRawValue();
+
+	/**
+	 * \fn	void FSJsonStreamReader::skipValue();
+	 *
+	 * \brief	Skips the next value, without building anything for it
+	 */
+
+	void skipValue();
+
+	/**
+	 * \fn	bool FSJsonStreamReader::nextIsNull();
+	 *
+	 * \brief	Query if the next value is null
+	 *
+	 * \returns	True if the next value is null.
+	 */
+
+	bool nextIsNull();
+
+	/**
+	 * \fn	bool FSJsonStreamReader::hasFailed() const;
+	 *
+	 * \brief	Query if the text was not valid JSON
+	 *
+	 * \returns	True if a syntax error was found.
+	 */
+
+	bool hasFailed() const { return failed; }
+
+private:
+	int peekChar();
+	int nextChar();
+	void advance();
+	int peekToken();
+	bool expect(char expected);
+	void readStringInto(std::string& bytes, bool keep);
+	bool readEscape(uint32& codePoint);
+	void readLiteral(const char* literal);
+	var readNumber();
+	void fail() { failed = true; }
+
+	/** \brief	The stream the JSON text is read from */
+	InputStream& source;
+	/** \brief	The chunk of the stream being read */
+	HeapBlock<char> buffer;
+	/** \brief	The number of bytes in the buffer */
+	int bufferSize = 0;
+	/** \brief	The position of the next byte in the buffer */
+	int bufferPosition = 0;
+	/** \brief	True once a member or element was read in each open object or array */
+	Array<bool> hasPreviousItem;
+	/** \brief	True if a syntax error was found */
+	bool failed = false;
+	/** \brief	Receives the bytes consumed while readRawValue() runs */
+	std::string* capture = nullptr;
+
+	JUCE_DECLARE_NON_COPYABLE(FSJsonStreamReader)
+};
+
+/**
+ * \class	FSAsyncHandle
+ *
+ * \brief	Handle to the result of an asynchronous FreesoundClient call. The result can be
+ *			waited for with get(), or delivered to a callback registered with then(). A
+ *			cancelled handle never invokes its callbacks, and if its job has not started
+ *			yet the request is not sent at all. A call which failed with an exception
+ *			resolves with a default result and hasError() set.
+ */
+
+template <typename ResultType>
+class FSAsyncHandle {
+public:
+
+	/**
+	 * \typedef	std::function<void(ResultType)> ResultCallback
+	 *
+	 * \brief	Defines an alias representing the callback receiving the result
+	 */
+
+	typedef std::function<void(ResultType)> ResultCallback;
+
+	FSAsyncHandle()
+		: state(std::make_shared<State>())
+	{}
+
+	/**
+	 * \fn	FSAsyncHandle& FSAsyncHandle::then(ResultCallback callback, bool callOnMessageThread = true);
+	 *
+	 * \brief	Registers a callback for when the result is ready. If the result is already
+	 *			available the callback is dispatched straight away.
+	 *
+	 * \param	callback		   	The callback receiving the result.
+	 * \param	callOnMessageThread	(Optional) If true, the callback is posted to the message thread,
+	 *								otherwise it is called on the worker thread which produced the result.
+	 *
+	 * \returns	This handle, so that calls can be chained.
+	 */
+
+	FSAsyncHandle& then(ResultCallback callback, bool callOnMessageThread = true)
+	{
+		bool alreadyReady = false;
+		{
+			const ScopedLock sl(state->lock);
+			if (state->ready)
+				alreadyReady = true;
+			else
+				state->callbacks.push_back({ callback, callOnMessageThread });
+		}
+
+		if (alreadyReady)
+			dispatch(state, { callback, callOnMessageThread });
+
+		return *this;
+	}
+
+	/**
+	 * \fn	ResultType FSAsyncHandle::get() const;
+	 *
+	 * \brief	Blocks until the result is available and returns it
+	 *
+	 * \returns	The result of the call.
+	 */
+
+	ResultType get() const
+	{
+		state->finished.wait(-1);
+		const ScopedLock sl(state->lock);
+		return state->result;
+	}
+
+	/**
+	 * \fn	bool FSAsyncHandle::waitFor(int timeoutMs) const;
+	 *
+	 * \brief	Waits for the result for at most the given time
+	 *
+	 * \param	timeoutMs	The maximum time to wait in milliseconds, -1 to wait forever.
+	 *
+	 * \returns	True if the result is available.
+	 */
+
+	bool waitFor(int timeoutMs) const { return state->finished.wait(timeoutMs); }
+
+	/**
+	 * \fn	bool FSAsyncHandle::isReady() const;
+	 *
+	 * \brief	Queries if the result is available
+	 *
+	 * \returns	True if the call has finished.
+	 */
+
+	bool isReady() const
+	{
+		const ScopedLock sl(state->lock);
+		return state->ready;
+	}
+
+	/**
+	 * \fn	void FSAsyncHandle::cancel();
+	 *
+	 * \brief	Cancels the call. Pending callbacks are dropped and get() returns a default result.
+	 */
+
+	void cancel()
+	{
+		{
+			const ScopedLock sl(state->lock);
+			state->cancelled = true;
+			state->callbacks.clear();
+			if (state->ready)
+				return;
+			state->ready = true;
+		}
+		state->finished.signal();
+	}
+
+	/**
+	 * \fn	bool FSAsyncHandle::hasError() const;
+	 *
+	 * \brief	Queries if the call failed with an exception. The result is then a default one,
+	 *			which is also what the callbacks receive.
+	 *
+	 * \returns	True if the call failed.
+	 */
+
+	bool hasError() const
+	{
+		const ScopedLock sl(state->lock);
+		return state->failed;
+	}
+
+	/**
+	 * \fn	String FSAsyncHandle::getError() const;
+	 *
+	 * \brief	Gets the message of the exception the call failed with
+	 *
+	 * \returns	The error message, empty if the call did not fail.
+	 */
+
+	String getError() const
+	{
+		const ScopedLock sl(state->lock);
+		return state->error;
+	}
+
+	/**
+	 * \fn	bool FSAsyncHandle::isCancelled() const;
+	 *
+	 * \brief	Queries if the call was cancelled
+	 *
+	 * \returns	True if cancel() was called.
+	 */
+
+	bool isCancelled() const
+	{
+		const ScopedLock sl(state->lock);
+		return state->cancelled;
+	}
+
+	/**
+	 * \fn	void FSAsyncHandle::setResult(ResultType newResult);
+	 *
+	 * \brief	Stores the result of the call and fires the registered callbacks. Called by
+	 *			the worker which ran the request.
+	 *
+	 * \param	newResult	The result of the call.
+	 */
+
+	void setResult(ResultType newResult)
+	{
+		resolve(newResult, false, String());
+	}
+
+	/**
+	 * \fn	void FSAsyncHandle::setError(const String& message);
+	 *
+	 * \brief	Resolves the handle as failed, with a default result, and fires the registered
+	 *			callbacks. Called by the worker whose call threw.
+	 *
+	 * \param	message	What went wrong.
+	 */
+
+	void setError(const String& message)
+	{
+		resolve(ResultType{}, true, message);
+	}
+
+private:
+	void resolve(ResultType newResult, bool failed, const String& error)
+	{
+		std::vector<PendingCallback> toCall;
+		{
+			const ScopedLock sl(state->lock);
+			if (state->ready)
+				return;
+			state->result = newResult;
+			state->failed = failed;
+			state->error = error;
+			state->ready = true;
+			toCall.swap(state->callbacks);
+		}
+		state->finished.signal();
+
+		for (auto& pending : toCall)
+			dispatch(state, pending);
+	}
+
+	struct PendingCallback {
+		ResultCallback callback;
+		bool callOnMessageThread;
+	};
+
+	struct State {
+		CriticalSection lock;
+		WaitableEvent finished{ true };
+		ResultType result{};
+		bool ready = false;
+		bool cancelled = false;
+		bool failed = false;
+		String error;
+		std::vector<PendingCallback> callbacks;
+	};
+
+	static void dispatch(std::shared_ptr<State> s, PendingCallback pending)
+	{
+		if (pending.callback == nullptr)
+			return;
+
+		auto call = [s, cb = pending.callback]() {
+			ResultType value;
+			{
+				const ScopedLock sl(s->lock);
+				if (s->cancelled)
+					return;
+				value = s->result;
+			}
+			cb(value);
+		};
+
+		if (pending.callOnMessageThread && MessageManager::getInstanceWithoutCreating() != nullptr)
+			MessageManager::callAsync(call);
+		else
+			call();
+	}
+
+	std::shared_ptr<State> state;
+};
+
 /**
  * \class	FSList
  *
@@ -142,6 +1445,49 @@ public:
 
 	int getCount();
 
+	/**
+	 * \fn	int FSList::getPageSize() const;
+	 *
+	 * \brief	Gets the number of entries per page, as given by the page_size parameter of the
+	 *			neighbouring pages (15, the API default, if it was not set)
+	 *
+	 * \returns	The number of entries per page.
+	 */
+
+	int getPageSize() const;
+
+	/**
+	 * \fn	int FSList::getPageNumber() const;
+	 *
+	 * \brief	Gets the number of this page, starting at 1
+	 *
+	 * \returns	The page number.
+	 */
+
+	int getPageNumber() const;
+
+	/**
+	 * \fn	int FSList::getNumPages() const;
+	 *
+	 * \brief	Gets the number of pages of the complete list
+	 *
+	 * \returns	The number of pages.
+	 */
+
+	int getNumPages() const;
+
+	/**
+	 * \fn	String FSList::getPageURL(int page) const;
+	 *
+	 * \brief	Gets the URL of any page of the list, built from the URL of a neighbouring page
+	 *
+	 * \param	page	The page number, starting at 1.
+	 *
+	 * \returns	The URL of the page, empty if the list has a single page.
+	 */
+
+	String getPageURL(int page) const;
+
 };
 
 /**
@@ -160,8 +1506,6 @@ public:
 
 	/** \brief	Freesound website */
 	static String HOST;
-	/** \brief	The base URL for the requests*/
-	static String BASE;
 	/** \brief	The text search resource*/
 	static String TEXT_SEARCH;
 	/** \brief	The content search resource*/
@@ -261,6 +1605,44 @@ public:
 	 */
 
 	static URL uri(String uri, StringArray replacements = StringArray());
+
+	/**
+	 * \fn	static void URIS::setBaseURL(const String& newBase);
+	 *
+	 * \brief	Points every request built by uri() at a different server, for instance
+	 *			a local stand-in such as "http://127.0.0.1:8085/apiv2". An empty string
+	 *			restores the Freesound default. The initial value can also be set with
+	 *			the FREESOUND_API_BASE_URL environment variable.
+	 *
+	 * \param	newBase	The new base URL, without a trailing slash.
+	 */
+
+	static void setBaseURL(const String& newBase);
+
+	/**
+	 * \fn	static String URIS::getBaseURL();
+	 *
+	 * \brief	Gets the base URL currently used for the requests.
+	 *
+	 * \returns	The base URL.
+	 */
+
+	static String getBaseURL();
+
+	/**
+	 * \fn	static String URIS::getDefaultBaseURL();
+	 *
+	 * \brief	Gets the base URL of the public Freesound API.
+	 *
+	 * \returns	The default base URL.
+	 */
+
+	static String getDefaultBaseURL();
+
+private:
+
+	/** \brief	The base URL for the requests, only used through getBaseURL() and setBaseURL()*/
+	static String BASE;
 };
 
 /**
@@ -437,7 +1819,7 @@ public:
 	/** \brief	The bit depth of the sound */
 	int bitdepth;
 	/** \brief	The duration of the sound in seconds */
-	int duration;
+	double duration = 0.0;
 	/** \brief	The samplerate of the sound */
 	int samplerate;
 	/** \brief	The username of the uploader of the sound */
@@ -471,62 +1853,243 @@ public:
 	/** \brief	Dictionary containing requested descriptors information according to the
 				descriptors request parameter */
 	var analysis;
-	/** \brief	URI pointing to the complete analysis results of the sound */
-	URL analysisStats;
-	/** \brief	The URI for retrieving a JSON file with analysis information for each frame of the sound */
-	URL analysisFrames;
-	/** \brief	Dictionary containing the results of the AudioCommons analysis for the given sound */
+	/** \brief	URI pointing to the complete analysis results of the sound */
+	URL analysisStats;
+	/** \brief	The URI for retrieving a JSON file with analysis information for each frame of the sound */
+	URL analysisFrames;
+	/** \brief	Dictionary containing the results of the AudioCommons analysis for the given sound */
+	var acAnalysis;
+
+	/**
+	 * \fn	FSSound::FSSound();
+	 *
+	 * \brief	Default constructor, creates an empty FSSound object
+	 *
+	 * \author	Antonio
+	 * \date	09/07/2019
+	 */
+
+	FSSound();
+
+	/**
+	 * \fn	FSSound::FSSound(var sound);
+	 *
+	 * \brief	Constructor from the response of a sound instance request
+	 *
+	 * \author	Antonio
+	 * \date	09/07/2019
+	 *
+	 * \param	sound	The response of a sound instance request
+	 */
+
+	FSSound(var sound);
+
+	/**
+	 * \fn	URL FSSound::getDownload();
+	 *
+	 * \brief	Gets the sound download URL
+	 *
+	 * \author	Antonio
+	 * \date	09/07/2019
+	 *
+	 * \returns	The sound download URL.
+	 */
+
+	URL getDownload();
+
+    /**
+     * \fn    URL FSSound::getOGGPreviewURL();
+     *
+     * \brief    Gets the sound the URL of the OGG preview of a sound
+     *
+     * \author    Frederic
+     * \date    12/09/2019
+     *
+     * \returns    The OGG preview URL.
+     */
+
+    URL getOGGPreviewURL();
+};
+
+/**
+ * \class	FSCompactSound
+ *
+ * \brief	Compact representation of a sound, meant for the large result arrays of searches.
+ *			The id is stored as an integer, the license, username and format are interned
+ *			in the global StringPool and the API URLs are derived from the id when asked
+ *			for. The previews, images and analysis are decoded once, when the record is
+ *			built. Use toFSSound() to get the full FSSound of a record.
+ */
+
+class FSCompactSound {
+public:
+	/** \brief	The sound’s unique identifier */
+	int id = 0;
+	/** \brief	The name user gave to the sound */
+	String name;
+	/** \brief	An array of tags the user gave to the sound */
+	StringArray tags;
+	/** \brief	The description the user gave to the sound */
+	String description;
+	/** \brief	Latitude and longitude of the geotag separated by spaces */
+	String geotag;
+	/** \brief	The date when the sound was uploaded */
+	String created;
+	/** \brief	The license under which the sound is available to you, interned */
+	String license;
+	/** \brief	The type of sound (wav, aif, aiff, mp3, m4a or flac), interned */
+	String format;
+	/** \brief	The username of the uploader of the sound, interned */
+	String username;
+	/** \brief	The duration of the sound in seconds */
+	float duration = 0.0f;
+	/** \brief	The average rating of the sound */
+	float avgRating = 0.0f;
+	/** \brief	The size of the file in bytes */
+	int filesize = 0;
+	/** \brief	The bit rate of the sound in kbps */
+	int bitrate = 0;
+	/** \brief	The samplerate of the sound */
+	int samplerate = 0;
+	/** \brief	The number of times the sound was downloaded */
+	int numDownloads = 0;
+	/** \brief	The number of times the sound was rated */
+	int numRatings = 0;
+	/** \brief	The number of comments */
+	int numComments = 0;
+	/** \brief	The identifier of the pack the sound belongs to, 0 if none */
+	int packId = 0;
+	/** \brief	The number of channels */
+	int16 channels = 0;
+	/** \brief	The bit depth of the sound */
+	int16 bitdepth = 0;
+	/** \brief	The previews dictionary */
+	var previews;
+	/** \brief	The images dictionary */
+	var images;
+	/** \brief	The analysis dictionary */
+	var analysis;
+	/** \brief	The AudioCommons analysis dictionary */
 	var acAnalysis;
 
 	/**
-	 * \fn	FSSound::FSSound();
+	 * \fn	FSCompactSound::FSCompactSound();
 	 *
-	 * \brief	Default constructor, creates an empty FSSound object
+	 * \brief	Empty constructor
+	 */
+
+	FSCompactSound();
+
+	/**
+	 * \fn	FSCompactSound::FSCompactSound(var sound);
 	 *
-	 * \author	Antonio
-	 * \date	09/07/2019
+	 * \brief	Builds a compact record from the response of the API
+	 *
+	 * \param	sound	The sound as returned by the API.
 	 */
 
-	FSSound();
+	explicit FSCompactSound(var sound);
 
 	/**
-	 * \fn	FSSound::FSSound(var sound);
+	 * \fn	FSCompactSound::FSCompactSound(const FSSound& sound);
 	 *
-	 * \brief	Constructor from the response of a sound instance request
+	 * \brief	Builds a compact record from a full sound
 	 *
-	 * \author	Antonio
-	 * \date	09/07/2019
+	 * \param	sound	The sound.
+	 */
+
+	explicit FSCompactSound(const FSSound& sound);
+
+	/**
+	 * \fn	FSSound FSCompactSound::toFSSound() const;
 	 *
-	 * \param	sound	The response of a sound instance request
+	 * \brief	Expands this record into a full FSSound
+	 *
+	 * \returns	The sound.
 	 */
 
-	FSSound(var sound);
+	FSSound toFSSound() const;
 
 	/**
-	 * \fn	URL FSSound::getDownload();
+	 * \fn	String FSCompactSound::getIDString() const;
 	 *
-	 * \brief	Gets the sound download URL
+	 * \brief	Gets the identifier as a string, as used by FSSound
 	 *
-	 * \author	Antonio
-	 * \date	09/07/2019
+	 * \returns	The identifier.
+	 */
+
+	String getIDString() const;
+
+	/**
+	 * \fn	URL FSCompactSound::getURL() const;
 	 *
-	 * \returns	The sound download URL.
+	 * \brief	Gets the URI for this sound on the Freesound website
+	 *
+	 * \returns	The URL of the sound page.
 	 */
 
-	URL getDownload();
+	URL getURL() const;
 
-    /**
-     * \fn    URL FSSound::getOGGPreviewURL();
-     *
-     * \brief    Gets the sound the URL of the OGG preview of a sound
-     *
-     * \author    Frederic
-     * \date    12/09/2019
-     *
-     * \returns    The OGG preview URL.
-     */
+	/**
+	 * \fn	URL FSCompactSound::getDownload() const;
+	 *
+	 * \brief	Gets the URI for downloading the original sound
+	 *
+	 * \returns	The download URL.
+	 */
 
-    URL getOGGPreviewURL();
+	URL getDownload() const;
+
+	/**
+	 * \fn	URL FSCompactSound::getResourceURL(const String& resource) const;
+	 *
+	 * \brief	Gets the URI of one of the API resources of this sound
+	 *
+	 * \param	resource	The resource, e.g. URIS::SIMILAR_SOUNDS or URIS::COMMENTS.
+	 *
+	 * \returns	The URL of the resource for this sound.
+	 */
+
+	URL getResourceURL(const String& resource) const;
+
+	/**
+	 * \fn	URL FSCompactSound::getOGGPreviewURL() const;
+	 *
+	 * \brief	Gets the URL of the high quality OGG preview
+	 *
+	 * \returns	The URL of the preview, empty if the previews were not requested.
+	 */
+
+	URL getOGGPreviewURL() const;
+
+	/**
+	 * \fn	var FSCompactSound::getPreviews() const;
+	 *
+	 * \brief	Gets the previews dictionary, shared with the record rather than copied
+	 *
+	 * \returns	The previews dictionary.
+	 */
+
+	var getPreviews() const;
+
+	/** \brief	Gets the images dictionary, see getPreviews() */
+	var getImages() const;
+	/** \brief	Gets the analysis dictionary, see getPreviews() */
+	var getAnalysis() const;
+	/** \brief	Gets the AudioCommons analysis dictionary, see getPreviews() */
+	var getAcAnalysis() const;
+
+	/**
+	 * \fn	static String FSCompactSound::intern(const String& text);
+	 *
+	 * \brief	Returns the pooled instance of a string, so that equal strings share storage
+	 *
+	 * \param	text	The string.
+	 *
+	 * \returns	The interned string.
+	 */
+
+	static String intern(const String& text);
 };
 
 /**
@@ -555,6 +2118,38 @@ public:
 	 */
 
 	Array<FSSound> toArrayOfSounds();
+
+	/**
+	 * \fn	Array<FSCompactSound> SoundList::toArrayOfCompactSounds();
+	 *
+	 * \brief	Gets the sounds of this list as compact records. For lists built by
+	 *			fromStream() this does not expand anything, so it is the cheapest way of
+	 *			going through large result pages.
+	 *
+	 * \returns	The sounds of the list as an array of FSCompactSound.
+	 */
+
+	Array<FSCompactSound> toArrayOfCompactSounds();
+
+	/**
+	 * \fn	static SoundList SoundList::fromStream(InputStream& stream, bool* parsedOk = nullptr);
+	 *
+	 * \brief	Parses a sound list response while it is read from a stream, building compact
+	 *			sound records directly instead of going through a var tree. The results of
+	 *			such a list are only available through toArrayOfSounds() and
+	 *			toArrayOfCompactSounds(), getResults() returns an empty var.
+	 *
+	 * \param 		   	stream  	The stream holding the JSON response.
+	 * \param [out]	parsedOk	(Optional) Set to false if the response was not valid JSON.
+	 *
+	 * \returns	The sound list.
+	 */
+
+	static SoundList fromStream(InputStream& stream, bool* parsedOk = nullptr);
+
+private:
+	/** \brief	The sounds built by fromStream(), shared between the copies of the list */
+	std::shared_ptr<const Array<FSCompactSound>> parsedSounds;
 };
 
 /**
@@ -787,6 +2382,32 @@ public:
 
 	SoundList fetchPreviousPage(SoundList fslist);
 
+	/**
+	 * \fn	FSList FreesoundClient::fetchPage(FSList fslist, int page);
+	 *
+	 * \brief	Fetches any page of the same query as the given FSList
+	 *
+	 * \param	fslist	A page of the list.
+	 * \param	page  	The number of the page to fetch, starting at 1.
+	 *
+	 * \returns	The requested page, empty if it could not be fetched.
+	 */
+
+	FSList fetchPage(FSList fslist, int page);
+
+	/**
+	 * \fn	SoundList FreesoundClient::fetchPage(SoundList fslist, int page);
+	 *
+	 * \brief	Fetches any page of the same query as the given SoundList
+	 *
+	 * \param	fslist	A page of the list.
+	 * \param	page  	The number of the page to fetch, starting at 1.
+	 *
+	 * \returns	The requested page, empty if it could not be fetched.
+	 */
+
+	SoundList fetchPage(SoundList fslist, int page);
+
 	/**
 	 * \fn	FSSound FreesoundClient::getSound(String id);
 	 *
@@ -803,6 +2424,23 @@ public:
 
 	FSSound getSound(String id, String fields = String());
 
+	/**
+	 * \fn	Array<FSSound> FreesoundClient::getSounds(StringArray ids, String fields = String(), int maxIdsPerRequest = 100, int maxParallelRequests = 4);
+	 *
+	 * \brief	Gets many sounds from their ids in as few requests as possible. The ids are
+	 *			resolved with text searches filtered by "id:(a OR b ...)", split in chunks
+	 *			which are requested in parallel.
+	 *
+	 * \param	ids				   	The sounds' unique identifiers, duplicates are only requested once.
+	 * \param	fields			   	(Optional) Indicates which sound properties should be included, all of them by default.
+	 * \param	maxIdsPerRequest   	(Optional) The number of ids resolved by each request, at most 150 (the API page size limit).
+	 * \param	maxParallelRequests	(Optional) The number of requests run at the same time.
+	 *
+	 * \returns	The sounds in the order of the ids. Sounds which could not be resolved have an empty id.
+	 */
+
+	Array<FSSound> getSounds(StringArray ids, String fields = String(), int maxIdsPerRequest = 100, int maxParallelRequests = 4);
+
 	/**
 	 * \fn	var FreesoundClient::getSoundAnalysis(String id, String descriptors = String(), int normalized = 0);
 	 *
@@ -1197,7 +2835,379 @@ public:
 
 	String getClientID();
 
+	/**
+	 * \fn	void FreesoundClient::setWorkerPool(std::shared_ptr<FSWorkerPool> pool);
+	 *
+	 * \brief	Sets the worker pool on which the asynchronous calls of this client are run
+	 *
+	 * \param	pool	The worker pool, or nullptr to go back to the default pool.
+	 */
+
+	void setWorkerPool(std::shared_ptr<FSWorkerPool> pool);
+
+	/**
+	 * \fn	std::shared_ptr<FSWorkerPool> FreesoundClient::getWorkerPool();
+	 *
+	 * \brief	Gets the worker pool used for the asynchronous calls
+	 *
+	 * \returns	The worker pool of this client.
+	 */
+
+	std::shared_ptr<FSWorkerPool> getWorkerPool();
+
+	/**
+	 * \fn	void FreesoundClient::setResponseCache(std::shared_ptr<FSResponseCache> cache);
+	 *
+	 * \brief	Sets the cache used for the GET requests of this client
+	 *
+	 * \param	cache	The response cache, or nullptr to go back to the default cache.
+	 */
+
+	void setResponseCache(std::shared_ptr<FSResponseCache> cache);
+
+	/**
+	 * \fn	std::shared_ptr<FSResponseCache> FreesoundClient::getResponseCache();
+	 *
+	 * \brief	Gets the cache used for the GET requests of this client
+	 *
+	 * \returns	The response cache, nullptr if responses are not cached.
+	 */
+
+	std::shared_ptr<FSResponseCache> getResponseCache();
+
+	/*
+	 * Asynchronous variants of the calls above. They take the same arguments as their
+	 * blocking counterparts, run the request on the client's worker pool and return a
+	 * handle to the result (see FSAsyncHandle). The client is copied into the job, so the
+	 * handle stays valid even if this object is destroyed before the request finishes.
+	 */
+
+	/** \brief	Asynchronous variant of textSearch() */
+	FSAsyncHandle<SoundList> textSearchAsync(String query, String filter=String(), String sort="score", int groupByPack=0, int page=-1, int pageSize=-1, String fields = String(), String descriptors = String(), int normalized=0);
+	/** \brief	Asynchronous variant of contentSearch() */
+	FSAsyncHandle<SoundList> contentSearchAsync(String target, String descriptorsFilter=String(), int page = -1, int pageSize = -1, String fields = String(), String descriptors = String(), int normalized = 0);
+	/** \brief	Asynchronous variant of fetchNextPage(FSList) */
+	FSAsyncHandle<FSList> fetchNextPageAsync(FSList fslist);
+	/** \brief	Asynchronous variant of fetchPreviousPage(FSList) */
+	FSAsyncHandle<FSList> fetchPreviousPageAsync(FSList fslist);
+	/** \brief	Asynchronous variant of fetchNextPage(SoundList) */
+	FSAsyncHandle<SoundList> fetchNextPageAsync(SoundList fslist);
+	/** \brief	Asynchronous variant of fetchPreviousPage(SoundList) */
+	FSAsyncHandle<SoundList> fetchPreviousPageAsync(SoundList fslist);
+	/** \brief	Asynchronous variant of fetchPage() */
+	FSAsyncHandle<FSList> fetchPageAsync(FSList fslist, int page);
+	/** \brief	Asynchronous variant of fetchPage() */
+	FSAsyncHandle<SoundList> fetchPageAsync(SoundList fslist, int page);
+	/** \brief	Asynchronous variant of getSound() */
+	FSAsyncHandle<FSSound> getSoundAsync(String id, String fields = String());
+	/** \brief	Asynchronous variant of getSounds() */
+	FSAsyncHandle<Array<FSSound>> getSoundsAsync(StringArray ids, String fields = String(), int maxIdsPerRequest = 100, int maxParallelRequests = 4);
+	/** \brief	Asynchronous variant of getSoundAnalysis() */
+	FSAsyncHandle<var> getSoundAnalysisAsync(String id, String descriptors = String(), int normalized = 0);
+	/** \brief	Asynchronous variant of getSimilarSounds() */
+	FSAsyncHandle<SoundList> getSimilarSoundsAsync(String id, String descriptorsFilter = String(), int page = -1, int pageSize = -1, String fields = String(), String descriptors = String(), int normalized = 0);
+	/** \brief	Asynchronous variant of uploadSound(), the result is the id of the uploaded sound */
+	FSAsyncHandle<int> uploadSoundAsync(const File &fileToUpload, String tags, String description, String name = String(), String license = "Creative Commons 0", String pack = String(), String geotag = String());
+	/** \brief	Asynchronous variant of describeSound() */
+	FSAsyncHandle<int> describeSoundAsync(String uploadFilename, String description, String license, String name = String(), String tags = String(), String pack = String(), String geotag = String());
+	/** \brief	Asynchronous variant of pendingUploads() */
+	FSAsyncHandle<var> pendingUploadsAsync();
+	/** \brief	Asynchronous variant of editSoundDescription(), the result is always true once the request finished */
+	FSAsyncHandle<bool> editSoundDescriptionAsync(String id, String name = String(), String tags = String(), String description = String(), String license = String(), String pack = String(), String geotag = String());
+	/** \brief	Asynchronous variant of bookmarkSound(), the result is always true once the request finished */
+	FSAsyncHandle<bool> bookmarkSoundAsync(String id, String name = String(), String category = String());
+	/** \brief	Asynchronous variant of rateSound(), the result is always true once the request finished */
+	FSAsyncHandle<bool> rateSoundAsync(String id, int rating);
+	/** \brief	Asynchronous variant of commentSound(), the result is always true once the request finished */
+	FSAsyncHandle<bool> commentSoundAsync(String id, String comment);
+	/** \brief	Asynchronous variant of getUser() */
+	FSAsyncHandle<FSUser> getUserAsync(String user);
+	/** \brief	Asynchronous variant of getUserSounds() */
+	FSAsyncHandle<SoundList> getUserSoundsAsync(String username, String descriptorsFilter = String(), int page = -1, int pageSize = -1, String fields = String(), String descriptors = String(), int normalized = 0);
+	/** \brief	Asynchronous variant of getUserBookmarkCategories() */
+	FSAsyncHandle<FSList> getUserBookmarkCategoriesAsync(String username);
+	/** \brief	Asynchronous variant of getUserBookmarkCategoriesSounds() */
+	FSAsyncHandle<FSList> getUserBookmarkCategoriesSoundsAsync(String username, String bookmarkCategory);
+	/** \brief	Asynchronous variant of getUserPacks() */
+	FSAsyncHandle<FSList> getUserPacksAsync(String username);
+	/** \brief	Asynchronous variant of getPack() */
+	FSAsyncHandle<FSPack> getPackAsync(String id);
+	/** \brief	Asynchronous variant of getPackSounds() */
+	FSAsyncHandle<SoundList> getPackSoundsAsync(String id, String descriptorsFilter = String(), int page = -1, int pageSize = -1, String fields = String(), String descriptors = String(), int normalized = 0);
+	/** \brief	Asynchronous variant of getMe() */
+	FSAsyncHandle<FSUser> getMeAsync();
+
+protected:
+
+	/**
+	 * \fn	SoundList FreesoundClient::requestSoundList(URL url, StringPairArray params = StringPairArray());
+	 *
+	 * \brief	Makes a GET request returning a sound list, parsing the response as it streams in
+	 *
+	 * \param	url   	The URL of the request.
+	 * \param	params	(Optional) The parameters of the request.
+	 *
+	 * \returns	The sound list, empty if the request failed.
+	 */
+
+	SoundList requestSoundList(URL url, StringPairArray params = StringPairArray());
+
+	/**
+	 * \fn	template <typename ResultType> FSAsyncHandle<ResultType> FreesoundClient::runAsync(std::function<ResultType(FreesoundClient&)> call);
+	 *
+	 * \brief	Runs a blocking call on a copy of this client in the worker pool
+	 *
+	 * \param	call	The blocking call to run.
+	 *
+	 * \returns	The handle to the result of the call.
+	 */
+
+	template <typename ResultType>
+	FSAsyncHandle<ResultType> runAsync(std::function<ResultType(FreesoundClient&)> call)
+	{
+		FSAsyncHandle<ResultType> handle;
+		auto pool = getWorkerPool();
+
+		// The queued job must not keep its own pool alive, or the pool could end up
+		// being destroyed from one of its worker threads
+		FreesoundClient clientCopy(*this);
+		clientCopy.workerPool = nullptr;
+
+		pool->submit([handle, clientCopy, call]() mutable {
+			if (handle.isCancelled())
+				return;
+
+			// A call which throws still resolves its handle, as failed, so that get() and
+			// the callbacks are never left waiting
+			ResultType result{};
+			try
+			{
+				result = call(clientCopy);
+			}
+			catch (const std::exception& e)
+			{
+				handle.setError(String(e.what()).isNotEmpty() ? String(e.what()) : String("Unknown error"));
+				return;
+			}
+			catch (...)
+			{
+				handle.setError("Unknown error");
+				return;
+			}
+			handle.setResult(result);
+		},
+		// Dropped by a pool that went away before running it
+		[handle]() mutable { handle.cancel(); });
+
+		return handle;
+	}
+
+private:
+	/** \brief	The pool running the asynchronous calls, nullptr for the default one */
+	std::shared_ptr<FSWorkerPool> workerPool;
+	/** \brief	The cache for the GET requests, nullptr for the default one */
+	std::shared_ptr<FSResponseCache> responseCache;
+};
+
+/**
+ * \class	FSPageIterator
+ *
+ * \brief	Lazy iterator over the pages of a paginated response (FSList or SoundList). While
+ *			the consumer works on the page returned by next(), the following pages, up to the
+ *			prefetch depth, are already being fetched on the client's worker pool. Pages are
+ *			requested by number, so the prefetched ones are fetched in parallel. Iterating can
+ *			be stopped early with cancel(), which also drops the pending prefetches. The
+ *			iterator itself must be used from a single thread.
+ *
+ *			It can be used in a range-based for loop:
+ *			\code
+ *			for (auto& page : FSPageIterator<SoundList>(client, client.getUserSounds("user")))
+ *				process(page.toArrayOfSounds());
+ *			\endcode
+ */
+
+template <typename ListType>
+class FSPageIterator {
+public:
+
+	/**
+	 * \fn	FSPageIterator::FSPageIterator(FreesoundClient clientToUse, ListType firstPage, int prefetchDepth = 2);
+	 *
+	 * \brief	Creates an iterator starting at the given page, and starts prefetching the next ones
+	 *
+	 * \param	clientToUse  	The client used to fetch the pages.
+	 * \param	firstPage	 	The first page to return, usually the result of a search.
+	 * \param	prefetchDepth	(Optional) The number of pages fetched ahead of the consumer, 0 to fetch on demand.
+	 */
+
+	FSPageIterator(FreesoundClient clientToUse, ListType firstPage, int prefetchDepth = 2)
+		: client(clientToUse),
+		first(firstPage),
+		nextPageNumber(firstPage.getPageNumber()),
+		lastPageNumber(jmax(firstPage.getPageNumber(), firstPage.getNumPages())),
+		depth(jmax(0, prefetchDepth))
+	{
+		prefetch(nextPageNumber + 1);
+	}
+
+	~FSPageIterator()
+	{
+		cancel();
+	}
+
+	/**
+	 * \fn	bool FSPageIterator::hasNext() const;
+	 *
+	 * \brief	Query if there are pages left
+	 *
+	 * \returns	True if next() will return another page.
+	 */
+
+	bool hasNext() const
+	{
+		return !cancelled && nextPageNumber <= lastPageNumber;
+	}
+
+	/**
+	 * \fn	ListType FSPageIterator::next();
+	 *
+	 * \brief	Returns the next page, waiting for it if it was not fetched yet
+	 *
+	 * \returns	The next page, or an empty list if there are no pages left.
+	 */
+
+	ListType next()
+	{
+		if (!hasNext())
+			return ListType();
+
+		const int page = nextPageNumber++;
+		ListType result = first;
+
+		if (page != first.getPageNumber())
+		{
+			auto pending = requests.find(page);
+			if (pending == requests.end())
+				pending = requests.emplace(page, client.fetchPageAsync(first, page)).first;
+			result = pending->second.get();
+			requests.erase(pending);
+		}
+
+		prefetch(nextPageNumber);
+		return result;
+	}
+
+	/**
+	 * \fn	void FSPageIterator::cancel();
+	 *
+	 * \brief	Stops the iteration, cancelling the prefetches which did not start yet
+	 */
+
+	void cancel()
+	{
+		cancelled = true;
+		for (auto& request : requests)
+			request.second.cancel();
+		requests.clear();
+	}
+
+	/**
+	 * \fn	bool FSPageIterator::isCancelled() const;
+	 *
+	 * \brief	Query if the iteration was cancelled
+	 *
+	 * \returns	True if cancel() was called.
+	 */
+
+	bool isCancelled() const { return cancelled; }
+
+	/**
+	 * \fn	void FSPageIterator::setPrefetchDepth(int prefetchDepth);
+	 *
+	 * \brief	Sets the number of pages fetched ahead of the consumer
+	 *
+	 * \param	prefetchDepth	The number of pages, 0 to fetch on demand.
+	 */
+
+	void setPrefetchDepth(int prefetchDepth)
+	{
+		depth = jmax(0, prefetchDepth);
+		prefetch(nextPageNumber);
+	}
+
+	/**
+	 * \fn	int FSPageIterator::getPrefetchDepth() const;
+	 *
+	 * \brief	Gets the number of pages fetched ahead of the consumer
+	 *
+	 * \returns	The prefetch depth.
+	 */
+
+	int getPrefetchDepth() const { return depth; }
+
+	/**
+	 * \fn	int FSPageIterator::getNumPages() const;
+	 *
+	 * \brief	Gets the number of the last page of the list
+	 *
+	 * \returns	The number of pages.
+	 */
+
+	int getNumPages() const { return lastPageNumber; }
+
+	/** \brief	Input iterator for range-based for loops, see begin() */
+	class Iterator {
+	public:
+		Iterator(FSPageIterator* ownerToUse) : owner(ownerToUse) { advance(); }
+
+		ListType& operator*() { return page; }
+		Iterator& operator++() { advance(); return *this; }
+		bool operator!=(const Iterator& other) const { return owner != other.owner; }
+
+	private:
+		void advance()
+		{
+			if (owner != nullptr && owner->hasNext())
+				page = owner->next();
+			else
+				owner = nullptr;
+		}
+
+		FSPageIterator* owner;
+		ListType page;
+	};
 
+	/** \brief	Starts a range-based for loop over the remaining pages */
+	Iterator begin() { return Iterator(this); }
+	/** \brief	The end of a range-based for loop */
+	Iterator end() { return Iterator(nullptr); }
+
+private:
+	void prefetch(int fromPage)
+	{
+		if (cancelled)
+			return;
+		for (int page = fromPage; page < fromPage + depth && page <= lastPageNumber; ++page)
+			if (page != first.getPageNumber() && requests.find(page) == requests.end())
+				requests.emplace(page, client.fetchPageAsync(first, page));
+	}
+
+	/** \brief	The client used to fetch the pages */
+	FreesoundClient client;
+	/** \brief	The page the iteration started at, also used to build the URLs of the others */
+	ListType first;
+	/** \brief	The number of the page returned by the next call to next() */
+	int nextPageNumber;
+	/** \brief	The number of the last page */
+	int lastPageNumber;
+	/** \brief	The number of pages fetched ahead of the consumer */
+	int depth;
+	/** \brief	True once cancel() was called */
+	bool cancelled = false;
+	/** \brief	The pages being fetched, by page number */
+	std::map<int, FSAsyncHandle<ListType>> requests;
+
+	JUCE_DECLARE_NON_COPYABLE(FSPageIterator)
 };
 
 /**
@@ -1334,10 +3344,31 @@ public:
 
 	Response request(StringPairArray params = StringPairArray(), String data = String(), bool postLikeRequest = true);
 
+	/**
+	 * \fn	int FSRequest::requestStream(std::function<bool(InputStream&, int)> consumer, StringPairArray params = StringPairArray(), String data = String(), bool postLikeRequest = true);
+	 *
+	 * \brief	Make a request to FreesoundAPI, handing the response body to the consumer as a
+	 *			stream instead of reading it into memory. Cached responses are streamed from
+	 *			disk, and responses from the network are written to the cache as they are read.
+	 *
+	 * \param	consumer	   	Reads the body, given the stream and the status code. It returns
+	 *							false if the body could not be used, so that it is not cached.
+	 * \param	params		   	(Optional) The parameters for the request.
+	 * \param	data		   	(Optional) The data if any.
+	 * \param	postLikeRequest	(Optional) If a POST like request is desired.
+	 *
+	 * \returns The status code of the response, -1 if no response was received.
+	 */
+
+	int requestStream(std::function<bool(InputStream&, int)> consumer, StringPairArray params = StringPairArray(), String data = String(), bool postLikeRequest = true);
+
 private:
+	/** \brief	Performs the request for requestStream(), publishing the response to the flight's followers if there is a flight */
+	int performRequest(std::function<bool(InputStream&, int)> consumer, StringPairArray params, String data, bool postLikeRequest, FSInFlightRequests::Flight* flight);
+
 	/** \brief	The URI of the rrequest */
 	URL uri;
-	/** \brief	The client used*/
-	FreesoundClient& client;
+	/** \brief	The client used, copied so that the request can outlive the caller's client */
+	FreesoundClient client;
 };
 
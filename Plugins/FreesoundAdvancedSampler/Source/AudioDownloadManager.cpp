@@ -6,186 +6,1151 @@ AudioDownloadManager::AudioDownloadManager() : juce::Thread("AudioDownloader")
 
 AudioDownloadManager::~AudioDownloadManager()
 {
-    stopThread(2000);
+    stopDownloadThread();
+
+    // Whatever is left stays in the journal, with the current sizes of the part files.
+    // Once released, the journal is free to be resumed.
+    saveJournal();
+    clearQueue();
+
+    if (journalFile != juce::File())
+        downloadService->releaseJournal(journalFile);
+}
+
+void AudioDownloadManager::startDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                                          Priority priority)
+{
+    // The new grid supersedes what is left of the previous one, queued, in flight and in
+    // the journal. Background jobs and downloads resumed from the journal carry on.
+    int64 session;
+    {
+        juce::ScopedLock lock(queueLock);
+        session = ++gridSession;
+        removeSupersededDownloads();
+    }
+
+    saveJournal();
+    enqueue(sounds, downloadDirectory, searchQuery, priority, session);
 }
 
-void AudioDownloadManager::startDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery)
+void AudioDownloadManager::startJob(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                                    Priority priority, int64 session)
 {
+    // The previous job has already stopped accepting downloads, so at most it is returning
     if (isThreadRunning())
-        stopThread(2000);
+        stopDownloadThread();
+
+    clearQueue();
+    resetProgress();
 
-    soundsToDownload = sounds;
-    targetDirectory = downloadDirectory;
-    currentSearchQuery = searchQuery;
-    currentDownloadIndex = 0;
+    addToQueue(sounds, downloadDirectory, searchQuery, priority, session);
+    saveJournal();
 
     {
-        juce::ScopedLock lock(progressLock);
-        currentProgress.totalFiles = sounds.size();
-        currentProgress.completedFiles = 0;
-        currentProgress.currentFileDownloaded = 0;
-        currentProgress.currentFileTotal = 0;
-        currentProgress.overallProgress = 0.0f;
-        currentProgress.currentFileName = "";
+        juce::ScopedLock lock(queueLock);
+        acceptingDownloads = true;
     }
 
-    targetDirectory.createDirectory();
     startThread();
     startTimer(100); // Update UI every 100ms
 }
 
-void AudioDownloadManager::run()
+void AudioDownloadManager::enqueueDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                                            Priority priority)
 {
-    bool allSuccessful = true;
-    juce::Array<DownloadedFileInfo> downloadedFiles;
+    enqueue(sounds, downloadDirectory, searchQuery, priority, 0);
+}
+
+void AudioDownloadManager::enqueue(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                                   Priority priority, int64 session)
+{
+    bool addedToRunningJob = false;
 
-    for (int i = 0; i < soundsToDownload.size() && !threadShouldExit(); ++i)
     {
-        currentDownloadIndex = i;
-        juce::URL url = soundsToDownload[i].getOGGPreviewURL();
+        juce::ScopedLock lock(queueLock);
 
-        if (url.isEmpty())
+        // The download thread keeps accepting until it has reported the completion of its
+        // job and found nothing else queued, so this never has to wait for it
+        if (acceptingDownloads)
+        {
+            addToQueue(sounds, downloadDirectory, searchQuery, priority, session);
+            addedToRunningJob = true;
+        }
+    }
+
+    if (addedToRunningJob)
+    {
+        saveJournal();
+        return;
+    }
+
+    // Nothing is running, so this becomes a new job
+    startJob(sounds, downloadDirectory, searchQuery, priority, session);
+}
+
+void AudioDownloadManager::removeSupersededDownloads()
+{
+    juce::ScopedLock lock(queueLock);
+
+    for (int i = queue.size(); --i >= 0;)
+    {
+        const auto& item = queue.getReference(i);
+
+        if (!isSuperseded(item))
             continue;
 
-        // Create filename using just Freesound ID: FS_ID_XXXX.ogg
-        juce::String fileName = "FS_ID_" + juce::String(soundsToDownload[i].id) + ".ogg";
-        currentOutputFile = targetDirectory.getChildFile(fileName);
+        if (item.priority == Priority::Interactive)
+            --getInteractiveDownloadCount();
 
+        queue.remove(i);
+        --totalFiles;
+    }
+
+    // Those in flight stop at their next read and leave the journal alone
+    journal.removeIf([this](const QueuedDownload& entry) { return isSuperseded(entry); });
+}
+
+bool AudioDownloadManager::isSuperseded(const QueuedDownload& item) const
+{
+    return item.session != 0 && item.session != gridSession.load();
+}
+
+bool AudioDownloadManager::shouldStop(const QueuedDownload& item) const
+{
+    return threadShouldExit() || isSuperseded(item);
+}
+
+void AudioDownloadManager::cancelDownloads()
+{
+    stopDownloadThread();
+
+    {
+        juce::ScopedLock lock(queueLock);
+        journal.clear();
+    }
+
+    saveJournal();
+}
+
+bool AudioDownloadManager::setPriority(const juce::String& soundId, Priority priority)
+{
+    juce::ScopedLock lock(queueLock);
+
+    for (auto& item : queue)
+    {
+        if (item.sound.id != soundId)
+            continue;
+
+        if (item.priority != priority)
         {
-            juce::ScopedLock lock(progressLock);
-            currentProgress.currentFileName = fileName;
-            currentProgress.currentFileDownloaded = 0;
-            currentProgress.currentFileTotal = 0;
+            if (item.priority == Priority::Interactive)
+                --getInteractiveDownloadCount();
+            if (priority == Priority::Interactive)
+                ++getInteractiveDownloadCount();
+
+            // Goes to the back of its new class
+            item.priority = priority;
+            item.sequence = nextSequence++;
         }
 
-        // Create web input stream
-        juce::URL downloadUrl = url;
-        currentStream = std::make_unique<juce::WebInputStream>(downloadUrl, false);
+        queueChanged.signal();
+        return true;
+    }
+
+    return false;
+}
 
-        if (currentStream->connect(nullptr))
+bool AudioDownloadManager::preempt(const juce::String& soundId)
+{
+    juce::ScopedLock lock(queueLock);
+
+    if (!setPriority(soundId, Priority::Interactive))
+        return false;
+
+    int64 firstSequence = 0;
+    for (const auto& item : queue)
+        firstSequence = juce::jmin(firstSequence, item.sequence);
+
+    for (auto& item : queue)
+        if (item.sound.id == soundId)
+            item.sequence = firstSequence - 1;
+
+    return true;
+}
+
+bool AudioDownloadManager::removeFromQueue(const juce::String& soundId)
+{
+    {
+        juce::ScopedLock lock(queueLock);
+
+        auto item = std::find_if(queue.begin(), queue.end(),
+                                 [&soundId](const QueuedDownload& queued) { return queued.sound.id == soundId; });
+
+        if (item == queue.end())
+            return false;
+
+        if (item->priority == Priority::Interactive)
+            --getInteractiveDownloadCount();
+
+        const juce::File targetDirectory = item->targetDirectory;
+        queue.remove(item);
+        --totalFiles;
+
+        journal.removeIf([&](const QueuedDownload& entry) { return entry.sound.id == soundId
+                                                                   && entry.targetDirectory == targetDirectory; });
+    }
+
+    saveJournal();
+    return true;
+}
+
+void AudioDownloadManager::setNumWorkers(int numberOfWorkers)
+{
+    numWorkers = juce::jlimit(1, maxWorkers, numberOfWorkers);
+}
+
+int AudioDownloadManager::addToQueue(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory,
+                                     const juce::String& searchQuery, Priority priority, int64 session)
+{
+    downloadDirectory.createDirectory();
+    int numAdded = 0;
+
+    {
+        juce::ScopedLock lock(queueLock);
+
+        for (const auto& sound : sounds)
         {
-            // Get file size if available
-            int64 totalSize = currentStream->getTotalLength();
+            // Already queued: only ever raise its priority
+            auto existing = std::find_if(queue.begin(), queue.end(),
+                                         [&sound](const QueuedDownload& item) { return item.sound.id == sound.id; });
 
+            if (existing != queue.end())
             {
-                juce::ScopedLock lock(progressLock);
-                currentProgress.currentFileTotal = totalSize;
+                if (priority < existing->priority)
+                    setPriority(sound.id, priority);
+                continue;
             }
 
-            // Create output stream
-            std::unique_ptr<juce::FileOutputStream> output = currentOutputFile.createOutputStream();
+            QueuedDownload item;
+            item.sound = sound;
+            item.targetDirectory = downloadDirectory;
+            item.searchQuery = searchQuery;
+            item.priority = priority;
+            item.sequence = nextSequence++;
+            item.order = queuedOrder++;
+            item.session = session;
 
-            if (output != nullptr)
-            {
-                const int bufferSize = 8192;
-                juce::HeapBlock<char> buffer(bufferSize);
-                int64 totalRead = 0;
+            if (priority == Priority::Interactive)
+                ++getInteractiveDownloadCount();
 
-                while (!currentStream->isExhausted() && !threadShouldExit())
-                {
-                    int bytesRead = currentStream->read(buffer, bufferSize);
-
-                    if (bytesRead > 0)
-                    {
-                        output->write(buffer, bytesRead);
-                        totalRead += bytesRead;
-
-                        {
-                            juce::ScopedLock lock(progressLock);
-                            currentProgress.currentFileDownloaded = totalRead;
-                        }
-                    }
-                    else if (bytesRead == 0)
-                    {
-                        break; // End of stream
-                    }
-                    else
-                    {
-                        allSuccessful = false;
-                        break; // Error
-                    }
-                }
+            queue.add(item);
+            ++numAdded;
 
-                output->flush();
+            // Sounds carried over from the journal of an earlier run are in it already
+            if (std::none_of(journal.begin(), journal.end(),
+                             [&sound](const QueuedDownload& entry) { return entry.sound.id == sound.id; }))
+                journal.add(item);
+        }
 
-                // Record successful download info
-                if (currentOutputFile.existsAsFile())
-                {
-                    DownloadedFileInfo fileInfo;
-                    fileInfo.fileName = fileName;
-                    fileInfo.originalName = soundsToDownload[i].name; // Get original name from the sound object
-                    fileInfo.freesoundId = soundsToDownload[i].id;
-                    fileInfo.searchQuery = currentSearchQuery;
-                    fileInfo.author = soundsToDownload[i].user;
-                    fileInfo.license = soundsToDownload[i].license;
-                    fileInfo.duration = soundsToDownload[i].duration;
-                    fileInfo.fileSize = soundsToDownload[i].filesize;
-                    fileInfo.downloadedAt = juce::Time::getCurrentTime().toString(true, true);
-                    fileInfo.padIndex = i; // Store original download order
-                    downloadedFiles.add(fileInfo);
-                }
+        totalFiles += numAdded;
+    }
+
+    queueChanged.signal();
+    return numAdded;
+}
+
+void AudioDownloadManager::clearQueue()
+{
+    juce::ScopedLock lock(queueLock);
+
+    for (const auto& item : queue)
+        if (item.priority == Priority::Interactive)
+            --getInteractiveDownloadCount();
+
+    queue.clear();
+    queuedOrder = 0;
+}
+
+void AudioDownloadManager::setJournalDirectory(const juce::File& directory)
+{
+    directory.createDirectory();
+
+    const juce::ScopedLock lock(journalLock);
+
+    if (journalFile != juce::File())
+        downloadService->releaseJournal(journalFile);
+
+    // Held for as long as the journal is ours, so that no other plugin instance resumes it
+    // from under us: the lock covers other processes, the service this one
+    journalFile = directory.getChildFile("queue_" + juce::Uuid().toString() + ".json");
+    journalOwnerLock = std::make_unique<juce::InterProcessLock>(getJournalLockName(journalFile));
+    journalOwnerLock->enter(0);
+    downloadService->claimJournal(journalFile);
+}
+
+juce::String AudioDownloadManager::getJournalLockName(const juce::File& journal)
+{
+    return "FreesoundDownloadJournal_" + journal.getFileNameWithoutExtension();
+}
+
+int AudioDownloadManager::resumeJournaledDownloads()
+{
+    juce::File ownJournal;
+    {
+        const juce::ScopedLock lock(journalLock);
+        ownJournal = journalFile;
+    }
+
+    if (ownJournal == juce::File())
+        return 0;
+
+    int numResumed = 0;
+
+    for (const auto& file : ownJournal.getParentDirectory().findChildFiles(juce::File::findFiles, false, "queue_*.json"))
+    {
+        if (file == ownJournal)
+            continue;
+
+        // Journals of running instances, in this process or another one, are left alone
+        if (!downloadService->claimJournal(file))
+            continue;
+
+        juce::InterProcessLock ownerLock(getJournalLockName(file));
+        const bool ownerIsGone = ownerLock.enter(0);
+        downloadService->releaseJournal(file);
+
+        if (!ownerIsGone)
+            continue;
+
+        // Claim the journal by renaming it, so that two instances starting at the same time
+        // never both resume it
+        const juce::File claimed = file.withFileExtension(".resuming");
+        if (!file.moveFileTo(claimed))
+            continue;
+
+        const juce::var entries = juce::JSON::parse(claimed);
+        claimed.deleteFile();
+
+        if (!entries.isArray())
+            continue;
+
+        // Queued in runs of the same folder, query and priority, keeping the saved order
+        juce::Array<FSSound> run;
+        QueuedDownload runItem;
+
+        auto flushRun = [this, &run, &runItem, &numResumed]
+        {
+            if (run.isEmpty())
+                return;
+
+            enqueueDownloads(run, runItem.targetDirectory, runItem.searchQuery, runItem.priority);
+            numResumed += run.size();
+            run.clear();
+        };
+
+        for (const auto& entry : *entries.getArray())
+        {
+            QueuedDownload item;
+            if (!fromJournalEntry(entry, item))
+                continue;
+
+            const juce::File targetFile = getTargetFileFor(item);
+            if (targetFile.existsAsFile())
+                continue; // Completed since
+
+            // A part file shorter than recorded was truncated by something else; start over
+            const juce::File partFile = getPartFileFor(targetFile);
+            if (partFile.getSize() < (int64) entry["part_offset"])
+                partFile.deleteFile();
+
+            if (!run.isEmpty() && (item.targetDirectory != runItem.targetDirectory
+                                   || item.searchQuery != runItem.searchQuery
+                                   || item.priority != runItem.priority))
+                flushRun();
+
+            runItem = item;
+            run.add(item.sound);
+        }
+
+        flushRun();
+    }
+
+    if (numResumed > 0)
+        DBG("Resumed " + juce::String(numResumed) + " downloads from an earlier session");
+
+    return numResumed;
+}
+
+void AudioDownloadManager::removeFromJournal(const QueuedDownload& item)
+{
+    {
+        juce::ScopedLock lock(queueLock);
+        journal.removeIf([&item](const QueuedDownload& entry) { return entry.sound.id == item.sound.id
+                                                                       && entry.targetDirectory == item.targetDirectory; });
+    }
+
+    saveJournal();
+}
+
+void AudioDownloadManager::saveJournal()
+{
+    // Held across building and writing so that an older state never overwrites a newer one
+    const juce::ScopedLock writeLock(journalLock);
+
+    if (journalFile == juce::File())
+        return;
+
+    juce::var entries;
+    {
+        juce::ScopedLock lock(queueLock);
+
+        for (const auto& item : journal)
+            entries.append(toJournalEntry(item));
+    }
+
+    if (entries.size() == 0)
+        journalFile.deleteFile();
+    else
+        journalFile.replaceWithText(juce::JSON::toString(entries, true));
+}
+
+juce::var AudioDownloadManager::toJournalEntry(const QueuedDownload& item)
+{
+    // Just what downloading and the pad metadata need, with the resolved preview URL so
+    // that resuming needs no API request
+    auto previews = std::make_unique<juce::DynamicObject>();
+    previews->setProperty("preview-hq-ogg", item.sound.previews["preview-hq-ogg"]);
+
+    auto sound = std::make_unique<juce::DynamicObject>();
+    sound->setProperty("id", item.sound.id);
+    sound->setProperty("name", item.sound.name);
+    sound->setProperty("username", item.sound.user);
+    sound->setProperty("license", item.sound.license);
+    sound->setProperty("duration", item.sound.duration);
+    sound->setProperty("filesize", item.sound.filesize);
+    sound->setProperty("previews", juce::var(previews.release()));
+
+    const juce::File partFile = getPartFileFor(getTargetFileFor(item));
+
+    auto entry = std::make_unique<juce::DynamicObject>();
+    entry->setProperty("sound", juce::var(sound.release()));
+    entry->setProperty("directory", item.targetDirectory.getFullPathName());
+    entry->setProperty("query", item.searchQuery);
+    entry->setProperty("priority", (int) item.priority);
+    entry->setProperty("part_offset", partFile.existsAsFile() ? partFile.getSize() : (int64) 0);
+    return juce::var(entry.release());
+}
+
+bool AudioDownloadManager::fromJournalEntry(const juce::var& entry, QueuedDownload& item)
+{
+    const juce::String directory = entry["directory"].toString();
+
+    if (!juce::File::isAbsolutePath(directory) || !entry["sound"].isObject())
+        return false;
+
+    item.sound = FSSound(entry["sound"]);
+    item.targetDirectory = juce::File(directory);
+    item.searchQuery = entry["query"].toString();
+    item.priority = (Priority) juce::jlimit(0, (int) Priority::Background, (int) entry["priority"]);
+
+    return item.sound.id.isNotEmpty() && item.sound.previews.hasProperty("preview-hq-ogg");
+}
+
+std::atomic<int>& AudioDownloadManager::getInteractiveDownloadCount()
+{
+    return downloadService->getInteractiveDownloadCount();
+}
+
+AudioDownloadManager::Priority AudioDownloadManager::getTransferPriority(const DownloadService::SharedDownload& download)
+{
+    return (Priority) download.priority.load();
+}
+
+bool AudioDownloadManager::mustYield(Priority priority)
+{
+    return priority == Priority::Background && getInteractiveDownloadCount().load() > 0;
+}
+
+void AudioDownloadManager::run()
+{
+    for (;;)
+    {
+        const bool success = downloadQueue();
+
+        if (threadShouldExit())
+            clearQueue();
+
+        stopTimer();
+
+        // Final progress update
+        DownloadProgress progress = sampleProgress();
+        progress.overallProgress = 1.0f;
+        progress.currentFileName = success ? "All downloads completed!" : "Some downloads failed";
+        listeners.call([progress](Listener& l) { l.downloadProgressChanged(progress); });
+
+        listeners.call([success](Listener& l) { l.downloadCompleted(success); });
+
+        // Sounds enqueued while the completion was being reported make up the next job
+        {
+            juce::ScopedLock lock(queueLock);
+
+            if (threadShouldExit() || queue.isEmpty())
+            {
+                acceptingDownloads = false;
+                return;
             }
-            else
+
+            totalFiles = queue.size();
+        }
+
+        completedFiles = 0;
+        startTimer(100);
+    }
+}
+
+bool AudioDownloadManager::downloadQueue()
+{
+    std::atomic<bool> allSuccessful { true };
+
+    for (;;)
+    {
+        int workersToStart;
+        {
+            juce::ScopedLock lock(queueLock);
+            workersToStart = juce::jlimit(1, juce::jmax(1, queue.size()), numWorkers.load());
+        }
+
+        {
+            // All workers take from the same priority queue, so a slow file only holds up
+            // its own worker and urgent items are picked up by the next free one
+            juce::ThreadPool workers(workersToStart);
+
+            for (int workerIndex = 0; workerIndex < workersToStart; ++workerIndex)
+                workers.addJob([this, workerIndex, &allSuccessful] { runWorker(workerIndex, allSuccessful); });
+
+            // Workers stop on their own once the queue is drained or the thread is asked to
+            // exit; wait for them here rather than letting the pool destructor time out
+            while (workers.getNumJobs() > 0)
+                wait(20);
+        }
+
+        // Sounds may have been enqueued just as the last worker finished
+        juce::ScopedLock lock(queueLock);
+
+        if (threadShouldExit() || queue.isEmpty())
+            return allSuccessful;
+    }
+}
+
+void AudioDownloadManager::runWorker(int workerIndex, std::atomic<bool>& allSuccessful)
+{
+    while (!threadShouldExit())
+    {
+        QueuedDownload item;
+        const NextDownload next = takeNextDownload(item);
+
+        if (next == NextDownload::Done)
+        {
+            queueChanged.signal(); // let the other idle workers see it too
+            break;
+        }
+
+        if (next == NextDownload::Wait)
+        {
+            queueChanged.wait(50);
+            continue;
+        }
+
+        DownloadedFileInfo fileInfo;
+        const bool downloaded = downloadSound(item, workerIndex, fileInfo);
+
+        if (!downloaded)
+            allSuccessful = false;
+
+        const juce::File targetFile = getTargetFileFor(item);
+        const bool fileReady = downloaded && targetFile.existsAsFile();
+        listeners.call([&item, &targetFile, fileReady](Listener& l) { l.soundDownloadFinished(item.sound, targetFile, fileReady); });
+
+        if (item.priority == Priority::Interactive)
+            --getInteractiveDownloadCount();
+
+        // Finished one way or the other; a cancelled download stays in the journal so that
+        // it is resumed next time. A superseded one is out of it already, and the same sound
+        // may be in it again for the new grid.
+        if (!threadShouldExit() && !isSuperseded(item))
+            removeFromJournal(item);
+
+        ++completedFiles;
+
+        {
+            juce::ScopedLock lock(queueLock);
+            --busyWorkers;
+        }
+
+        queueChanged.signal();
+    }
+}
+
+AudioDownloadManager::NextDownload AudioDownloadManager::takeNextDownload(QueuedDownload& item)
+{
+    juce::ScopedLock lock(queueLock);
+
+    const bool holdBackBackground = getInteractiveDownloadCount().load() > 0;
+    int best = -1;
+
+    for (int i = 0; i < queue.size(); ++i)
+    {
+        const auto& candidate = queue.getReference(i);
+
+        if (holdBackBackground && candidate.priority == Priority::Background)
+            continue;
+
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+
+        const auto& current = queue.getReference(best);
+
+        if (candidate.priority < current.priority
+            || (candidate.priority == current.priority && candidate.sequence < current.sequence))
+            best = i;
+    }
+
+    if (best >= 0)
+    {
+        item = queue.removeAndReturn(best);
+        ++busyWorkers;
+        return NextDownload::Ready;
+    }
+
+    return (queue.isEmpty() && busyWorkers == 0) ? NextDownload::Done : NextDownload::Wait;
+}
+
+bool AudioDownloadManager::downloadSound(const QueuedDownload& item, int workerIndex, DownloadedFileInfo& info)
+{
+    const FSSound& sound = item.sound;
+    juce::URL url = sound.getOGGPreviewURL();
+
+    if (url.isEmpty())
+        return true;
+
+    // Create filename using just Freesound ID: FS_ID_XXXX.ogg. The data goes to a part file
+    // next to it first, and only a complete, size-checked file is renamed into place, so a
+    // half-written FS_ID_XXXX.ogg never exists.
+    juce::File outputFile = getTargetFileFor(item);
+    juce::String fileName = outputFile.getFileName();
+    juce::File partFile = getPartFileFor(outputFile);
+
+    WorkerProgress progress;
+    progress.startedAtMs = juce::Time::getMillisecondCounterHiRes();
+    beginWorkerFile(workerIndex, fileName);
+
+    TransferResult result = TransferResult::Interrupted;
+
+    bool ownsDownload = false;
+    auto sharedDownload = downloadService->beginDownload(outputFile, (int) item.priority, ownsDownload);
+
+    // Another manager (another plugin instance, or another pad) is already fetching this
+    // file; wait for it instead of downloading it twice, and take over if it is cancelled
+    while (!ownsDownload && !shouldStop(item))
+    {
+        if (!sharedDownload->finished.wait(50))
+            continue;
+
+        if (!sharedDownload->abandoned)
+        {
+            result = (sharedDownload->succeeded && outputFile.existsAsFile()) ? TransferResult::Complete
+                                                                              : TransferResult::Failed;
+            break;
+        }
+
+        sharedDownload = downloadService->beginDownload(outputFile, (int) item.priority, ownsDownload);
+    }
+
+    if (ownsDownload)
+    {
+        // Dropped connections resume from the end of the part file, and so do background
+        // transfers that stepped aside for interactive ones
+        for (int attempt = 0; !shouldStop(item);)
+        {
+            result = transferToPartFile(item, url, partFile, workerIndex, progress, *sharedDownload);
+
+            if (result == TransferResult::Yielded)
             {
-                allSuccessful = false;
+                // Holds neither a transfer slot nor a connection while it waits
+                while (mustYield(getTransferPriority(*sharedDownload)) && !shouldStop(item))
+                    juce::Thread::sleep(20);
+
+                continue;
             }
+
+            if (result != TransferResult::Interrupted || ++attempt >= maxTransferAttempts)
+                break;
+
+            juce::Thread::sleep(250 * attempt);
         }
+
+        if (result != TransferResult::Complete && shouldStop(item))
+            result = TransferResult::Cancelled;
+
+        if (result == TransferResult::Complete && !partFile.moveFileTo(outputFile))
+            result = TransferResult::Failed;
+
+        if (result == TransferResult::Complete)
+            recordTransferStats(item, fileName, progress);
+
+        // Anyone waiting for a cancelled download fetches the file themselves
+        if (result == TransferResult::Cancelled)
+            downloadService->abandonDownload(outputFile);
         else
+            downloadService->finishDownload(outputFile, result == TransferResult::Complete);
+    }
+
+    endWorkerFile(workerIndex);
+
+    // A cancelled download keeps its part file so that the next attempt can resume it
+    if (result == TransferResult::Cancelled || shouldStop(item))
+        return true;
+
+    if (result != TransferResult::Complete)
+        return false;
+
+    if (onAudioDataAvailable != nullptr && item.priority != Priority::Background)
+    {
+        juce::MemoryBlock fileData;
+        if (outputFile.loadFileAsData(fileData))
+            onAudioDataAvailable(sound, fileData, true);
+    }
+
+    // Record successful download info
+    info.fileName = fileName;
+    info.originalName = sound.name; // Get original name from the sound object
+    info.freesoundId = sound.id;
+    info.searchQuery = item.searchQuery;
+    info.author = sound.user;
+    info.license = sound.license;
+    info.duration = sound.duration;
+    info.fileSize = sound.filesize;
+    info.downloadedAt = juce::Time::getCurrentTime().toString(true, true);
+    info.padIndex = item.order; // Store original download order
+    return true;
+}
+
+AudioDownloadManager::TransferResult AudioDownloadManager::transferToPartFile(const QueuedDownload& item, const juce::URL& url,
+                                                                             const juce::File& partFile, int workerIndex,
+                                                                             WorkerProgress& progress,
+                                                                             const DownloadService::SharedDownload& download)
+{
+    // Background transfers only take slots while no interactive download is waiting, and
+    // give them back (by returning Yielded) as soon as one is. Otherwise paused transfers
+    // could hold every connection to the host the interactive download needs.
+    if (mustYield(getTransferPriority(download)))
+        return TransferResult::Yielded;
+
+    // Wait for one of the process-wide transfer slots, then for a request slot for the
+    // host. With more workers than either limit the extra ones queue here, so keep
+    // checking for cancellation while waiting.
+    DownloadService::ScopedSlot transferSlot(*downloadService, (int) getTransferPriority(download),
+                                             [this, &item] { return shouldStop(item); });
+
+    if (!transferSlot.isValid())
+        return TransferResult::Cancelled;
+
+    std::unique_ptr<FSHostLimiter::Lease> lease;
+    while (lease == nullptr && !shouldStop(item))
+    {
+        if (mustYield(getTransferPriority(download)))
+            return TransferResult::Yielded;
+
+        lease = FSHostLimiter::getShared().acquire(url, 250);
+    }
+
+    if (lease == nullptr)
+        return TransferResult::Cancelled;
+
+    const int64 resumeFrom = partFile.existsAsFile() ? partFile.getSize() : 0;
+
+    juce::String headers;
+    if (resumeFrom > 0)
+        headers << "Range: bytes=" << resumeFrom << "-";
+
+    juce::WebInputStream stream(url, false);
+    stream.withExtraHeaders(headers).withConnectionTimeout(connectionTimeoutMs);
+
+    // Registered before connecting, so stopping either sees the stream and cancels it, or
+    // has asked the thread to exit before it was registered
+    struct StreamRegistration
+    {
+        StreamRegistration(AudioDownloadManager& m, int index, juce::WebInputStream& s) : manager(m), workerIndex(index)
         {
-            allSuccessful = false;
+            manager.setWorkerStream(workerIndex, &s);
+        }
+
+        ~StreamRegistration() { manager.setWorkerStream(workerIndex, nullptr); }
+
+        AudioDownloadManager& manager;
+        int workerIndex;
+    };
+
+    const StreamRegistration registration(*this, workerIndex, stream);
+
+    if (shouldStop(item))
+        return TransferResult::Cancelled;
+
+    if (!stream.connect(nullptr))
+        return shouldStop(item) ? TransferResult::Cancelled : TransferResult::Interrupted;
+
+    const int statusCode = stream.getStatusCode();
+    const juce::String contentRange = stream.getResponseHeaders()["Content-Range"];
+    int64 expectedSize = -1;
+
+    if (resumeFrom > 0 && statusCode == 206)
+    {
+        if (!contentRange.startsWith("bytes " + juce::String(resumeFrom) + "-"))
+        {
+            // Not the range we asked for; start over
+            partFile.deleteFile();
+            return TransferResult::Interrupted;
+        }
+
+        expectedSize = getTotalSizeFromContentRange(contentRange);
+    }
+    else if (resumeFrom > 0 && statusCode == 416)
+    {
+        // The part file already holds every byte the server has, or it belongs to a
+        // different version of the file
+        if (getTotalSizeFromContentRange(contentRange) == resumeFrom)
+            return TransferResult::Complete;
+
+        partFile.deleteFile();
+        return TransferResult::Interrupted;
+    }
+    else if (statusCode == 200)
+    {
+        // Full response (the server ignored the range, or there was nothing to resume)
+        if (resumeFrom > 0)
+            partFile.deleteFile();
+
+        expectedSize = stream.getTotalLength();
+    }
+    else
+    {
+        return TransferResult::Failed;
+    }
+
+    // FileOutputStream appends, which is what resuming needs
+    std::unique_ptr<juce::FileOutputStream> output = partFile.createOutputStream();
+
+    if (output == nullptr)
+        return TransferResult::Failed;
+
+    progress.downloaded = output->getPosition();
+    progress.total = expectedSize;
+    setWorkerProgress(workerIndex, progress);
+
+    // Keep what has arrived in memory as well when someone wants to decode it early.
+    // Reporting at doubling sizes keeps the total decoding work linear in the file size.
+    const bool reportAudioData = onAudioDataAvailable != nullptr && item.priority != Priority::Background;
+    juce::MemoryBlock receivedData;
+    size_t nextAudioDataReport = firstAudioDataReport;
+
+    if (reportAudioData && progress.downloaded > 0)
+    {
+        partFile.loadFileAsData(receivedData);
+        nextAudioDataReport = juce::jmax(firstAudioDataReport, receivedData.getSize() * 2);
+    }
+
+    juce::HeapBlock<char> buffer(maxChunkSize);
+    int chunkSize = getNextChunkSize(getTransferPriority(download), 0.0);
+    double observedBytesPerSecond = 0.0;
+    bool readError = false;
+    bool yielded = false;
+
+    while (!stream.isExhausted() && !shouldStop(item))
+    {
+        // Background downloads hand their bandwidth and connection to interactive ones,
+        // and resume from the part file once those are done. Interactive downloads waiting
+        // for this very file have raised its priority, so it does not yield to them.
+        if (mustYield(getTransferPriority(download)))
+        {
+            yielded = true;
+            break;
         }
 
-        currentStream.reset();
+        const double readStartMs = juce::Time::getMillisecondCounterHiRes();
+        int bytesRead = stream.read(buffer, chunkSize);
 
+        if (bytesRead > 0)
         {
-            juce::ScopedLock lock(progressLock);
-            currentProgress.completedFiles = i + 1;
+            if (!output->write(buffer, (size_t) bytesRead))
+                return TransferResult::Failed; // Disk full or similar
+
+            if (!downloadService->consumeBandwidth(bytesRead, [this, &item] { return shouldStop(item); }))
+                break;
+
+            // Smoothed rate of this connection (including any wait for the cap), which the
+            // next read is sized from
+            const double readMs = juce::jmax(1.0, juce::Time::getMillisecondCounterHiRes() - readStartMs);
+            const double readBytesPerSecond = bytesRead * 1000.0 / readMs;
+            observedBytesPerSecond = observedBytesPerSecond > 0.0 ? observedBytesPerSecond * 0.75 + readBytesPerSecond * 0.25
+                                                                  : readBytesPerSecond;
+            chunkSize = getNextChunkSize(getTransferPriority(download), observedBytesPerSecond);
+
+            progress.downloaded += bytesRead;
+            progress.bytesReceived += bytesRead;
+            progress.bytesPerSecond = (int64) (progress.bytesReceived * 1000.0
+                                               / juce::jmax(1.0, juce::Time::getMillisecondCounterHiRes() - progress.startedAtMs));
+            setWorkerProgress(workerIndex, progress);
+            reportSoundProgress(item.sound, progress);
+
+            if (reportAudioData)
+            {
+                receivedData.append(buffer, (size_t) bytesRead);
+
+                if (receivedData.getSize() >= nextAudioDataReport)
+                {
+                    onAudioDataAvailable(item.sound, receivedData, false);
+                    nextAudioDataReport = receivedData.getSize() * 2;
+                }
+            }
+        }
+        else if (bytesRead == 0)
+        {
+            break; // End of stream
+        }
+        else
+        {
+            readError = true;
+            break; // Error
         }
     }
 
-    stopTimer();
+    output->flush();
+    output.reset();
+
+    if (shouldStop(item))
+        return TransferResult::Cancelled;
 
-    // Final progress update
+    if (yielded)
+        return TransferResult::Yielded;
+
+    const int64 size = partFile.getSize();
+
+    if (readError || (expectedSize >= 0 && size < expectedSize))
+        return TransferResult::Interrupted;
+
+    if (size == 0 || (expectedSize >= 0 && size != expectedSize))
     {
-        juce::ScopedLock lock(progressLock);
-        currentProgress.overallProgress = 1.0f;
-        currentProgress.currentFileName = allSuccessful ? "All downloads completed!" : "Some downloads failed";
+        partFile.deleteFile();
+        return TransferResult::Failed;
     }
-    updateProgress();
 
-    listeners.call([allSuccessful](Listener& l) { l.downloadCompleted(allSuccessful); });
+    return TransferResult::Complete;
+}
+
+int AudioDownloadManager::getNextChunkSize(Priority priority, double observedBytesPerSecond) const
+{
+    // Background downloads read small chunks so they get back to yielding quickly
+    if (priority == Priority::Background)
+        return minChunkSize;
+
+    if (observedBytesPerSecond <= 0.0)
+        return initialChunkSize;
+
+    double target = observedBytesPerSecond * readDurationMs / 1000.0;
+
+    // Never read more in one go than the cap allows in that time
+    const int64 limit = getBandwidthLimit();
+    if (limit > 0)
+        target = juce::jmin(target, (double) limit * readDurationMs / 1000.0);
+
+    return juce::jlimit(minChunkSize, maxChunkSize, juce::nextPowerOfTwo((int) target));
+}
+
+void AudioDownloadManager::recordTransferStats(const QueuedDownload& item, const juce::String& fileName, const WorkerProgress& progress)
+{
+    TransferStats stats;
+    stats.soundId = item.sound.id;
+    stats.fileName = fileName;
+    stats.bytesReceived = progress.bytesReceived;
+    stats.seconds = (juce::Time::getMillisecondCounterHiRes() - progress.startedAtMs) / 1000.0;
+    stats.bytesPerSecond = stats.seconds > 0.0 ? (double) stats.bytesReceived / stats.seconds : 0.0;
+    stats.priority = item.priority;
+
+    DBG("Downloaded " + fileName + ": " + juce::File::descriptionOfSizeInBytes(stats.bytesReceived)
+        + " in " + juce::String(stats.seconds, 2) + " s, "
+        + juce::File::descriptionOfSizeInBytes((int64) stats.bytesPerSecond) + "/s");
+
+    juce::ScopedLock lock(transferStatsLock);
+    transferStats.add(stats);
+
+    if (transferStats.size() > maxTransferStats)
+        transferStats.removeRange(0, transferStats.size() - maxTransferStats);
+}
+
+juce::Array<AudioDownloadManager::TransferStats> AudioDownloadManager::getRecentTransferStats() const
+{
+    juce::ScopedLock lock(transferStatsLock);
+    return transferStats;
+}
+
+void AudioDownloadManager::reportSoundProgress(const FSSound& sound, WorkerProgress& progress)
+{
+    // Throttled, as reads come in every few kilobytes
+    const juce::uint32 now = juce::Time::getMillisecondCounter();
+
+    if (now - progress.lastReportedAt < soundProgressIntervalMs && progress.downloaded != progress.total)
+        return;
+
+    progress.lastReportedAt = now;
+    const int64 downloaded = progress.downloaded;
+    const int64 total = progress.total;
+    listeners.call([&sound, downloaded, total](Listener& l) { l.soundDownloadProgress(sound, downloaded, total); });
+}
+
+juce::File AudioDownloadManager::getTargetFileFor(const QueuedDownload& item)
+{
+    // Files are named after the Freesound ID only: FS_ID_XXXX.ogg
+    return item.targetDirectory.getChildFile("FS_ID_" + item.sound.id + ".ogg");
+}
+
+juce::File AudioDownloadManager::getPartFileFor(const juce::File& file)
+{
+    return file.getSiblingFile(file.getFileName() + ".part");
+}
+
+int64 AudioDownloadManager::getTotalSizeFromContentRange(const juce::String& contentRange)
+{
+    // "bytes 100-199/200" or "bytes */200"; the total may be "*" when unknown
+    const juce::String total = contentRange.fromLastOccurrenceOf("/", false, false).trim();
+    return (total.isEmpty() || total == "*") ? -1 : total.getLargeIntValue();
+}
+
+void AudioDownloadManager::beginWorkerFile(int workerIndex, const juce::String& fileName)
+{
+    auto& slot = workerSlots[(size_t) workerIndex];
+
+    {
+        const juce::SpinLock::ScopedLockType lock(slot.fileNameLock);
+        slot.fileName = fileName;
+    }
+
+    slot.downloaded = 0;
+    slot.total = 0;
+    slot.bytesPerSecond = 0;
+    slot.startedAt = juce::Time::getMillisecondCounter();
+    slot.active = true;
+}
+
+void AudioDownloadManager::setWorkerProgress(int workerIndex, const WorkerProgress& progress)
+{
+    // Called after every read, so no locks here
+    auto& slot = workerSlots[(size_t) workerIndex];
+    slot.downloaded.store(progress.downloaded, std::memory_order_relaxed);
+    slot.total.store(progress.total, std::memory_order_relaxed);
+    slot.bytesPerSecond.store(progress.bytesPerSecond, std::memory_order_relaxed);
+}
+
+void AudioDownloadManager::endWorkerFile(int workerIndex)
+{
+    workerSlots[(size_t) workerIndex].active = false;
+}
+
+void AudioDownloadManager::setWorkerStream(int workerIndex, juce::WebInputStream* stream)
+{
+    juce::ScopedLock lock(workerStreamsLock);
+    workerStreams[(size_t) workerIndex] = stream;
+}
+
+void AudioDownloadManager::stopDownloadThread()
+{
+    signalThreadShouldExit();
+    queueChanged.signal();
+
+    // Workers check for the exit between reads, but a connect() or read() can block for
+    // as long as the server takes to answer
+    {
+        juce::ScopedLock lock(workerStreamsLock);
+
+        for (auto* stream : workerStreams)
+            if (stream != nullptr)
+                stream->cancel();
+    }
+
+    stopThread(-1);
+}
+
+void AudioDownloadManager::resetProgress()
+{
+    totalFiles = 0;
+    completedFiles = 0;
+
+    for (auto& slot : workerSlots)
+        slot.active = false;
 }
 
 void AudioDownloadManager::timerCallback()
 {
-    updateProgress();
+    const DownloadProgress progress = sampleProgress();
+    listeners.call([progress](Listener& l) { l.downloadProgressChanged(progress); });
 }
 
-void AudioDownloadManager::updateProgress()
+AudioDownloadManager::DownloadProgress AudioDownloadManager::sampleProgress()
 {
     DownloadProgress progress;
+    progress.totalFiles = totalFiles.load();
+    progress.completedFiles = completedFiles.load();
+
+    // The byte counts are summed over every file in flight, and each in-flight file
+    // contributes its own fraction, so the bar stays monotonic with several workers.
+    // Counters of a worker may be a read apart from each other, which a progress bar
+    // does not notice.
+    float activeFilesProgress = 0.0f;
+    juce::uint32 latestStart = 0;
+    const WorkerSlot* latestSlot = nullptr;
+
+    for (const auto& slot : workerSlots)
+    {
+        if (!slot.active.load())
+            continue;
+
+        const int64 downloaded = slot.downloaded.load(std::memory_order_relaxed);
+        const int64 total = slot.total.load(std::memory_order_relaxed);
+
+        ++progress.activeFiles;
+        progress.currentFileDownloaded += downloaded;
+        progress.currentFileTotal += juce::jmax((int64) 0, total);
+        progress.bytesPerSecond += slot.bytesPerSecond.load(std::memory_order_relaxed);
+
+        if (total > 0)
+            activeFilesProgress += juce::jmin(1.0f, (float)downloaded / (float)total);
+
+        if (slot.startedAt.load() >= latestStart)
+        {
+            latestStart = slot.startedAt.load();
+            latestSlot = &slot;
+        }
+    }
+
+    if (latestSlot != nullptr)
     {
-        juce::ScopedLock lock(progressLock);
-        progress = currentProgress;
+        const juce::SpinLock::ScopedLockType lock(latestSlot->fileNameLock);
+        progress.currentFileName = latestSlot->fileName;
     }
 
     // Calculate overall progress
     if (progress.totalFiles > 0)
     {
         float filesProgress = (float)progress.completedFiles / (float)progress.totalFiles;
-        float currentFileProgress = 0.0f;
-
-        if (progress.currentFileTotal > 0)
-        {
-            currentFileProgress = (float)progress.currentFileDownloaded / (float)progress.currentFileTotal;
-            currentFileProgress /= (float)progress.totalFiles; // Weight by total files
-        }
+        float currentFileProgress = activeFilesProgress / (float)progress.totalFiles; // Weight by total files
 
         progress.overallProgress = filesProgress + currentFileProgress;
         progress.overallProgress = juce::jmin(1.0f, progress.overallProgress);
     }
 
-    listeners.call([progress](Listener& l) { l.downloadProgressChanged(progress); });
+    return progress;
 }
 
 void AudioDownloadManager::addListener(Listener* listener)
@@ -2,11 +2,23 @@
 
 #include "shared_plugin_helpers/shared_plugin_helpers.h"
 #include "FreesoundAPI/FreesoundAPI.h"
+#include "DownloadService.h"
 
 class AudioDownloadManager : public juce::Thread,
                            public juce::Timer
 {
 public:
+    // Scheduling classes, most urgent first. Queued items are served in priority order
+    // (then in the order they were queued), and background items are held back for as
+    // long as an interactive download is queued or running in any manager. The same order
+    // decides who gets the next of the DownloadService's process-wide transfer slots.
+    enum class Priority
+    {
+        Interactive = 0,    // a pad the user just clicked or re-searched
+        VisibleGrid,        // filling the visible 4x4 grid
+        Background          // bulk jobs such as downloading the missing samples of presets
+    };
+
     struct DownloadProgress
     {
         int totalFiles = 0;
@@ -14,7 +26,21 @@ public:
         int64 currentFileDownloaded = 0;
         int64 currentFileTotal = 0;
         float overallProgress = 0.0f;
-        juce::String currentFileName;
+        juce::String currentFileName;   // most recently started file
+        int activeFiles = 0;            // files being downloaded right now, across all workers
+        int64 bytesPerSecond = 0;       // combined rate of the files being downloaded
+    };
+
+    // Effective transfer rate of a finished download, measured from its first request to
+    // its last byte (retries included, bytes resumed from an earlier session excluded)
+    struct TransferStats
+    {
+        juce::String soundId;
+        juce::String fileName;
+        int64 bytesReceived = 0;
+        double seconds = 0.0;
+        double bytesPerSecond = 0.0;
+        Priority priority = Priority::VisibleGrid;
     };
 
     struct DownloadedFileInfo
@@ -37,29 +63,212 @@ public:
         virtual ~Listener() = default;
         virtual void downloadProgressChanged(const DownloadProgress& progress) = 0;
         virtual void downloadCompleted(bool success) = 0;
+
+        // Per-sound events, called on a download thread as each file progresses and ends.
+        // The file only exists (complete) when success is true.
+        //
+        // Every callback runs with the listener list locked (see listeners below), so none
+        // of them may wait for the message thread or for another download thread.
+        virtual void soundDownloadProgress(const FSSound& /*sound*/, int64 /*downloaded*/, int64 /*total*/) {}
+        virtual void soundDownloadFinished(const FSSound& /*sound*/, const juce::File& /*file*/, bool /*success*/) {}
     };
 
     AudioDownloadManager();
     ~AudioDownloadManager() override;
 
-    void startDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery);
+    // Downloads the sounds of a new grid. What is left of the previous grid is dropped,
+    // in flight downloads included; sounds queued with enqueueDownloads() carry on.
+    void startDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                        Priority priority = Priority::VisibleGrid);
+
+    // Adds sounds to the running job (or starts one) without cancelling anything.
+    // Sounds that are already queued keep their place but are raised to the given priority.
+    void enqueueDownloads(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                          Priority priority);
+
+    // Moves a queued sound to another priority class; returns false if it is not queued
+    bool setPriority(const juce::String& soundId, Priority priority);
+
+    // Makes a queued sound the very next one to be downloaded; returns false if it is not queued
+    bool preempt(const juce::String& soundId);
+
+    // Drops a sound that is still waiting in the queue, so it is never downloaded; returns
+    // false if it is not queued. A download already in flight is left to finish.
+    bool removeFromQueue(const juce::String& soundId);
+
+    // Stops the running job and forgets everything it still had queued
+    void cancelDownloads();
+
+    // Keeps a journal of the queued and unfinished downloads in this directory (one file per
+    // manager), so a job cut short by the host closing can be picked up again next time
+    void setJournalDirectory(const juce::File& directory);
+
+    // Queues what is left in journals from earlier sessions, skipping sounds that have been
+    // downloaded since. Returns the number of sounds queued.
+    int resumeJournaledDownloads();
+
     void addListener(Listener* listener);
     void removeListener(Listener* listener);
 
+    // Where a download of the given file is written until it is complete
+    static juce::File getPartFileFor(const juce::File& file);
+
+    // Called on a download thread with every byte received so far for a sound: first once
+    // a few kilobytes have arrived, then each time that amount doubles, and once more with
+    // the whole file. Lets the start of a sound be decoded and played while the rest is
+    // still downloading. Background downloads are not reported. Set before starting a job.
+    std::function<void(const FSSound& sound, const juce::MemoryBlock& dataSoFar, bool isComplete)> onAudioDataAvailable;
+
+    // Number of files this manager downloads concurrently; takes effect when a job starts.
+    // Transfers are further capped process-wide by DownloadService and per host by
+    // FSHostLimiter.
+    void setNumWorkers(int numberOfWorkers);
+    int getNumWorkers() const { return numWorkers.load(); }
+
+    // Caps the combined download rate of every plugin instance, in bytes per second;
+    // 0 (the default) is unlimited. Shared through DownloadService.
+    void setBandwidthLimit(int64 bytesPerSecond) { downloadService->setBandwidthLimit(bytesPerSecond); }
+    int64 getBandwidthLimit() const { return downloadService->getBandwidthLimit(); }
+
+    // Rates of the most recently finished downloads of this manager, oldest first
+    juce::Array<TransferStats> getRecentTransferStats() const;
+
 private:
+    static constexpr int maxWorkers = 16;
+
+    // Progress of the file a worker is currently downloading, as the worker tracks it
+    struct WorkerProgress
+    {
+        int64 downloaded = 0;
+        int64 total = 0;
+        juce::uint32 lastReportedAt = 0;
+        int64 bytesReceived = 0;        // over the network in this session, for the rate
+        double startedAtMs = 0.0;
+        int64 bytesPerSecond = 0;
+    };
+
+    // What the UI timer sees of a worker. The download loop only stores into the atomics,
+    // so neither side ever waits for the other; the file name changes once per file and
+    // has its own tiny lock.
+    struct WorkerSlot
+    {
+        std::atomic<bool> active { false };
+        std::atomic<int64> downloaded { 0 };
+        std::atomic<int64> total { 0 };
+        std::atomic<juce::uint32> startedAt { 0 };
+        std::atomic<int64> bytesPerSecond { 0 };
+        juce::SpinLock fileNameLock;
+        juce::String fileName;
+    };
+
+    struct QueuedDownload
+    {
+        FSSound sound;
+        juce::File targetDirectory;
+        juce::String searchQuery;
+        Priority priority = Priority::VisibleGrid;
+        int64 sequence = 0;     // order within a priority class, lower goes first
+        int order = 0;          // position in the job, reported as padIndex
+        int64 session = 0;      // grid it was queued for by startDownloads(), 0 for enqueued ones
+    };
+
+    enum class NextDownload { Ready, Wait, Done };
+    enum class TransferResult { Complete, Interrupted, Yielded, Failed, Cancelled };
+
+    static constexpr int maxTransferAttempts = 3;
+    static constexpr int connectionTimeoutMs = 10000;
+    static constexpr size_t firstAudioDataReport = 16 * 1024;
+    static constexpr juce::uint32 soundProgressIntervalMs = 50;
+
+    // Reads are sized to about readDurationMs of the observed throughput, within these bounds
+    static constexpr int minChunkSize = 4 * 1024;
+    static constexpr int initialChunkSize = 8 * 1024;
+    static constexpr int maxChunkSize = 256 * 1024;
+    static constexpr double readDurationMs = 50.0;
+    static constexpr int maxTransferStats = 64;
+
+    void startJob(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                  Priority priority, int64 session);
+    void enqueue(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory, const juce::String& searchQuery,
+                 Priority priority, int64 session);
+    void removeSupersededDownloads();
+    bool isSuperseded(const QueuedDownload& item) const;
+    bool shouldStop(const QueuedDownload& item) const;
     void run() override;
+    bool downloadQueue();
     void timerCallback() override;
-    void updateProgress();
-
-    juce::Array<FSSound> soundsToDownload;
-    juce::File targetDirectory;
-    juce::String currentSearchQuery;
-    juce::ListenerList<Listener> listeners;
-    
-    DownloadProgress currentProgress;
-    juce::CriticalSection progressLock;
-    
-    std::unique_ptr<juce::WebInputStream> currentStream;
-    juce::File currentOutputFile;
-    int currentDownloadIndex = 0;
+    DownloadProgress sampleProgress();
+    void runWorker(int workerIndex, std::atomic<bool>& allSuccessful);
+    NextDownload takeNextDownload(QueuedDownload& item);
+    bool downloadSound(const QueuedDownload& item, int workerIndex, DownloadedFileInfo& info);
+    TransferResult transferToPartFile(const QueuedDownload& item, const juce::URL& url, const juce::File& partFile,
+                                      int workerIndex, WorkerProgress& progress, const DownloadService::SharedDownload& download);
+    void beginWorkerFile(int workerIndex, const juce::String& fileName);
+    void setWorkerProgress(int workerIndex, const WorkerProgress& progress);
+    void endWorkerFile(int workerIndex);
+    void setWorkerStream(int workerIndex, juce::WebInputStream* stream);
+
+    // Asks the download thread to stop, cancels the connections and reads its workers are
+    // blocked in, and waits for the thread and every worker to return. The thread is never
+    // killed, as its workers would carry on with a manager that may be deleted next.
+    void stopDownloadThread();
+    void resetProgress();
+    void reportSoundProgress(const FSSound& sound, WorkerProgress& progress);
+    int getNextChunkSize(Priority priority, double observedBytesPerSecond) const;
+    void recordTransferStats(const QueuedDownload& item, const juce::String& fileName, const WorkerProgress& progress);
+    static juce::File getTargetFileFor(const QueuedDownload& item);
+    int addToQueue(const juce::Array<FSSound>& sounds, const juce::File& downloadDirectory,
+                   const juce::String& searchQuery, Priority priority, int64 session);
+    void clearQueue();
+    void removeFromJournal(const QueuedDownload& item);
+    void saveJournal();
+    static juce::var toJournalEntry(const QueuedDownload& item);
+    static bool fromJournalEntry(const juce::var& entry, QueuedDownload& item);
+    static juce::String getJournalLockName(const juce::File& journal);
+
+    // Interactive downloads queued or running across every manager in the process
+    std::atomic<int>& getInteractiveDownloadCount();
+
+    // A transfer runs at the most urgent priority of everyone waiting for its file
+    static Priority getTransferPriority(const DownloadService::SharedDownload& download);
+
+    // True while a transfer of this priority has to make way for interactive downloads
+    bool mustYield(Priority priority);
+    static int64 getTotalSizeFromContentRange(const juce::String& contentRange);
+
+    juce::SharedResourcePointer<DownloadService> downloadService;
+    // The download workers and the progress timer on the message thread call the listeners
+    // at the same time, so the list has a lock: each call() holds it while notifying, which
+    // serialises the callbacks, and addListener()/removeListener() wait for a call in
+    // progress to return. Once removeListener() returns, the listener is no longer called.
+    juce::ListenerList<Listener, juce::Array<Listener*, juce::CriticalSection>> listeners;
+
+    juce::Array<QueuedDownload> queue;
+    juce::CriticalSection queueLock;
+    juce::WaitableEvent queueChanged;
+    int busyWorkers = 0;
+    int queuedOrder = 0;
+    int64 nextSequence = 0;
+    bool acceptingDownloads = false;
+    std::atomic<int64> gridSession { 0 };   // the current grid of startDownloads()
+
+    std::atomic<int> totalFiles { 0 };
+    std::atomic<int> completedFiles { 0 };
+    std::array<WorkerSlot, maxWorkers> workerSlots;
+
+    // Every download queued but not yet finished, in flight ones included. Guarded by
+    // queueLock; journalLock serialises the writes of its file.
+    juce::Array<QueuedDownload> journal;
+    juce::File journalFile;
+    std::unique_ptr<juce::InterProcessLock> journalOwnerLock;
+    juce::CriticalSection journalLock;
+
+    juce::Array<TransferStats> transferStats;
+    juce::CriticalSection transferStatsLock;
+
+    // The stream each worker is reading from, so that stopping can cancel it
+    std::array<juce::WebInputStream*, maxWorkers> workerStreams {};
+    juce::CriticalSection workerStreamsLock;
+
+    std::atomic<int> numWorkers { 4 };
 };
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "DecodedSamplePool.h"
+
+//==============================================================================
+// DecodedSample
+//==============================================================================
+
+DecodedSample::DecodedSample(const String& id, AudioFormatReader& reader, double maxLengthSeconds, bool isComplete)
+    : freesoundId(id), complete(isComplete)
+{
+    if (reader.sampleRate <= 0)
+        return;
+
+    sourceSampleRate = reader.sampleRate;
+    sourceLength = reader.lengthInSamples;
+    length = (int) jmin(sourceLength, (int64) (maxLengthSeconds * sourceSampleRate));
+
+    // Padded so that interpolating past the last sample stays inside the buffer
+    data.setSize((int) jmin(2u, reader.numChannels), length + 4);
+    reader.read(&data, 0, length + 4, 0, true, true);
+}
+
+DecodedSample::DecodedSample(const String& id, std::unique_ptr<MemoryMappedFile> file, float* channelData,
+                             int numChannels, int bufferLength, int lengthToUse, int64 sourceLengthToUse,
+                             double sourceSampleRateToUse)
+    : freesoundId(id), mappedFile(std::move(file)), length(lengthToUse), sourceLength(sourceLengthToUse),
+      sourceSampleRate(sourceSampleRateToUse), complete(true)
+{
+    float* channels[2] = { channelData, channelData + (numChannels > 1 ? bufferLength : 0) };
+    data.setDataToReferTo(channels, numChannels, bufferLength);
+}
+
+//==============================================================================
+// DecodedSamplePool
+//==============================================================================
+
+DecodedSamplePool::DecodedSamplePool()
+{
+    formatManager.registerBasicFormats();
+}
+
+DecodedSamplePool::~DecodedSamplePool()
+{
+    decodeThread.removeAllJobs(true, 4000);
+
+    for (auto& entry : entries)
+        entry.second.sample->pooled = false;
+}
+
+DecodedSample::Ptr DecodedSamplePool::getSample(const String& freesoundId, const File& audioFile)
+{
+    if (auto sample = findSample(freesoundId))
+        return sample;
+
+    // Decoded without the lock, so other lookups don't wait for it
+    DecodedSample::Ptr decoded = decodeSample(freesoundId, audioFile);
+
+    if (decoded == nullptr)
+        return nullptr;
+
+    const ScopedLock sl(lock);
+
+    // Someone else decoded the same sample in the meantime
+    if (auto sample = findSampleLocked(freesoundId))
+        return sample;
+
+    decoded->pooled = true;
+    entries[freesoundId] = { decoded, ++useCounter };
+    memoryUsed += decoded->getMemorySize();
+    evictUnusedSamples();
+
+    return decoded;
+}
+
+DecodedSample::Ptr DecodedSamplePool::findSample(const String& freesoundId)
+{
+    const ScopedLock sl(lock);
+    return findSampleLocked(freesoundId);
+}
+
+DecodedSample::Ptr DecodedSamplePool::findSampleLocked(const String& freesoundId)
+{
+    auto it = entries.find(freesoundId);
+
+    if (it == entries.end())
+        return nullptr;
+
+    it->second.lastUsed = ++useCounter;
+    return it->second.sample;
+}
+
+void DecodedSamplePool::requestSample(const String& freesoundId, const File& audioFile,
+                                      std::function<void(DecodedSample::Ptr)> onLoaded)
+{
+    decodeThread.addJob([this, freesoundId, audioFile, onLoaded]
+    {
+        DecodedSample::Ptr sample = getSample(freesoundId, audioFile);
+
+        MessageManager::callAsync([onLoaded, sample]
+        {
+            if (onLoaded != nullptr)
+                onLoaded(sample);
+        });
+    });
+}
+
+void DecodedSamplePool::setCacheDirectory(const File& directory)
+{
+    directory.createDirectory();
+
+    {
+        const ScopedLock sl(lock);
+        cacheDirectory = directory;
+    }
+
+    // Whatever earlier sessions left behind may be over budget
+    decodeThread.addJob([this] { trimCache({}); });
+}
+
+void DecodedSamplePool::setCacheBudget(int64 bytes)
+{
+    cacheBudget = jmax((int64) 0, bytes);
+    decodeThread.addJob([this] { trimCache({}); });
+}
+
+DecodedSample::Ptr DecodedSamplePool::decodeSample(const String& freesoundId, const File& audioFile)
+{
+    const File cacheFile = getCacheFile(freesoundId);
+
+    if (cacheFile != File())
+        if (auto cached = loadFromCache(freesoundId, audioFile, cacheFile))
+            return cached;
+
+    std::unique_ptr<AudioFormatReader> reader(formatManager.createReaderFor(audioFile));
+
+    if (reader == nullptr)
+        return nullptr;
+
+    DecodedSample::Ptr decoded = new DecodedSample(freesoundId, *reader, preloadLength);
+    decoded->sourceFile = audioFile;
+
+    // Played from the mapped cache file from now on, which the OS can page out
+    if (cacheFile != File() && writeToCache(*decoded, audioFile, cacheFile))
+    {
+        trimCache(cacheFile);
+
+        if (auto cached = loadFromCache(freesoundId, audioFile, cacheFile))
+            return cached;
+    }
+
+    return decoded;
+}
+
+File DecodedSamplePool::getCacheFile(const String& freesoundId)
+{
+    const ScopedLock sl(lock);
+
+    if (cacheDirectory == File())
+        return {};
+
+    return cacheDirectory.getChildFile("FS_ID_" + freesoundId + ".pcm");
+}
+
+DecodedSample::Ptr DecodedSamplePool::loadFromCache(const String& freesoundId, const File& audioFile, const File& cacheFile)
+{
+    if (!cacheFile.existsAsFile())
+        return nullptr;
+
+    auto mapped = std::make_unique<MemoryMappedFile>(cacheFile, MemoryMappedFile::readOnly);
+
+    if (mapped->getData() == nullptr || mapped->getSize() < (size_t) cacheHeaderSize)
+        return nullptr;
+
+    CacheHeader header;
+    memcpy(&header, mapped->getData(), sizeof(header));
+
+    // Stale once the source changed, or written by an older build
+    if (memcmp(header.magic, "FSPC", 4) != 0
+        || header.version != cacheVersion
+        || header.sourceFileSize != audioFile.getSize()
+        || header.sourceFileModified != audioFile.getLastModificationTime().toMilliseconds()
+        || header.maxLength != preloadLength
+        || header.numChannels < 1 || header.numChannels > 2
+        || header.length < 0 || header.length > (int64) header.bufferLength
+        || mapped->getSize() != (size_t) cacheHeaderSize + (size_t) header.numChannels * header.bufferLength * sizeof(float))
+        return nullptr;
+
+    auto* channelData = static_cast<float*>(addBytesToPointer(mapped->getData(), cacheHeaderSize));
+
+    DecodedSample::Ptr sample = new DecodedSample(freesoundId, std::move(mapped), channelData, (int) header.numChannels,
+                                                  (int) header.bufferLength, (int) header.length, header.sourceLength,
+                                                  header.sourceSampleRate);
+    sample->sourceFile = audioFile;
+
+    // Its modification time orders the cache from least to most recently used
+    cacheFile.setLastModificationTime(Time::getCurrentTime());
+    return sample;
+}
+
+void DecodedSamplePool::trimCache(const File& fileToKeep)
+{
+    File directory;
+    StringArray filesInUse { fileToKeep.getFileName() };
+
+    {
+        const ScopedLock sl(lock);
+        directory = cacheDirectory;
+
+        for (const auto& entry : entries)
+            if (entry.second.sample->isMemoryMapped())
+                filesInUse.add(getCacheFile(entry.first).getFileName());
+    }
+
+    if (directory == File())
+        return;
+
+    // Scanned without the lock, so lookups don't wait for the disk
+    Array<File> files = directory.findChildFiles(File::findFiles, false, "*.pcm");
+    int64 totalSize = 0;
+
+    for (const auto& file : files)
+        totalSize += file.getSize();
+
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b)
+    {
+        return a.getLastModificationTime() < b.getLastModificationTime();
+    });
+
+    for (const auto& file : files)
+    {
+        if (totalSize <= cacheBudget.load())
+            break;
+
+        if (filesInUse.contains(file.getFileName()))
+            continue;
+
+        const int64 size = file.getSize();
+
+        if (file.deleteFile())
+            totalSize -= size;
+    }
+}
+
+bool DecodedSamplePool::writeToCache(const DecodedSample& sample, const File& audioFile, const File& cacheFile)
+{
+    static_assert(sizeof(CacheHeader) <= (size_t) cacheHeaderSize, "cache header too large");
+
+    const auto& data = sample.getAudioData();
+
+    HeapBlock<char> headerBlock(cacheHeaderSize, true);
+    CacheHeader header;
+    memcpy(header.magic, "FSPC", 4);
+    header.version = cacheVersion;
+    header.numChannels = (uint32) data.getNumChannels();
+    header.bufferLength = (uint32) data.getNumSamples();
+    header.length = sample.getLength();
+    header.sourceLength = sample.sourceLength;
+    header.sourceSampleRate = sample.getSourceSampleRate();
+    header.sourceFileSize = audioFile.getSize();
+    header.sourceFileModified = audioFile.getLastModificationTime().toMilliseconds();
+    header.maxLength = preloadLength;
+    memcpy(headerBlock.get(), &header, sizeof(header));
+
+    // Written aside and moved into place, so a file being mapped is never half written
+    TemporaryFile tempFile(cacheFile);
+
+    {
+        FileOutputStream out(tempFile.getFile());
+
+        if (out.failedToOpen())
+            return false;
+
+        bool ok = out.write(headerBlock.get(), (size_t) cacheHeaderSize);
+
+        for (int channel = 0; ok && channel < data.getNumChannels(); ++channel)
+            ok = out.write(data.getReadPointer(channel), (size_t) data.getNumSamples() * sizeof(float));
+
+        out.flush();
+
+        if (!ok || out.getStatus().failed())
+            return false;
+    }
+
+    return tempFile.overwriteTargetFileWithTemporary();
+}
+
+void DecodedSamplePool::setMemoryBudget(int64 bytes)
+{
+    const ScopedLock sl(lock);
+    memoryBudget = jmax((int64) 0, bytes);
+    evictUnusedSamples();
+}
+
+void DecodedSamplePool::evictUnusedSamples()
+{
+    while (memoryUsed.load() > memoryBudget.load())
+    {
+        // The least recently used sample only the pool refers to
+        auto oldest = entries.end();
+
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+            if (it->second.sample->getReferenceCount() == 1
+                && (oldest == entries.end() || it->second.lastUsed < oldest->second.lastUsed))
+                oldest = it;
+
+        if (oldest == entries.end())
+            break;
+
+        oldest->second.sample->pooled = false;
+        memoryUsed -= oldest->second.sample->getMemorySize();
+        entries.erase(oldest);
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "shared_plugin_helpers/shared_plugin_helpers.h"
+
+using namespace juce;
+
+//==============================================================================
+// The decoded audio of one sample. Never changes once built, so the loader thread and
+// any number of voices can share it by reference. The audio is either decoded into memory
+// or mapped from DecodedSamplePool's disk cache. Long samples only hold their first few
+// seconds; voices stream the rest from the source file (see SampleStream).
+class DecodedSample : public ReferenceCountedObject
+{
+public:
+    using Ptr = ReferenceCountedObjectPtr<DecodedSample>;
+
+    // Reads at most maxLengthSeconds from the reader. isComplete is false for the playable
+    // start of a file that is still downloading.
+    DecodedSample(const String& freesoundId, AudioFormatReader& reader, double maxLengthSeconds, bool isComplete = true);
+
+    const String& getFreesoundId() const { return freesoundId; }
+    const AudioBuffer<float>& getAudioData() const { return data; }
+    int getLength() const { return length; }    // the buffer has a few samples of padding past this
+    double getSourceSampleRate() const { return sourceSampleRate; }
+    bool isComplete() const { return complete; }
+    bool isMemoryMapped() const { return mappedFile != nullptr; }
+    bool isTruncated() const { return length < sourceLength; }     // cut at the maximum length
+
+    // The rest of a truncated sample can be streamed from the file it was decoded from
+    const File& getSourceFile() const { return sourceFile; }
+    bool canStream() const { return isTruncated() && sourceFile != File(); }
+    int64 getSourceLength() const { return sourceLength; }
+    int64 getPlayableLength() const { return canStream() ? sourceLength : (int64) length; }
+    int64 getMemorySize() const { return (int64) data.getNumChannels() * data.getNumSamples() * (int64) sizeof(float); }
+
+    // True while DecodedSamplePool holds a reference to it
+    bool isPooled() const { return pooled.load(); }
+
+private:
+    friend class DecodedSamplePool;
+
+    // Refers to the planar channels of a cache file mapped into memory
+    DecodedSample(const String& freesoundId, std::unique_ptr<MemoryMappedFile> mappedFile, float* channelData,
+                  int numChannels, int bufferLength, int length, int64 sourceLength, double sourceSampleRate);
+
+    const String freesoundId;
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    AudioBuffer<float> data;
+    int length = 0;
+    int64 sourceLength = 0;
+    double sourceSampleRate = 44100.0;
+    File sourceFile;    // set by the pool
+    const bool complete;
+    std::atomic<bool> pooled { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedSample)
+};
+
+//==============================================================================
+// One decoded copy of each Freesound sample for the whole process, shared by the pads and
+// previews of every plugin instance and by the waveforms and WAV exports of the sample
+// pads. Only the first preloadLength seconds are decoded; voices stream the rest.
+//
+// Samples stay pooled after their last user lets go, and the least recently used of
+// those are dropped once the pool grows past its memory budget. Samples still in use are
+// never dropped, so the pool can go over budget while they are.
+//
+// With a cache directory set, decoded samples are also written there as raw planar floats,
+// and later loads map those files instead of decoding the Ogg again, so reloading a preset
+// costs page faults rather than Vorbis decoding. A cache file is only used while the size
+// and modification time of the file it was decoded from still match. The cache files are
+// kept under a disk budget of their own, dropping the least recently used first.
+//
+// Get it through a SharedResourcePointer<DecodedSamplePool>, like DownloadService.
+class DecodedSamplePool
+{
+public:
+    static constexpr double preloadLength = 4.0;    // seconds decoded of each sample
+    static constexpr int64 defaultMemoryBudget = (int64) 512 * 1024 * 1024;
+    static constexpr int64 defaultCacheBudget = (int64) 1024 * 1024 * 1024;
+
+    DecodedSamplePool();
+    ~DecodedSamplePool();
+
+    // The pooled sample of freesoundId, decoding audioFile first if it isn't pooled yet.
+    // Blocks while decoding; returns nullptr if the file can't be read.
+    DecodedSample::Ptr getSample(const String& freesoundId, const File& audioFile);
+
+    // Only what is pooled already
+    DecodedSample::Ptr findSample(const String& freesoundId);
+
+    // Like getSample(), but decodes on the pool's thread and calls back on the message thread
+    void requestSample(const String& freesoundId, const File& audioFile,
+                       std::function<void(DecodedSample::Ptr)> onLoaded);
+
+    // Where decoded samples are cached on disk; no caching until this is set
+    void setCacheDirectory(const File& directory);
+
+    void setMemoryBudget(int64 bytes);
+    int64 getMemoryBudget() const { return memoryBudget.load(); }
+    int64 getMemoryUsage() const { return memoryUsed.load(); }
+
+    // Bytes the cache directory may take up. Files of pooled samples are never removed.
+    void setCacheBudget(int64 bytes);
+    int64 getCacheBudget() const { return cacheBudget.load(); }
+
+private:
+    struct Entry
+    {
+        DecodedSample::Ptr sample;
+        uint32 lastUsed = 0;
+    };
+
+    // Fixed-size header in front of the channel data of a cache file
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32 version;
+        uint32 numChannels;
+        uint32 bufferLength;    // samples per channel, padding included
+        int64 length;
+        int64 sourceLength;
+        double sourceSampleRate;
+        int64 sourceFileSize;
+        int64 sourceFileModified;
+        double maxLength;
+    };
+
+    static constexpr int cacheHeaderSize = 64;     // keeps the channel data aligned
+    static constexpr uint32 cacheVersion = 1;
+
+    DecodedSample::Ptr decodeSample(const String& freesoundId, const File& audioFile);
+    File getCacheFile(const String& freesoundId);
+    static DecodedSample::Ptr loadFromCache(const String& freesoundId, const File& audioFile, const File& cacheFile);
+    static bool writeToCache(const DecodedSample& sample, const File& audioFile, const File& cacheFile);
+    DecodedSample::Ptr findSampleLocked(const String& freesoundId);
+    void evictUnusedSamples();  // with the lock held
+    void trimCache(const File& fileToKeep);     // removes the least recently used files over budget
+
+    CriticalSection lock;
+    std::map<String, Entry> entries;
+    uint32 useCounter = 0;
+    std::atomic<int64> memoryBudget { defaultMemoryBudget };
+    std::atomic<int64> memoryUsed { 0 };
+    std::atomic<int64> cacheBudget { defaultCacheBudget };
+
+    File cacheDirectory;        // guarded by lock
+    AudioFormatManager formatManager;
+    ThreadPool decodeThread { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DecodedSamplePool)
+};
@@ -0,0 +1,166 @@
+#include "DownloadService.h"
+
+bool DownloadService::acquireSlot(int priority, const std::function<bool()>& shouldAbort)
+{
+    const int slot = juce::jlimit(0, numPriorities - 1, priority);
+
+    {
+        const juce::ScopedLock sl(lock);
+        ++waitingByPriority[(size_t) slot];
+    }
+
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+
+            bool moreUrgentWaiting = false;
+            for (int i = 0; i < slot; ++i)
+                moreUrgentWaiting = moreUrgentWaiting || waitingByPriority[(size_t) i] > 0;
+
+            // Interactive downloads get a little headroom above the limit, since the slots
+            // may all be held by background transfers that pause for them
+            const int limit = maxConcurrentDownloads.load() + (slot == 0 ? interactiveHeadroom : 0);
+
+            if (!moreUrgentWaiting && activeDownloads.load() < limit)
+            {
+                --waitingByPriority[(size_t) slot];
+                ++activeDownloads;
+                return true;
+            }
+
+            if (shouldAbort != nullptr && shouldAbort())
+            {
+                --waitingByPriority[(size_t) slot];
+                return false;
+            }
+        }
+
+        slotFreed.wait(20);
+    }
+}
+
+void DownloadService::releaseSlot()
+{
+    --activeDownloads;
+    slotFreed.signal();
+}
+
+std::shared_ptr<DownloadService::SharedDownload> DownloadService::beginDownload(const juce::File& targetFile, int priority,
+                                                                              bool& isOwner)
+{
+    priority = juce::jlimit(0, numPriorities - 1, priority);
+
+    const juce::ScopedLock sl(lock);
+    auto& download = downloadsInFlight[targetFile.getFullPathName()];
+    isOwner = download == nullptr;
+
+    if (isOwner)
+    {
+        download = std::make_shared<SharedDownload>();
+        download->priority = priority;
+        return download;
+    }
+
+    if (priority < download->priority.load())
+        download->priority = priority;
+
+    ++deduplicatedDownloads;
+    return download;
+}
+
+void DownloadService::finishDownload(const juce::File& targetFile, bool succeeded)
+{
+    if (auto download = removeDownload(targetFile))
+    {
+        download->succeeded = succeeded;
+        download->finished.signal();
+    }
+}
+
+void DownloadService::abandonDownload(const juce::File& targetFile)
+{
+    if (auto download = removeDownload(targetFile))
+    {
+        download->abandoned = true;
+        download->finished.signal();
+    }
+}
+
+std::shared_ptr<DownloadService::SharedDownload> DownloadService::removeDownload(const juce::File& targetFile)
+{
+    const juce::ScopedLock sl(lock);
+    auto it = downloadsInFlight.find(targetFile.getFullPathName());
+
+    if (it == downloadsInFlight.end())
+        return nullptr;
+
+    auto download = it->second;
+    downloadsInFlight.erase(it);
+    return download;
+}
+
+bool DownloadService::claimJournal(const juce::File& journal)
+{
+    const juce::ScopedLock sl(lock);
+    return journalsInUse.addIfNotAlreadyThere(journal.getFullPathName());
+}
+
+void DownloadService::releaseJournal(const juce::File& journal)
+{
+    const juce::ScopedLock sl(lock);
+    journalsInUse.removeString(journal.getFullPathName());
+}
+
+bool DownloadService::consumeBandwidth(int64 numBytes, const std::function<bool()>& shouldAbort)
+{
+    double waitMs = 0.0;
+
+    {
+        const juce::ScopedLock sl(bandwidthLock);
+        const int64 limit = bandwidthLimit.load();
+
+        if (limit <= 0)
+            return true;
+
+        // Refill at the capped rate, allowing a burst of a quarter of a second
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        const double burst = (double) limit * 0.25;
+        bandwidthTokens = juce::jmin(burst, bandwidthTokens + (now - lastRefillMs) * (double) limit / 1000.0);
+        lastRefillMs = now;
+
+        bandwidthTokens -= (double) numBytes;
+
+        if (bandwidthTokens >= 0.0)
+            return true;
+
+        waitMs = -bandwidthTokens * 1000.0 / (double) limit;
+    }
+
+    // Sleep the debt off in short steps so that cancelling stays responsive
+    const double endMs = juce::Time::getMillisecondCounterHiRes() + waitMs;
+
+    for (double now = juce::Time::getMillisecondCounterHiRes(); now < endMs; now = juce::Time::getMillisecondCounterHiRes())
+    {
+        if (shouldAbort != nullptr && shouldAbort())
+            return false;
+
+        juce::Thread::sleep(juce::jlimit(1, 20, (int) (endMs - now)));
+    }
+
+    return true;
+}
+
+void DownloadService::setBandwidthLimit(int64 bytesPerSecond)
+{
+    const juce::ScopedLock sl(bandwidthLock);
+    bandwidthLimit = juce::jmax((int64) 0, bytesPerSecond);
+    bandwidthTokens = 0.0;
+    lastRefillMs = juce::Time::getMillisecondCounterHiRes();
+}
+
+void DownloadService::setMaxConcurrentDownloads(int maxDownloads)
+{
+    maxConcurrentDownloads = juce::jmax(1, maxDownloads);
+    slotFreed.signal();
+}
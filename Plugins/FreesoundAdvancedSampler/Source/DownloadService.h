@@ -0,0 +1,117 @@
+#pragma once
+
+#include "shared_plugin_helpers/shared_plugin_helpers.h"
+
+//==============================================================================
+// Process-wide coordination of the download managers of every plugin instance (and of
+// the single-pad downloads of each grid). It caps the number of transfers running at once
+// across the whole process, hands the free transfer slots out by priority, shares an
+// optional bandwidth cap between all transfers, and makes sure a file is only fetched
+// once when several instances ask for the same sound.
+//
+// Get it through a juce::SharedResourcePointer<DownloadService>, so it lives as long as
+// at least one download manager does.
+class DownloadService
+{
+public:
+    // Same scheduling classes as AudioDownloadManager::Priority; lower values are more urgent
+    static constexpr int numPriorities = 3;
+    static constexpr int interactiveHeadroom = 2;
+
+    // State of a download that other managers can wait on instead of fetching the file again
+    struct SharedDownload
+    {
+        juce::WaitableEvent finished { true };
+        std::atomic<bool> succeeded { false };
+        std::atomic<bool> abandoned { false };  // cancelled by its owner; a waiter can take over
+
+        // Most urgent priority of the owner and everyone waiting for it. The owner schedules
+        // its transfer by this, so it never yields to the very downloads waiting on it.
+        std::atomic<int> priority { numPriorities - 1 };
+    };
+
+    // Holds one of the global transfer slots for as long as it exists
+    class ScopedSlot
+    {
+    public:
+        ScopedSlot(DownloadService& service, int priority, const std::function<bool()>& shouldAbort)
+            : owner(service), acquired(service.acquireSlot(priority, shouldAbort)) {}
+
+        ~ScopedSlot()
+        {
+            if (acquired)
+                owner.releaseSlot();
+        }
+
+        bool isValid() const { return acquired; }
+
+    private:
+        DownloadService& owner;
+        const bool acquired;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedSlot)
+    };
+
+    DownloadService() = default;
+    ~DownloadService() = default;
+
+    // Waits for a transfer slot. Waiters with a more urgent priority are always served
+    // first. Returns false if shouldAbort() became true while waiting.
+    bool acquireSlot(int priority, const std::function<bool()>& shouldAbort);
+    void releaseSlot();
+
+    // Registers a download of the given file at a priority. The first caller owns the
+    // download (isOwner is set) and must call finishDownload() once it is done; later
+    // callers get the one already in flight and can wait for it to finish. A caller more
+    // urgent than the download raises its priority to its own.
+    std::shared_ptr<SharedDownload> beginDownload(const juce::File& targetFile, int priority, bool& isOwner);
+    void finishDownload(const juce::File& targetFile, bool succeeded);
+
+    // Ends a download that was cancelled before it finished. Waiters wake up with
+    // abandoned set and can begin the download again themselves.
+    void abandonDownload(const juce::File& targetFile);
+
+    // Accounts for bytes a transfer has just received against the bandwidth cap, waiting as
+    // long as the cap requires. Returns false if shouldAbort() became true while waiting.
+    bool consumeBandwidth(int64 numBytes, const std::function<bool()>& shouldAbort);
+
+    // Combined rate of every transfer in the process, in bytes per second; 0 = unlimited
+    void setBandwidthLimit(int64 bytesPerSecond);
+    int64 getBandwidthLimit() const { return bandwidthLimit.load(); }
+
+    void setMaxConcurrentDownloads(int maxDownloads);
+    int getMaxConcurrentDownloads() const { return maxConcurrentDownloads.load(); }
+    int getNumActiveDownloads() const { return activeDownloads.load(); }
+    int getNumDeduplicatedDownloads() const { return deduplicatedDownloads.load(); }
+
+    // Marks a download journal as in use by a manager of this process. Returns false if
+    // another one holds it already.
+    bool claimJournal(const juce::File& journal);
+    void releaseJournal(const juce::File& journal);
+
+    // Interactive downloads queued or running anywhere in the process; background
+    // downloads hold back while this is non-zero
+    std::atomic<int>& getInteractiveDownloadCount() { return interactiveDownloads; }
+
+private:
+    std::shared_ptr<SharedDownload> removeDownload(const juce::File& targetFile);
+
+    juce::CriticalSection lock;
+    juce::WaitableEvent slotFreed;
+    std::array<int, numPriorities> waitingByPriority {};
+    std::map<juce::String, std::shared_ptr<SharedDownload>> downloadsInFlight;
+    juce::StringArray journalsInUse;
+
+    // Token bucket for the bandwidth cap; the balance goes negative when a read overdraws it
+    juce::CriticalSection bandwidthLock;
+    double bandwidthTokens = 0.0;
+    double lastRefillMs = 0.0;
+    std::atomic<int64> bandwidthLimit { 0 };
+
+    std::atomic<int> maxConcurrentDownloads { 8 };
+    std::atomic<int> activeDownloads { 0 };
+    std::atomic<int> deduplicatedDownloads { 0 };
+    std::atomic<int> interactiveDownloads { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DownloadService)
+};
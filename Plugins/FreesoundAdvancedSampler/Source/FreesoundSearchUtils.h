@@ -7,20 +7,63 @@
 
 using namespace juce;
 
-inline std::pair<Array<FSSound>, std::vector<juce::StringArray>> makeQuerySearchUsingFreesoundAPI (const String& masterQuery, int numSoundsNeeded, bool shuffleResults = true) {
+// Fields requested for every search made by the sampler
+static const String SAMPLER_SEARCH_FIELDS = "id,name,username,license,previews,tags,description";
 
-  // Use the existing Freesound search system
-    FreesoundClient client(FREESOUND_API_KEY);
+// Picks numSoundsNeeded sounds out of the search results (shuffled and cycled if needed)
+// together with the per-sound info shown on the pads. The results stay compact while they
+// are shuffled, only the picked sounds are expanded into FSSound
+inline std::pair<Array<FSSound>, std::vector<juce::StringArray>> selectSoundsFromSearchResults (Array<FSCompactSound> sounds, const String& masterQuery, int numSoundsNeeded, bool shuffleResults = true) {
 
     Array<FSSound> finalSounds;
     std::vector<juce::StringArray> soundInfo;
 
-    try
+    // 1. Handle no results case
+    if (sounds.isEmpty())
     {
-        // Request more results than we need to have variety for shuffling
-        // Use page_size parameter (5th parameter) to get multiple results
-        int requestedResults = jmax(numSoundsNeeded * 2, 50); // Request at least 50 or 2x what we need
+        DBG("No results found for query: " + masterQuery);
+        return { finalSounds, soundInfo };
+    }
+
+    // 3. Shuffle results if more than one sound found
+    if (shuffleResults && sounds.size() > 1)
+    {
+        std::random_device rd;
+        std::mt19937 g(rd());
+        std::shuffle(sounds.begin(), sounds.end(), g);
+    }
 
+    // 4. downsample or repeat in a cycling manner to fill the required number
+    for (int i = 0; i < numSoundsNeeded; ++i)
+    {
+        int sourceIndex = i % sounds.size(); // Cycle through available sounds
+        const FSCompactSound& sound = sounds.getReference(sourceIndex);
+        finalSounds.add(sound.toFSSound());
+
+        // Create sound info for each repeated sound
+        StringArray info;
+        info.add(sound.name);                             // index 0
+        info.add(sound.username);                         // index 1
+        info.add(sound.license);                          // index 2
+        info.add(sound.tags.joinIntoString(","));      // index 3
+        info.add(sound.description);                      // index 4
+        info.add(masterQuery); // Store the master query             // index 5
+
+        soundInfo.push_back(info);
+    }
+
+    DBG("Tags for first sound: " + finalSounds[0].tags.joinIntoString(","));
+
+    return { finalSounds, soundInfo };
+}
+
+inline std::pair<Array<FSSound>, std::vector<juce::StringArray>> makeQuerySearchUsingFreesoundAPI (const String& masterQuery, int numSoundsNeeded, bool shuffleResults = true) {
+
+  // Use the existing Freesound search system
+    FreesoundClient client(FREESOUND_API_KEY);
+
+    try
+    {
         SoundList list = client.textSearch(
             masterQuery,
             "duration:[0 TO 0.5]",
@@ -28,55 +71,46 @@ inline std::pair<Array<FSSound>, std::vector<juce::StringArray>> makeQuerySearch
             1,
             1,
             10000,
-            "id,name,username,license,previews,tags,description"
+            SAMPLER_SEARCH_FIELDS
         );
 
-        Array<FSSound> sounds = list.toArrayOfSounds();
-
-        // 1. Handle no results case
-        if (sounds.isEmpty())
-        {
-            DBG("No results found for query: " + masterQuery);
-            return { finalSounds, soundInfo };
-        }
-
-        // 3. Shuffle results if more than one sound found
-        if (shuffleResults && sounds.size() > 1)
-        {
-            std::random_device rd;
-            std::mt19937 g(rd());
-            std::shuffle(sounds.begin(), sounds.end(), g);
-        }
-
-        // 4. downsample or repeat in a cycling manner to fill the required number
-        for (int i = 0; i < numSoundsNeeded; ++i)
-        {
-            int sourceIndex = i % sounds.size(); // Cycle through available sounds
-            finalSounds.add(sounds[sourceIndex]);
-
-            // Create sound info for each repeated sound
-            StringArray info;
-            info.add(sounds[sourceIndex].name);                             // index 0
-            info.add(sounds[sourceIndex].user);                             // index 1
-            info.add(sounds[sourceIndex].license);                          // index 2
-            info.add(sounds[sourceIndex].tags.joinIntoString(","));      // index 3
-            info.add(sounds[sourceIndex].description);                      // index 4
-            info.add(masterQuery); // Store the master query             // index 5
-
-            soundInfo.push_back(info);
-        }
+        return selectSoundsFromSearchResults(list.toArrayOfCompactSounds(), masterQuery, numSoundsNeeded, shuffleResults);
     }
     catch (const std::exception& e)
     {
       DBG("Error during Freesound search: " + String(e.what()));
     }
 
-    DBG("Tags for first sound: " + finalSounds[0].tags.joinIntoString(","));
-
-    return { finalSounds, soundInfo };
+    return {};
 
     // to access the return, use the following code
 
 }
 
+// Same search as makeQuerySearchUsingFreesoundAPI, but run on the Freesound client's worker
+// pool. onResults is called on the message thread once the results are ready; the returned
+// handle can be used to cancel the search (e.g. when the component that started it goes away).
+// By default the sounds are picked from one large page of results; callers that only need a
+// few sounds can ask for a smaller page.
+inline FSAsyncHandle<SoundList> makeQuerySearchUsingFreesoundAPIAsync (const String& masterQuery, int numSoundsNeeded, bool shuffleResults,
+    std::function<void(Array<FSSound>, std::vector<juce::StringArray>)> onResults, int page = 1, int pageSize = 10000) {
 
+    FreesoundClient client(FREESOUND_API_KEY);
+
+    auto handle = client.textSearchAsync(
+        masterQuery,
+        "duration:[0 TO 0.5]",
+        "score",
+        1,
+        page,
+        pageSize,
+        SAMPLER_SEARCH_FIELDS
+    );
+
+    handle.then([masterQuery, numSoundsNeeded, shuffleResults, onResults](SoundList list) {
+        auto [finalSounds, soundInfo] = selectSoundsFromSearchResults(list.toArrayOfCompactSounds(), masterQuery, numSoundsNeeded, shuffleResults);
+        onResults(finalSounds, soundInfo);
+    });
+
+    return handle;
+}
@@ -490,11 +490,17 @@ void MasterSearchPanel::updateDownloadProgress(const AudioDownloadManager::Downl
     {
         currentProgress = progress.overallProgress;
 
-        String statusText = "Downloading " + progress.currentFileName +
+        String fileText = progress.activeFiles > 1 ? String(progress.activeFiles) + " files"
+                                                    : progress.currentFileName;
+
+        String statusText = "Downloading " + fileText +
                            " (" + String(progress.completedFiles) +
                            "/" + String(progress.totalFiles) + ") - " +
                            String((int)(progress.overallProgress * 100)) + "%";
 
+        if (progress.bytesPerSecond > 0)
+            statusText << " - " << File::descriptionOfSizeInBytes(progress.bytesPerSecond) << "/s";
+
         statusLabel.setText(statusText, dontSendNotification);
         showProgress(true);
         cancelButton.setEnabled(true);
@@ -0,0 +1,216 @@
+#include "PadCandidatePool.h"
+#include "FreesoundSearchUtils.h"
+
+PadCandidatePool::PadCandidatePool(const File& folder, int numCandidates)
+    : candidatesFolder(folder), candidatesPerQuery(jmax(1, numCandidates))
+{
+    candidatesFolder.createDirectory();
+    downloadManager.addListener(this);
+}
+
+PadCandidatePool::~PadCandidatePool()
+{
+    // Once the downloads are cancelled no worker is left to call the listener
+    downloadManager.cancelDownloads();
+    downloadManager.removeListener(this);
+}
+
+bool PadCandidatePool::takeCandidate(const String& query, const String& excludeId, const File& targetFolder,
+                                     FSSound& sound, File& audioFile)
+{
+    QueryPool& pool = getPool(query);
+
+    for (int i = 0; i < pool.ready.size(); ++i)
+    {
+        const FSSound candidate = pool.ready.getReference(i);
+
+        if (candidate.id == excludeId)
+            continue;
+
+        const File candidateFile = getCandidateFile(candidate);
+        const File targetFile = targetFolder.getChildFile(candidateFile.getFileName());
+        pool.ready.remove(i--);
+
+        // The sample may have reached the samples folder some other way in the meantime
+        if (targetFile.existsAsFile())
+            candidateFile.deleteFile();
+        else if (!candidateFile.moveFileTo(targetFile))
+            continue;
+
+        sound = candidate;
+        audioFile = targetFile;
+        return true;
+    }
+
+    return false;
+}
+
+void PadCandidatePool::refill(const String& query)
+{
+    if (query.trim().isEmpty())
+        return;
+
+    QueryPool& pool = getPool(query);
+
+    if (pool.searching || pool.ready.size() + pool.pending.size() >= candidatesPerQuery)
+        return;
+
+    pool.searching = true;
+
+    // A small page of results is plenty for a few candidates, and keeps prefetching from
+    // spending the API request budget on pages of thousands of sounds. Each refill takes
+    // the next page, so candidates don't repeat.
+    WeakReference<PadCandidatePool> weakThis(this);
+    const String key = getKey(query);
+
+    makeQuerySearchUsingFreesoundAPIAsync(query, refillPageSize, true,
+        [weakThis, key](Array<FSSound> sounds, std::vector<StringArray>)
+        {
+            if (auto* candidatePool = weakThis.get())
+                candidatePool->addSearchResults(key, sounds);
+        },
+        pool.nextPage, refillPageSize);
+}
+
+PadCandidatePool::QueryPool& PadCandidatePool::getPool(const String& query)
+{
+    const String key = getKey(query);
+
+    recentQueries.removeString(key);
+    recentQueries.add(key);
+
+    QueryPool& pool = pools[key];
+    pool.query = query;
+
+    evictOldestQueries();
+    return pool;
+}
+
+void PadCandidatePool::addSearchResults(const String& key, const Array<FSSound>& sounds)
+{
+    auto it = pools.find(key);
+
+    // Evicted while searching
+    if (it == pools.end())
+        return;
+
+    QueryPool& pool = it->second;
+    pool.searching = false;
+
+    // Short results are cycled to fill the page; once a page runs short (or past the
+    // end of the results) the next refill starts from the first page again
+    StringArray distinctIds;
+    for (const auto& sound : sounds)
+        distinctIds.addIfNotAlreadyThere(sound.id);
+
+    pool.nextPage = distinctIds.size() < refillPageSize ? 1 : pool.nextPage + 1;
+
+    auto isPooled = [&pool](const FSSound& sound)
+    {
+        auto sameId = [&sound](const FSSound& other) { return other.id == sound.id; };
+        return std::any_of(pool.ready.begin(), pool.ready.end(), sameId)
+            || std::any_of(pool.pending.begin(), pool.pending.end(), sameId);
+    };
+
+    Array<FSSound> soundsToDownload;
+
+    for (const auto& sound : sounds)
+    {
+        if (pool.ready.size() + pool.pending.size() >= candidatesPerQuery)
+            break;
+
+        if (sound.id.isEmpty() || isPooled(sound))
+            continue;
+
+        // Left over from an earlier session
+        if (getCandidateFile(sound).existsAsFile())
+        {
+            pool.ready.add(sound);
+            continue;
+        }
+
+        pool.pending.add(sound);
+        soundsToDownload.add(sound);
+    }
+
+    if (!soundsToDownload.isEmpty())
+        downloadManager.enqueueDownloads(soundsToDownload, candidatesFolder, pool.query,
+                                         AudioDownloadManager::Priority::Background);
+}
+
+void PadCandidatePool::evictOldestQueries()
+{
+    while (recentQueries.size() > maxQueries)
+    {
+        auto it = pools.find(recentQueries[0]);
+        recentQueries.remove(0);
+
+        if (it == pools.end())
+            continue;
+
+        const QueryPool evicted = it->second;
+        pools.erase(it);
+
+        // Pools of other queries may share a sound, and with it its file and its download
+        for (const auto& sound : evicted.ready)
+            if (!isPooled(sound.id))
+                getCandidateFile(sound).deleteFile();
+
+        for (const auto& sound : evicted.pending)
+            if (!isPooled(sound.id))
+                downloadManager.removeFromQueue(sound.id);
+    }
+}
+
+bool PadCandidatePool::isPooled(const String& soundId) const
+{
+    auto sameId = [&soundId](const FSSound& sound) { return sound.id == soundId; };
+
+    for (const auto& entry : pools)
+        if (std::any_of(entry.second.ready.begin(), entry.second.ready.end(), sameId)
+            || std::any_of(entry.second.pending.begin(), entry.second.pending.end(), sameId))
+            return true;
+
+    return false;
+}
+
+File PadCandidatePool::getCandidateFile(const FSSound& sound) const
+{
+    return candidatesFolder.getChildFile("FS_ID_" + sound.id + ".ogg");
+}
+
+void PadCandidatePool::soundDownloadFinished(const FSSound& sound, const File&, bool success)
+{
+    // Called on a download thread
+    MessageManager::callAsync([weakThis = weakThisForDownloads, sound, success]
+    {
+        if (auto* candidatePool = weakThis.get())
+            candidatePool->handleCandidateDownloaded(sound, success);
+    });
+}
+
+void PadCandidatePool::handleCandidateDownloaded(const FSSound& sound, bool success)
+{
+    for (auto& entry : pools)
+    {
+        QueryPool& pool = entry.second;
+
+        for (int i = 0; i < pool.pending.size(); ++i)
+        {
+            if (pool.pending.getReference(i).id != sound.id)
+                continue;
+
+            const FSSound candidate = pool.pending.removeAndReturn(i);
+
+            if (success && getCandidateFile(candidate).existsAsFile())
+                pool.ready.add(candidate);
+
+            return;
+        }
+    }
+
+    // Its pool was evicted while it downloaded. Keep the file only if another pool has
+    // the same sound ready, as they share it.
+    if (!isPooled(sound.id))
+        getCandidateFile(sound).deleteFile();
+}
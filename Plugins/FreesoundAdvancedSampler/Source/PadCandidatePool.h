@@ -0,0 +1,66 @@
+#pragma once
+
+#include "shared_plugin_helpers/shared_plugin_helpers.h"
+#include "FreesoundAPI/FreesoundAPI.h"
+#include "AudioDownloadManager.h"
+
+//==============================================================================
+// A few already downloaded alternatives for each pad query, so that re-searching a pad
+// can swap in a local sample at once instead of waiting for a search and a download.
+// Pools are filled in the background with spare bandwidth (background downloads yield to
+// everything else) and refilled after each candidate is taken. Message thread only.
+class PadCandidatePool : private AudioDownloadManager::Listener
+{
+public:
+    PadCandidatePool(const File& candidatesFolder, int candidatesPerQuery = 3);
+    ~PadCandidatePool() override;
+
+    // Hands out a downloaded candidate for the query other than excludeId, moving its file
+    // into targetFolder. Returns false when the pool has nothing ready for the query yet.
+    bool takeCandidate(const String& query, const String& excludeId, const File& targetFolder,
+                       FSSound& sound, File& audioFile);
+
+    // Tops the pool of the query up in the background
+    void refill(const String& query);
+
+private:
+    struct QueryPool
+    {
+        String query;
+        Array<FSSound> ready;
+        Array<FSSound> pending;     // being downloaded
+        bool searching = false;
+        int nextPage = 1;           // refills walk through the results a small page at a time
+    };
+
+    static constexpr int maxQueries = 16;
+    static constexpr int refillPageSize = 15;
+
+    QueryPool& getPool(const String& query);
+    void addSearchResults(const String& key, const Array<FSSound>& sounds);
+    void evictOldestQueries();
+    bool isPooled(const String& soundId) const;
+    File getCandidateFile(const FSSound& sound) const;
+    static String getKey(const String& query) { return query.trim().toLowerCase(); }
+
+    // AudioDownloadManager::Listener
+    void downloadProgressChanged(const AudioDownloadManager::DownloadProgress&) override {}
+    void downloadCompleted(bool) override {}
+    void soundDownloadFinished(const FSSound& sound, const File& file, bool success) override;
+    void handleCandidateDownloaded(const FSSound& sound, bool success);
+
+    File candidatesFolder;
+    const int candidatesPerQuery;
+
+    std::map<String, QueryPool> pools;
+    StringArray recentQueries;      // pool keys, most recently used last
+
+    // Declared before the manager so that it outlives it. The weak reference is made here,
+    // on the message thread, and only copied by the download workers.
+    JUCE_DECLARE_WEAK_REFERENCEABLE(PadCandidatePool)
+    WeakReference<PadCandidatePool> weakThisForDownloads { this };
+
+    AudioDownloadManager downloadManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PadCandidatePool)
+};
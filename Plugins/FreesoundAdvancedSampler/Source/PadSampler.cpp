@@ -0,0 +1,642 @@
+#include "PadSampler.h"
+
+//==============================================================================
+// PadSound
+//==============================================================================
+
+PadSound::PadSound(int midiNote, const ADSR::Parameters& envelopeToUse)
+    : midiRootNote(midiNote), envelope(envelopeToUse)
+{
+}
+
+PadSound::~PadSound()
+{
+    if (current != nullptr)
+        current->decReferenceCount();
+}
+
+bool PadSound::appliesToNote(int midiNoteNumber)
+{
+    // An empty pad does not take a voice
+    return midiNoteNumber == midiRootNote && current != nullptr;
+}
+
+DecodedSample* PadSound::exchangeSample(DecodedSample* newSample) noexcept
+{
+    std::swap(current, newSample);
+    return newSample;
+}
+
+//==============================================================================
+// SampleStream
+//==============================================================================
+
+bool SampleStream::start(DecodedSample& sample) noexcept
+{
+    if (commandFifo.getFreeSpace() < 1)
+        return false;
+
+    if (++requestedGeneration == 0)
+        ++requestedGeneration;
+
+    // The streamer takes over this reference
+    sample.incReferenceCount();
+
+    int s1, z1, s2, z2;
+    commandFifo.prepareToWrite(1, s1, z1, s2, z2);
+    commands[(size_t) (z1 > 0 ? s1 : s2)] = { &sample, requestedGeneration };
+    commandFifo.finishedWrite(1);
+
+    ringStartFrame = sample.getLength();
+    size1 = size2 = 0;
+    return true;
+}
+
+void SampleStream::stop() noexcept
+{
+    if (++requestedGeneration == 0)
+        ++requestedGeneration;
+
+    size1 = size2 = 0;
+
+    // If the queue is full, the next start() stops the current stream anyway
+    if (commandFifo.getFreeSpace() < 1)
+        return;
+
+    int s1, z1, s2, z2;
+    commandFifo.prepareToWrite(1, s1, z1, s2, z2);
+    commands[(size_t) (z1 > 0 ? s1 : s2)] = { nullptr, requestedGeneration };
+    commandFifo.finishedWrite(1);
+}
+
+void SampleStream::beginBlock() noexcept
+{
+    if (ringGeneration.load() != requestedGeneration)
+    {
+        size1 = size2 = 0;
+        return;
+    }
+
+    ringFifo.prepareToRead(ringFifo.getNumReady(), start1, size1, start2, size2);
+}
+
+bool SampleStream::getFrame(int64 frame, float& left, float& right) const noexcept
+{
+    const int64 offset = frame - ringStartFrame;
+
+    if (offset < 0 || offset >= size1 + size2)
+        return false;
+
+    const int index = offset < size1 ? start1 + (int) offset : start2 + (int) offset - size1;
+    left = ring.getSample(0, index);
+    right = ring.getSample(1, index);
+    return true;
+}
+
+void SampleStream::endBlock(int64 firstFrameNeeded) noexcept
+{
+    // stop() may have been called during the block
+    if (ringGeneration.load() != requestedGeneration)
+        return;
+
+    const int numToFree = (int) jlimit((int64) 0, (int64) (size1 + size2), firstFrameNeeded - ringStartFrame);
+    ringFifo.finishedRead(numToFree);
+    ringStartFrame += numToFree;
+    size1 = size2 = 0;
+}
+
+//==============================================================================
+// PadSamplerVoice
+//==============================================================================
+
+bool PadSamplerVoice::canPlaySound(SynthesiserSound* sound)
+{
+    return dynamic_cast<const PadSound*>(sound) != nullptr;
+}
+
+void PadSamplerVoice::startNote(int midiNoteNumber, float velocity, SynthesiserSound* s, int)
+{
+    auto* sound = dynamic_cast<const PadSound*>(s);
+    playingSample = sound != nullptr ? sound->getCurrentSample() : nullptr;
+
+    // The pad was emptied between the note being assigned and starting
+    if (playingSample == nullptr || playingSample->getLength() <= 0)
+    {
+        endNote();
+        return;
+    }
+
+    pitchRatio = std::pow(2.0, (midiNoteNumber - sound->getMidiRootNote()) / 12.0)
+                 * playingSample->getSourceSampleRate() / getSampleRate();
+
+    const auto& data = playingSample->getAudioData();
+    headL = data.getReadPointer(0);
+    headR = data.getNumChannels() > 1 ? data.getReadPointer(1) : nullptr;
+
+    // Long samples play on past their head from the stream
+    streaming = playingSample->canStream() && stream != nullptr && stream->start(*playingSample);
+    playLength = streaming ? playingSample->getSourceLength() : (int64) playingSample->getLength();
+
+    sourceSamplePosition = 0.0;
+    lgain = velocity;
+    rgain = velocity;
+
+    adsr.setSampleRate(getSampleRate());
+    adsr.setParameters(sound->getEnvelope());
+    adsr.noteOn();
+}
+
+void PadSamplerVoice::stopNote(float, bool allowTailOff)
+{
+    if (allowTailOff)
+    {
+        adsr.noteOff();
+    }
+    else
+    {
+        adsr.reset();
+        endNote();
+    }
+}
+
+void PadSamplerVoice::endNote()
+{
+    clearCurrentNote();
+
+    if (streaming)
+        stream->stop();
+
+    streaming = false;
+
+    // The pad or the loader's retired list holds another reference, so this never frees
+    // the sample
+    playingSample = nullptr;
+}
+
+void PadSamplerVoice::renderNextBlock(AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
+{
+    if (playingSample == nullptr)
+        return;
+
+    if (streaming)
+        stream->beginBlock();
+
+    float* outL = outputBuffer.getWritePointer(0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer(1, startSample) : nullptr;
+
+    while (--numSamples >= 0)
+    {
+        const int64 pos = (int64) sourceSamplePosition;
+        const float alpha = (float) (sourceSamplePosition - (double) pos);
+        const float invAlpha = 1.0f - alpha;
+
+        float l0, r0, l1, r1;
+        readFrame(pos, l0, r0);
+        readFrame(pos + 1, l1, r1);
+
+        // Simple linear interpolation, as SamplerVoice does
+        float l = l0 * invAlpha + l1 * alpha;
+        float r = r0 * invAlpha + r1 * alpha;
+
+        const float envelopeValue = adsr.getNextSample();
+        l *= lgain * envelopeValue;
+        r *= rgain * envelopeValue;
+
+        if (outR != nullptr)
+        {
+            *outL++ += l;
+            *outR++ += r;
+        }
+        else
+        {
+            *outL++ += (l + r) * 0.5f;
+        }
+
+        sourceSamplePosition += pitchRatio;
+
+        if (sourceSamplePosition > (double) playLength || !adsr.isActive())
+        {
+            stopNote(0.0f, false);
+            break;
+        }
+    }
+
+    if (streaming)
+        stream->endBlock((int64) sourceSamplePosition);
+}
+
+void PadSamplerVoice::readFrame(int64 frame, float& left, float& right) const noexcept
+{
+    // The head has a few frames of padding past its length, which is as far as notes that
+    // don't stream read
+    if (!streaming || frame < playingSample->getLength())
+    {
+        left = headL[frame];
+        right = headR != nullptr ? headR[frame] : left;
+        return;
+    }
+
+    // Silence if the stream has fallen behind
+    if (!stream->getFrame(frame, left, right))
+        left = right = 0.0f;
+}
+
+//==============================================================================
+// PadSampleLoader
+//==============================================================================
+
+PadSampleLoader::PadSampleLoader(int slots)
+    : Thread("PadSampleLoader"),
+      numSlots(jlimit(1, maxSlots, slots)),
+      slotSamples((size_t) numSlots),
+      slotTags((size_t) numSlots, 0)
+{
+    startThread();
+}
+
+PadSampleLoader::~PadSampleLoader()
+{
+    stopThread(4000);
+
+    // Whatever is still in flight only holds references, which can go now that nothing
+    // plays any more
+    int start1, size1, start2, size2;
+    mailbox.prepareToRead(mailbox.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i)
+        if (auto* sample = deliveries[(size_t) (start1 + i)].sample)
+            sample->decReferenceCount();
+
+    for (int i = 0; i < size2; ++i)
+        if (auto* sample = deliveries[(size_t) (start2 + i)].sample)
+            sample->decReferenceCount();
+
+    mailbox.finishedRead(size1 + size2);
+    collectRetiredSamples();
+}
+
+void PadSampleLoader::load(int slot, const String& freesoundId, const File& audioFile, int tag)
+{
+    Request request;
+    request.type = RequestType::Load;
+    request.slot = slot;
+    request.freesoundId = freesoundId;
+    request.audioFile = audioFile;
+    request.tag = tag;
+
+    const ScopedLock sl(requestLock);
+    requests.add(request);
+    notify();
+}
+
+void PadSampleLoader::loadPartial(int slot, const String& freesoundId, const MemoryBlock& oggData)
+{
+    Request request;
+    request.type = RequestType::LoadPartial;
+    request.slot = slot;
+    request.freesoundId = freesoundId;
+    request.oggData = oggData;
+
+    const ScopedLock sl(requestLock);
+    requests.add(request);
+    notify();
+}
+
+void PadSampleLoader::clear(int slot)
+{
+    Request request;
+    request.type = RequestType::Clear;
+    request.slot = slot;
+
+    const ScopedLock sl(requestLock);
+    requests.add(request);
+    notify();
+}
+
+void PadSampleLoader::swap(int slotA, int slotB)
+{
+    Request request;
+    request.type = RequestType::Swap;
+    request.slot = slotA;
+    request.otherSlot = slotB;
+
+    const ScopedLock sl(requestLock);
+    requests.add(request);
+    notify();
+}
+
+void PadSampleLoader::applyPublishedSamples(PadSound* const* pads) noexcept
+{
+    // Only as many as there is room to retire, the rest wait for the next block
+    const int numToApply = jmin(mailbox.getNumReady(), retireFifo.getFreeSpace());
+
+    if (numToApply <= 0)
+        return;
+
+    int start1, size1, start2, size2;
+    mailbox.prepareToRead(numToApply, start1, size1, start2, size2);
+
+    int rStart1, rSize1, rStart2, rSize2;
+    retireFifo.prepareToWrite(size1 + size2, rStart1, rSize1, rStart2, rSize2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        const Delivery& delivery = deliveries[(size_t) (i < size1 ? start1 + i : start2 + i - size1)];
+        DecodedSample* previous = pads[delivery.slot]->exchangeSample(delivery.sample);
+        appliedTags[(size_t) delivery.slot].store(delivery.tag);
+
+        retiredFromAudio[(size_t) (i < rSize1 ? rStart1 + i : rStart2 + i - rSize1)] = previous;
+    }
+
+    retireFifo.finishedWrite(size1 + size2);
+    mailbox.finishedRead(size1 + size2);
+}
+
+void PadSampleLoader::run()
+{
+    while (!threadShouldExit())
+    {
+        collectRetiredSamples();
+        releaseUnusedSamples();
+
+        Request request;
+        if (takeNextRequest(request))
+            handleRequest(request);
+        else
+            wait(50); // also how often retired samples are looked at
+    }
+}
+
+bool PadSampleLoader::takeNextRequest(Request& request)
+{
+    const ScopedLock sl(requestLock);
+
+    while (!requests.isEmpty())
+    {
+        request = requests.removeAndReturn(0);
+
+        if (request.type == RequestType::Swap)
+            return true;
+
+        // Skip it if a later request replaces what this slot gets anyway
+        bool superseded = false;
+
+        for (const auto& later : requests)
+        {
+            if (later.type == RequestType::Swap)
+            {
+                if (later.slot == request.slot || later.otherSlot == request.slot)
+                    break;
+
+                continue;
+            }
+
+            if (later.slot == request.slot)
+            {
+                superseded = true;
+                break;
+            }
+        }
+
+        if (!superseded)
+            return true;
+    }
+
+    return false;
+}
+
+void PadSampleLoader::handleRequest(const Request& request)
+{
+    if (!isPositiveAndBelow(request.slot, numSlots))
+        return;
+
+    auto& current = slotSamples[(size_t) request.slot];
+
+    switch (request.type)
+    {
+        case RequestType::Clear:
+            if (current != nullptr)
+                publish(request.slot, nullptr, request.tag);
+            break;
+
+        case RequestType::Swap:
+        {
+            if (!isPositiveAndBelow(request.otherSlot, numSlots) || request.otherSlot == request.slot)
+                break;
+
+            DecodedSample::Ptr sampleA = current;
+            DecodedSample::Ptr sampleB = slotSamples[(size_t) request.otherSlot];
+            publish(request.slot, sampleB, 0);
+            publish(request.otherSlot, sampleA, 0);
+            break;
+        }
+
+        case RequestType::Load:
+        {
+            DecodedSample::Ptr sample;
+
+            if (request.audioFile.existsAsFile())
+                sample = pool->getSample(request.freesoundId, request.audioFile);
+
+            // Keep the playable start of a sample that is still downloading
+            if (sample == nullptr && current != nullptr && current->getFreesoundId() == request.freesoundId)
+                break;
+
+            publish(request.slot, sample, request.tag);
+            break;
+        }
+
+        case RequestType::LoadPartial:
+        {
+            // Never go back from the complete sample to a part of it
+            if (current != nullptr && current->isComplete() && current->getFreesoundId() == request.freesoundId)
+                break;
+
+            // The Ogg reader takes the length from the last complete page it finds, so a
+            // truncated file decodes up to there
+            OggVorbisAudioFormat oggFormat;
+            std::unique_ptr<AudioFormatReader> reader(oggFormat.createReaderFor(new MemoryInputStream(request.oggData, false), true));
+
+            if (reader != nullptr && reader->lengthInSamples > 0)
+                publish(request.slot, new DecodedSample(request.freesoundId, *reader, DecodedSamplePool::preloadLength, false), request.tag);
+            break;
+        }
+    }
+}
+
+void PadSampleLoader::publish(int slot, DecodedSample::Ptr sample, int tag)
+{
+    // Reloading a pad with the sample it already has (setSources does so after every
+    // download) changes nothing
+    if (sample == slotSamples[(size_t) slot] && tag == slotTags[(size_t) slot])
+        return;
+
+    // Wait for the audio thread to make room; it empties the mailbox every block
+    while (mailbox.getFreeSpace() == 0)
+    {
+        if (threadShouldExit())
+            return;
+
+        collectRetiredSamples();
+        wait(5);
+    }
+
+    slotSamples[(size_t) slot] = sample;
+    slotTags[(size_t) slot] = tag;
+
+    // The reference the delivery carries is handed to the pad
+    if (sample != nullptr)
+        sample->incReferenceCount();
+
+    int start1, size1, start2, size2;
+    mailbox.prepareToWrite(1, start1, size1, start2, size2);
+    deliveries[(size_t) (size1 > 0 ? start1 : start2)] = { slot, sample.get(), tag };
+    mailbox.finishedWrite(1);
+}
+
+void PadSampleLoader::collectRetiredSamples()
+{
+    int start1, size1, start2, size2;
+    retireFifo.prepareToRead(retireFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
+    {
+        if (auto* sample = retiredFromAudio[(size_t) (i < size1 ? start1 + i : start2 + i - size1)])
+        {
+            // Take over the reference the pad held. A sample can be retired more than once
+            // (two pads play it, or it was swapped and then replaced) but is only listed
+            // once, so that releaseUnusedSamples() sees the count it expects.
+            retired.addIfNotAlreadyThere(sample);
+            sample->decReferenceCount();
+        }
+    }
+
+    retireFifo.finishedRead(size1 + size2);
+}
+
+void PadSampleLoader::releaseUnusedSamples()
+{
+    // Only this list (and the pool) still refer to these; a retired sample can't be picked
+    // up by a new note, as voices only take the current sample of a pad. The pool only
+    // lets go of samples nobody else refers to, so a voice never frees a pooled sample.
+    retired.removeIf([](const DecodedSample::Ptr& sample)
+    {
+        return sample->getReferenceCount() == (sample->isPooled() ? 2 : 1);
+    });
+}
+
+//==============================================================================
+// PadSampleStreamer
+//==============================================================================
+
+PadSampleStreamer::PadSampleStreamer(int numStreams)
+    : Thread("PadSampleStreamer")
+{
+    for (int i = 0; i < numStreams; ++i)
+        streams.add(new SampleStream());
+
+    formatManager.registerBasicFormats();
+
+    // Above the loader: a stream that falls behind is heard
+    startThread(7);
+}
+
+PadSampleStreamer::~PadSampleStreamer()
+{
+    stopThread(4000);
+
+    // Lets go of the references that queued requests still carry
+    for (auto* stream : streams)
+    {
+        int s1, z1, s2, z2;
+        stream->commandFifo.prepareToRead(stream->commandFifo.getNumReady(), s1, z1, s2, z2);
+
+        for (int i = 0; i < z1 + z2; ++i)
+            if (auto* sample = stream->commands[(size_t) (i < z1 ? s1 + i : s2 + i - z1)].sample)
+                sample->decReferenceCount();
+
+        stream->commandFifo.finishedRead(z1 + z2);
+    }
+}
+
+void PadSampleStreamer::run()
+{
+    while (!threadShouldExit())
+    {
+        bool filledAny = false;
+
+        for (auto* stream : streams)
+        {
+            takeCommands(*stream);
+            filledAny = fill(*stream) || filledAny;
+        }
+
+        if (!filledAny)
+            wait(5);
+    }
+}
+
+void PadSampleStreamer::takeCommands(SampleStream& stream)
+{
+    const int numCommands = stream.commandFifo.getNumReady();
+
+    if (numCommands == 0)
+        return;
+
+    int s1, z1, s2, z2;
+    stream.commandFifo.prepareToRead(numCommands, s1, z1, s2, z2);
+
+    uint32 generation = 0;
+
+    // Only the last request counts
+    for (int i = 0; i < z1 + z2; ++i)
+    {
+        const auto& command = stream.commands[(size_t) (i < z1 ? s1 + i : s2 + i - z1)];
+        stream.streamingSample = command.sample;
+        generation = command.generation;
+
+        if (command.sample != nullptr)
+            command.sample->decReferenceCount();
+    }
+
+    stream.commandFifo.finishedRead(z1 + z2);
+
+    // The voice leaves the ring alone until the new generation is published, so it can be
+    // emptied from this side
+    stream.ringFifo.finishedRead(stream.ringFifo.getNumReady());
+    stream.reader.reset();
+
+    if (stream.streamingSample != nullptr)
+    {
+        stream.reader.reset(formatManager.createReaderFor(stream.streamingSample->getSourceFile()));
+        stream.nextFrame = stream.streamingSample->getLength();
+    }
+
+    stream.ringGeneration.store(generation);
+}
+
+bool PadSampleStreamer::fill(SampleStream& stream)
+{
+    if (stream.reader == nullptr || stream.streamingSample == nullptr)
+        return false;
+
+    const int numToRead = (int) jmin((int64) framesPerRead, (int64) stream.ringFifo.getFreeSpace(),
+                                     stream.streamingSample->getSourceLength() - stream.nextFrame);
+
+    if (numToRead <= 0)
+        return false;
+
+    int s1, z1, s2, z2;
+    stream.ringFifo.prepareToWrite(numToRead, s1, z1, s2, z2);
+
+    // Mono sources are read into both channels of the ring
+    if (z1 > 0)
+        stream.reader->read(&stream.ring, s1, z1, stream.nextFrame, true, true);
+
+    if (z2 > 0)
+        stream.reader->read(&stream.ring, s2, z2, stream.nextFrame + z1, true, true);
+
+    stream.nextFrame += z1 + z2;
+    stream.ringFifo.finishedWrite(z1 + z2);
+    return true;
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include "shared_plugin_helpers/shared_plugin_helpers.h"
+#include "DecodedSamplePool.h"
+
+using namespace juce;
+
+//==============================================================================
+// One pad of the sampler (or the preview). The pad stays in its Synthesiser for good; what
+// it plays is a DecodedSample that the audio thread exchanges when PadSampleLoader has a
+// new one, so a pad can change without taking the Synthesiser's lock or touching the
+// other pads.
+class PadSound : public SynthesiserSound
+{
+public:
+    PadSound(int midiNote, const ADSR::Parameters& envelope);
+    ~PadSound() override;
+
+    bool appliesToNote(int midiNoteNumber) override;
+    bool appliesToChannel(int) override { return true; }
+
+    // Audio thread only: the sample a note starting now plays, or nullptr while the pad
+    // is empty
+    DecodedSample* getCurrentSample() const noexcept { return current; }
+
+    // Audio thread only: takes over the reference that comes with newSample and returns
+    // the previous sample together with its reference, for retiring elsewhere
+    DecodedSample* exchangeSample(DecodedSample* newSample) noexcept;
+
+    int getMidiRootNote() const { return midiRootNote; }
+    const ADSR::Parameters& getEnvelope() const { return envelope; }
+
+private:
+    const int midiRootNote;
+    const ADSR::Parameters envelope;
+    DecodedSample* current = nullptr;   // holds one reference
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PadSound)
+};
+
+//==============================================================================
+// The part of a sample past its preloaded head, streamed for one voice. The voice asks for
+// a sample on the audio thread and reads its frames from a lock-free ring buffer, which
+// PadSampleStreamer's thread keeps filled ahead of it from the sample's file.
+class SampleStream
+{
+public:
+    SampleStream() = default;
+
+    // Audio thread. start() returns false when the request could not be queued, in which
+    // case the voice only plays the head.
+    bool start(DecodedSample& sample) noexcept;
+    void stop() noexcept;
+
+    // Audio thread: beginBlock() takes a snapshot of what has been streamed in so far,
+    // endBlock() frees everything before the first frame still needed
+    void beginBlock() noexcept;
+    bool getFrame(int64 frame, float& left, float& right) const noexcept;    // false if not streamed in yet
+    void endBlock(int64 firstFrameNeeded) noexcept;
+
+private:
+    friend class PadSampleStreamer;
+
+    struct Command
+    {
+        DecodedSample* sample = nullptr;    // carries one reference; nullptr stops streaming
+        uint32 generation = 0;
+    };
+
+    static constexpr int ringSize = 1 << 15;
+    static constexpr int numCommands = 8;
+
+    // Audio thread -> streamer
+    AbstractFifo commandFifo { numCommands };
+    std::array<Command, numCommands> commands {};
+
+    // Streamer -> audio thread. The ring only holds frames of the requested sample once
+    // ringGeneration matches the generation the voice asked for; until then the voice
+    // leaves the ring alone and the streamer may empty it.
+    AudioBuffer<float> ring { 2, ringSize };
+    AbstractFifo ringFifo { ringSize };
+    std::atomic<uint32> ringGeneration { 0 };
+
+    // Audio thread only
+    uint32 requestedGeneration = 0;
+    int64 ringStartFrame = 0;       // sample frame at the read position of the ring
+    int start1 = 0, size1 = 0, start2 = 0, size2 = 0;
+
+    // Streamer thread only
+    DecodedSample::Ptr streamingSample;
+    std::unique_ptr<AudioFormatReader> reader;
+    int64 nextFrame = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleStream)
+};
+
+//==============================================================================
+// Plays the sample of a PadSound, like SamplerVoice does for a SamplerSound. A note holds
+// on to the sample it started with, so exchanging the pad's sample never cuts it off.
+// With a SampleStream, notes of long samples play on past the preloaded head.
+class PadSamplerVoice : public SynthesiserVoice
+{
+public:
+    PadSamplerVoice() = default;
+
+    void setStream(SampleStream* streamToUse) { stream = streamToUse; }
+
+    bool canPlaySound(SynthesiserSound* sound) override;
+    void startNote(int midiNoteNumber, float velocity, SynthesiserSound* sound, int currentPitchWheelPosition) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+    void pitchWheelMoved(int) override {}
+    void controllerMoved(int, int) override {}
+    void renderNextBlock(AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+
+protected:
+    const DecodedSample* getPlayingSample() const { return playingSample.get(); }
+    int64 getPlayLength() const { return playLength; }   // frames this note can play
+
+private:
+    void endNote();
+    void readFrame(int64 frame, float& left, float& right) const noexcept;
+
+    DecodedSample::Ptr playingSample;
+    SampleStream* stream = nullptr;
+    bool streaming = false;
+    int64 playLength = 0;
+    const float* headL = nullptr;
+    const float* headR = nullptr;
+    double pitchRatio = 0.0;
+    double sourceSamplePosition = 0.0;
+    float lgain = 0.0f, rgain = 0.0f;
+    ADSR adsr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PadSamplerVoice)
+};
+
+//==============================================================================
+// Decodes pad samples on its own thread and hands them to the audio thread through a
+// lock-free mailbox that processBlock empties. Samples the audio thread swaps out come
+// back through a second FIFO and are freed here once no voice plays them any more, so
+// the audio thread never allocates, frees or waits for a lock.
+//
+// Requests are carried out in order, and a request that a later one for the same slot
+// makes pointless is skipped. Complete samples come from DecodedSamplePool, so a sample
+// that any pad or preview has loaded already is shared instead of decoded again.
+class PadSampleLoader : private Thread
+{
+public:
+    explicit PadSampleLoader(int numSlots);
+    ~PadSampleLoader() override;
+
+    // Requests, from any thread but the audio thread. The tag of a load comes back through
+    // getLastAppliedTag() once the audio thread has put the sample in place.
+    void load(int slot, const String& freesoundId, const File& audioFile, int tag = 0);
+    void loadPartial(int slot, const String& freesoundId, const MemoryBlock& oggData);
+    void clear(int slot);
+    void swap(int slotA, int slotB);
+
+    // Audio thread: puts the published samples into their pads (one PadSound per slot)
+    void applyPublishedSamples(PadSound* const* pads) noexcept;
+    int getLastAppliedTag(int slot) const noexcept { return appliedTags[(size_t) slot].load(); }
+
+private:
+    enum class RequestType { Load, LoadPartial, Clear, Swap };
+
+    struct Request
+    {
+        RequestType type = RequestType::Load;
+        int slot = 0;
+        int otherSlot = -1;     // Swap only
+        String freesoundId;
+        File audioFile;
+        MemoryBlock oggData;
+        int tag = 0;
+    };
+
+    struct Delivery
+    {
+        int slot = 0;
+        DecodedSample* sample = nullptr;    // carries one reference
+        int tag = 0;
+    };
+
+    static constexpr int fifoSize = 256;
+    static constexpr int maxSlots = 32;
+
+    void run() override;
+    bool takeNextRequest(Request& request);
+    void handleRequest(const Request& request);
+    void publish(int slot, DecodedSample::Ptr sample, int tag);
+    void collectRetiredSamples();
+    void releaseUnusedSamples();
+
+    const int numSlots;
+    SharedResourcePointer<DecodedSamplePool> pool;
+
+    CriticalSection requestLock;
+    Array<Request> requests;
+
+    // What each slot has been sent, as the loader thread sees it
+    std::vector<DecodedSample::Ptr> slotSamples;
+    std::vector<int> slotTags;
+
+    // Loader thread -> audio thread
+    AbstractFifo mailbox { fifoSize };
+    std::array<Delivery, fifoSize> deliveries;
+    std::array<std::atomic<int>, maxSlots> appliedTags {};
+
+    // Audio thread -> loader thread
+    AbstractFifo retireFifo { fifoSize };
+    std::array<DecodedSample*, fifoSize> retiredFromAudio {};
+    Array<DecodedSample::Ptr> retired;  // waiting for voices to let go
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PadSampleLoader)
+};
+
+//==============================================================================
+// Owns a SampleStream for each voice and fills them on its own thread, decoding from the
+// source files of the samples the voices play.
+class PadSampleStreamer : private Thread
+{
+public:
+    explicit PadSampleStreamer(int numStreams);
+    ~PadSampleStreamer() override;
+
+    SampleStream* getStream(int index) const { return streams[index]; }
+
+private:
+    static constexpr int framesPerRead = 4096;
+
+    void run() override;
+    void takeCommands(SampleStream& stream);
+    bool fill(SampleStream& stream);
+
+    OwnedArray<SampleStream> streams;
+    AudioFormatManager formatManager;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PadSampleStreamer)
+};
@@ -22,16 +22,15 @@ FreesoundAdvancedSamplerAudioProcessor::TrackingSamplerVoice::TrackingSamplerVoi
 
 void FreesoundAdvancedSamplerAudioProcessor::TrackingSamplerVoice::startNote(int midiNoteNumber, float velocity, SynthesiserSound* sound, int currentPitchWheelPosition)
 {
-    SamplerVoice::startNote(midiNoteNumber, velocity, sound, currentPitchWheelPosition);
+    PadSamplerVoice::startNote(midiNoteNumber, velocity, sound, currentPitchWheelPosition);
+
+    // The pad was emptied just as the note came in
+    if (getPlayingSample() == nullptr)
+        return;
 
     currentNoteNumber = midiNoteNumber;
     samplePosition = 0.0;
-
-    // Get sample length from the sound
-    if (auto* samplerSound = dynamic_cast<SamplerSound*>(sound))
-    {
-        sampleLength = samplerSound->getAudioData()->getNumSamples();
-    }
+    sampleLength = (double) getPlayLength();
 
     processor.notifyNoteStarted(midiNoteNumber, velocity);
 }
@@ -44,12 +43,12 @@ void FreesoundAdvancedSamplerAudioProcessor::TrackingSamplerVoice::stopNote(floa
         currentNoteNumber = -1;
     }
 
-    SamplerVoice::stopNote(velocity, allowTailOff);
+    PadSamplerVoice::stopNote(velocity, allowTailOff);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::TrackingSamplerVoice::renderNextBlock(AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
-    SamplerVoice::renderNextBlock(outputBuffer, startSample, numSamples);
+    PadSamplerVoice::renderNextBlock(outputBuffer, startSample, numSamples);
 
     // Update playhead position
     if (currentNoteNumber >= 0 && sampleLength > 0)
@@ -71,33 +70,19 @@ FreesoundAdvancedSamplerAudioProcessor::TrackingPreviewSamplerVoice::TrackingPre
 
 void FreesoundAdvancedSamplerAudioProcessor::TrackingPreviewSamplerVoice::startNote(int midiNoteNumber, float velocity, SynthesiserSound* sound, int currentPitchWheelPosition)
 {
-
     // Call parent first
-    SamplerVoice::startNote(midiNoteNumber, velocity, sound, currentPitchWheelPosition);
+    PadSamplerVoice::startNote(midiNoteNumber, velocity, sound, currentPitchWheelPosition);
 
-    // Extract freesound ID from the sound name
-    if (auto* samplerSound = dynamic_cast<SamplerSound*>(sound))
-    {
-        String soundName = samplerSound->getName();
+    // The preview was cleared just as the note came in
+    if (getPlayingSample() == nullptr)
+        return;
 
-        if (soundName.startsWith("preview_"))
-        {
-            currentFreesoundId = soundName.substring(8); // Remove "preview_" prefix
-            samplePosition = 0.0;
-            sampleLength = samplerSound->getAudioData()->getNumSamples();
+    currentFreesoundId = getPlayingSample()->getFreesoundId();
+    samplePosition = 0.0;
+    sampleLength = (double) getPlayLength();
 
-            // Notify that preview started
-            processor.notifyPreviewStarted(currentFreesoundId);
-        }
-        else
-        {
-            DBG("  - Sound name doesn't start with 'preview_', ignoring");
-        }
-    }
-    else
-    {
-        DBG("  - Not a SamplerSound, ignoring");
-    }
+    // Notify that preview started
+    processor.notifyPreviewStarted(currentFreesoundId);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::TrackingPreviewSamplerVoice::stopNote(float velocity, bool allowTailOff)
@@ -110,13 +95,13 @@ void FreesoundAdvancedSamplerAudioProcessor::TrackingPreviewSamplerVoice::stopNo
         sampleLength = 0.0;
     }
 
-    SamplerVoice::stopNote(velocity, allowTailOff);
+    PadSamplerVoice::stopNote(velocity, allowTailOff);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::TrackingPreviewSamplerVoice::renderNextBlock(AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
     // Call parent first to actually render the audio
-    SamplerVoice::renderNextBlock(outputBuffer, startSample, numSamples);
+    PadSamplerVoice::renderNextBlock(outputBuffer, startSample, numSamples);
 
     // Update playhead position for preview
     if (currentFreesoundId.isNotEmpty() && sampleLength > 0 && isVoiceActive())
@@ -156,19 +141,64 @@ FreesoundAdvancedSamplerAudioProcessor::FreesoundAdvancedSamplerAudioProcessor()
     tmpDownloadLocation = File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("FreesoundAdvancedSampler");
     tmpDownloadLocation.createDirectory();
     currentSessionDownloadLocation = presetManager.getSamplesFolder();
+
+    // Cache Freesound API responses on disk next to the samples folder, shared by all instances
+    if (FSResponseCache::getDefault() == nullptr)
+        FSResponseCache::setDefault(std::make_shared<FSResponseCache>(tmpDownloadLocation.getChildFile("cache")));
+
+    // Decoded samples are cached next to it, so reloading a preset maps them instead of decoding
+    samplePool->setCacheDirectory(tmpDownloadLocation.getChildFile("decoded_cache"));
+
     midicounter = 1;
     startTime = Time::getMillisecondCounterHiRes() * 0.001;
 
-    // Initialize preview sampler format manager
-    if (previewAudioFormatManager.getNumKnownFormats() == 0) {
-        previewAudioFormatManager.registerBasicFormats();
+    // The pads and voices of both samplers are set up once; only the samples the pads play
+    // change after this, and sampleLoader hands those to the audio thread
+    ADSR::Parameters padEnvelope;
+    padEnvelope.attack = 0.0f;     // Start immediately
+    padEnvelope.decay = 0.0f;
+    padEnvelope.sustain = 1.0f;    // Play until note off
+    padEnvelope.release = 0.1f;    // Short release (100ms fadeout after note off)
+
+    for (int padIndex = 0; padIndex < numPads; ++padIndex)
+    {
+        padSounds[(size_t) padIndex] = new PadSound(firstPadNote + padIndex, padEnvelope);
+        sampler.addSound(padSounds[(size_t) padIndex]);
+    }
+
+    for (int i = 0; i < numVoices; i++) {
+        auto* voice = new TrackingSamplerVoice(*this);
+        voice->setStream(sampleStreamer.getStream(i));
+        sampler.addVoice(voice);
     }
 
+    padSounds[(size_t) previewSlot] = new PadSound(previewNote, padEnvelope);
+    previewSampler.addSound(padSounds[(size_t) previewSlot]);
+
     // FIXED: Add tracking voice for preview sampler (not regular voice)
-    previewSampler.addVoice(new TrackingPreviewSamplerVoice(*this));
+    auto* previewVoice = new TrackingPreviewSamplerVoice(*this);
+    previewVoice->setStream(sampleStreamer.getStream(numVoices));
+    previewSampler.addVoice(previewVoice);
 
     // Add download manager listener
     downloadManager.addListener(this);
+
+    // Make pads playable from the first decodable bytes of their downloads
+    WeakReference<FreesoundAdvancedSamplerAudioProcessor> weakThis(this);
+    downloadManager.onAudioDataAvailable = [weakThis](const FSSound& sound, const MemoryBlock& dataSoFar, bool)
+    {
+        MessageManager::callAsync([weakThis, soundId = sound.id, dataSoFar]
+        {
+            if (auto* processor = weakThis.get())
+                for (int padIndex = 0; padIndex < processor->currentSoundsArray.size(); ++padIndex)
+                    if (processor->currentSoundsArray.getReference(padIndex).id == soundId)
+                        processor->loadPartialSample(padIndex, dataSoFar);
+        });
+    };
+
+    // Pick up downloads a previous session did not get to finish
+    downloadManager.setJournalDirectory(tmpDownloadLocation.getChildFile("download_queue"));
+    downloadManager.resumeJournaledDownloads();
 }
 
 FreesoundAdvancedSamplerAudioProcessor::~FreesoundAdvancedSamplerAudioProcessor()
@@ -269,6 +299,9 @@ bool FreesoundAdvancedSamplerAudioProcessor::isBusesLayoutSupported (const Buses
 
 void FreesoundAdvancedSamplerAudioProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
 {
+    // Put samples the loader has finished into their pads
+    sampleLoader.applyPublishedSamples(padSounds.data());
+
     // Add MIDI events from editor
     midiMessages.addEvents(midiFromEditor, 0, INT_MAX, 0);
     midiFromEditor.clear();
@@ -292,11 +325,19 @@ void FreesoundAdvancedSamplerAudioProcessor::processBlock(AudioBuffer<float>& bu
         }
     }
 
+    // Start a preview that was asked for while its sample was still loading
+    int pendingPreview = previewPlayPending.load();
+    if (pendingPreview != 0 && sampleLoader.getLastAppliedTag(previewSlot) == pendingPreview
+        && previewPlayPending.compare_exchange_strong(pendingPreview, 0))
+    {
+        previewMidiBuffer.addEvent(MidiMessage::noteOn(2, previewNote, (uint8)100), 0);
+    }
+
     // Render main sampler
     sampler.renderNextBlock(buffer, mainMidiBuffer, 0, buffer.getNumSamples());
 
     // Render preview sampler on top (mix with main output)
-    if (previewSampler.getNumSounds() > 0)
+    if (padSounds[(size_t) previewSlot]->getCurrentSample() != nullptr)
     {
         AudioBuffer<float> previewBuffer(buffer.getNumChannels(), buffer.getNumSamples());
         previewBuffer.clear();
@@ -565,12 +606,12 @@ void FreesoundAdvancedSamplerAudioProcessor::startDownloads(const Array<FSSound>
     }
 
     // Start downloading only the new samples
-    downloadManager.startDownloads(soundsToDownload, samplesFolder, query);
+    downloadManager.startDownloads(soundsToDownload, samplesFolder, query, AudioDownloadManager::Priority::VisibleGrid);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::cancelDownloads()
 {
-	downloadManager.stopThread(2000);
+	downloadManager.cancelDownloads();
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::downloadProgressChanged(const AudioDownloadManager::DownloadProgress& progress)
@@ -608,57 +649,58 @@ void FreesoundAdvancedSamplerAudioProcessor::removeDownloadListener(DownloadList
 
 void FreesoundAdvancedSamplerAudioProcessor::setSources()
 {
-    sampler.clearSounds();
-    sampler.clearVoices();
-
-    int poliphony = 16;
-    double maxLength = 0.0; // CHANGED: 0.0 means no length limit
+    // Load samples by their actual pad positions. The loader shares samples that are loaded
+    // already, so pads that only moved are not decoded again.
+    for (int padIndex = 0; padIndex < numPads; ++padIndex)
+    {
+        const FSSound sound = padIndex < currentSoundsArray.size() ? currentSoundsArray[padIndex] : FSSound();
 
-    // Add tracking voices
-    for (int i = 0; i < poliphony; i++) {
-        sampler.addVoice(new TrackingSamplerVoice(*this));
+        if (sound.id.isEmpty())
+            sampleLoader.clear(padIndex);
+        else
+            sampleLoader.load(padIndex, sound.id, getPadSampleFile(sound));
     }
+}
 
-    // Add a tracking voice for preview sampler instead of regular voice
-    previewSampler.addVoice(new TrackingPreviewSamplerVoice(*this));
-
-    if (audioFormatManager.getNumKnownFormats() == 0) {
-        audioFormatManager.registerBasicFormats();
-    }
+void FreesoundAdvancedSamplerAudioProcessor::replacePadSound(int padIndex)
+{
+    if (padIndex < 0 || padIndex >= numPads)
+        return;
 
-    // Load samples by their actual pad positions
-    for (int padIndex = 0; padIndex < 16; ++padIndex)
-    {
-        if (padIndex < currentSoundsArray.size() && !currentSoundsArray[padIndex].id.isEmpty())
-        {
-            const FSSound& sound = currentSoundsArray[padIndex];
+    const FSSound sound = padIndex < currentSoundsArray.size() ? currentSoundsArray[padIndex] : FSSound();
 
-            String fileName = "FS_ID_" + sound.id + ".ogg";
-            File audioFile = currentSessionDownloadLocation.getChildFile(fileName);
+    if (sound.id.isEmpty())
+        sampleLoader.clear(padIndex);
+    else
+        sampleLoader.load(padIndex, sound.id, getPadSampleFile(sound));
+}
 
-            if (audioFile.existsAsFile())
-            {
-                std::unique_ptr<AudioFormatReader> reader(audioFormatManager.createReaderFor(audioFile));
+void FreesoundAdvancedSamplerAudioProcessor::removePadSound(int padIndex)
+{
+    if (padIndex >= 0 && padIndex < numPads)
+        sampleLoader.clear(padIndex);
+}
 
-                if (reader != nullptr)
-                {
-                    BigInteger notes;
-                    int midiNote = 36 + padIndex;
-                    notes.setBit(midiNote, true);
+void FreesoundAdvancedSamplerAudioProcessor::swapPadSounds(int padIndexA, int padIndexB)
+{
+    if (padIndexA < 0 || padIndexA >= numPads || padIndexB < 0 || padIndexB >= numPads || padIndexA == padIndexB)
+        return;
 
-                    // For sustained playback (samples play until note off):
-                    double attackTime = 0.0;      // Start immediately
-                    double releaseTime = 0.1;     // Short release (100ms fadeout after note off)
-                    double maxSampleLength = 10.0; // No length limit - play full sample
+    sampleLoader.swap(padIndexA, padIndexB);
+}
 
-                    sampler.addSound(new SamplerSound(String(padIndex), *reader, notes, midiNote,
-                                                     attackTime, releaseTime, maxSampleLength));
+File FreesoundAdvancedSamplerAudioProcessor::getPadSampleFile(const FSSound& sound) const
+{
+    return currentSessionDownloadLocation.getChildFile("FS_ID_" + sound.id + ".ogg");
+}
 
-                }
-            }
-        }
-    }
+void FreesoundAdvancedSamplerAudioProcessor::loadPartialSample(int padIndex, const MemoryBlock& oggData)
+{
+    if (padIndex < 0 || padIndex >= numPads || padIndex >= currentSoundsArray.size())
+        return;
 
+    // Replaces whatever the pad had so far, unless the complete sample got there first
+    sampleLoader.loadPartial(padIndex, currentSoundsArray[padIndex].id, oggData);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::addNoteOnToMidiBuffer(int notenumber)
@@ -803,10 +845,6 @@ bool FreesoundAdvancedSamplerAudioProcessor::loadPreset(const File& presetFile,
     soundsArray.clear();
     currentSoundsArray.clear();
 
-    // Also clear the sampler before rebuilding
-    sampler.clearSounds();
-    sampler.clearVoices();
-
     // Update query from slot info
     query = masterQuery;
 
@@ -1283,39 +1321,11 @@ void FreesoundAdvancedSamplerAudioProcessor::loadPreviewSample(const File& audio
     // CRITICAL: Stop any currently playing preview first
     stopPreviewSample();
 
-    // Clear existing preview sounds but keep the tracking voice
-    previewSampler.clearSounds();
-
     // Store which sample we're about to load
     currentPreviewFreesoundId = freesoundId;
 
-    // Load the preview sample
-    std::unique_ptr<AudioFormatReader> reader(previewAudioFormatManager.createReaderFor(audioFile));
-    if (reader != nullptr)
-    {
-
-        BigInteger notes;
-        int previewNote = 127; // Use highest MIDI note for preview
-        notes.setBit(previewNote, true);
-
-        // Create the sampler sound with the freesound ID in the name
-        // This is crucial for the tracking voice to identify it
-        String soundName = "preview_" + freesoundId;
-
-        double maxLength = 10.0;
-        double attackTime = 0.0;
-        double releaseTime = 0.1;
-
-        auto* samplerSound = new SamplerSound(soundName, *reader, notes, previewNote,
-                                             attackTime, releaseTime, maxLength);
-
-        previewSampler.addSound(samplerSound);
-
-    }
-    else
-    {
-        currentPreviewFreesoundId = ""; // Clear on failure
-    }
+    // Decoded on the loader thread; playPreviewSample() waits for it to be in place
+    sampleLoader.load(previewSlot, freesoundId, audioFile, ++previewTag);
 }
 
 void FreesoundAdvancedSamplerAudioProcessor::playPreviewSample()
@@ -1327,14 +1337,14 @@ void FreesoundAdvancedSamplerAudioProcessor::playPreviewSample()
         return;
     }
 
-    if (previewSampler.getNumSounds() == 0)
+    // Still loading: processBlock starts it as soon as the sample is in place
+    if (sampleLoader.getLastAppliedTag(previewSlot) != previewTag)
     {
-        DBG("  - No sounds in preview sampler, aborting");
+        previewPlayPending = previewTag;
         return;
     }
 
     // Trigger the preview sample
-    int previewNote = 127;
     MidiMessage message = MidiMessage::noteOn(2, previewNote, (uint8)100); // Channel 2 for preview
     double timestamp = Time::getMillisecondCounterHiRes() * 0.001 - getStartTime();
     message.setTimeStamp(timestamp);
@@ -1346,9 +1356,10 @@ void FreesoundAdvancedSamplerAudioProcessor::playPreviewSample()
 
 void FreesoundAdvancedSamplerAudioProcessor::stopPreviewSample()
 {
+    previewPlayPending = 0;
+
     // Send note off for preview - do this even if currentPreviewFreesoundId is empty
     // to ensure any stuck notes are released
-    int previewNote = 127;
     MidiMessage message = MidiMessage::noteOff(2, previewNote, (uint8)0);
     double timestamp = Time::getMillisecondCounterHiRes() * 0.001 - getStartTime();
     message.setTimeStamp(timestamp);
@@ -15,6 +15,7 @@
 #include "AudioDownloadManager.h"
 #include "PresetManager.h"
 #include "BookmarkManager.h"
+#include "PadSampler.h"
 
 using namespace juce;
 
@@ -74,7 +75,11 @@ public:
 	void stopPreviewSample();
 
 	// main sampler methods for sample pads in 4x4 grid
-	void setSources();
+	void setSources();	// brings every pad in line with currentSoundsArray, decoding only pads that changed
+	void replacePadSound(int padIndex);	// decodes the pad's sample from currentSoundsArray again
+	void removePadSound(int padIndex);
+	void swapPadSounds(int padIndexA, int padIndexB);	// no decoding, the samples change places
+	void loadPartialSample(int padIndex, const MemoryBlock& oggData); // playable start of a sample that is still downloading
 	void addNoteOnToMidiBuffer(int notenumber);	// for adding notes from
 	void addNoteOffToMidiBuffer(int noteNumber);
 
@@ -195,7 +200,7 @@ private:
 	bool bookmarkPanelExpandedState = false;  // ADD THIS
 
     // Enhanced sampler voice class for playback tracking
-    class TrackingSamplerVoice : public SamplerVoice
+    class TrackingSamplerVoice : public PadSamplerVoice
     {
     public:
         TrackingSamplerVoice(FreesoundAdvancedSamplerAudioProcessor& owner);
@@ -212,7 +217,7 @@ private:
     };
 
 	// Enhanced preview sampler voice class for playback tracking of 4x4 Grid and Preview Samples
-	class TrackingPreviewSamplerVoice : public SamplerVoice
+	class TrackingPreviewSamplerVoice : public PadSamplerVoice
 	{
 	public:
 		TrackingPreviewSamplerVoice(FreesoundAdvancedSamplerAudioProcessor& owner);
@@ -240,8 +245,20 @@ private:
     ListenerList<DownloadListener> downloadListeners;
     ListenerList<PlaybackListener> playbackListeners; // NEW
 
+	static constexpr int numPads = 16;
+	static constexpr int firstPadNote = 36;
+	static constexpr int numVoices = 16;
+
+	static constexpr int previewSlot = numPads;	// loader slot of the preview sound
+	static constexpr int previewNote = 127;
+
+	SharedResourcePointer<DecodedSamplePool> samplePool;
+	PadSampleStreamer sampleStreamer { numVoices + 1 };	// a stream per voice, the preview's last
 	Synthesiser sampler;
-	AudioFormatManager audioFormatManager;
+	std::array<PadSound*, numPads + 1> padSounds {};	// the pads, then the preview; owned by the samplers
+	PadSampleLoader sampleLoader { numPads + 1 };
+
+	File getPadSampleFile(const FSSound& sound) const;
 	MidiBuffer midiFromEditor;
 	long midicounter;
 	double startTime;
@@ -251,7 +268,8 @@ private:
 
 	// Add dedicated preview sampler (runs in parallel)
 	Synthesiser previewSampler;
-	AudioFormatManager previewAudioFormatManager;
+	int previewTag = 0;							// tag of the last preview load
+	std::atomic<int> previewPlayPending { 0 };	// preview load to start playing once it's in place
 
     // NEW: Methods for playback tracking
     void notifyNoteStarted(int noteNumber, float velocity);
@@ -268,5 +286,6 @@ private:
     friend class TrackingSamplerVoice;
 
     //==============================================================================
+    JUCE_DECLARE_WEAK_REFERENCEABLE (FreesoundAdvancedSamplerAudioProcessor)
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FreesoundAdvancedSamplerAudioProcessor)
 };
\ No newline at end of file
@@ -1046,31 +1046,34 @@ void PresetBrowserComponent::downloadMissingSamples(const Array<PadInfo>& missin
         uniqueMissingIds.addIfNotAlreadyThere(padInfo.freesoundId);
     }
 
-    // We need to fetch the missing sounds from Freesound API to get complete data including previews
-    Array<FSSound> soundsToDownload;
+    // We need to fetch the missing sounds from Freesound API to get complete data including previews.
+    // All the IDs are resolved in a few batched requests, off the message thread
     FreesoundClient client(FREESOUND_API_KEY);
+    Component::SafePointer<PresetBrowserComponent> safeThis(this);
 
-    for (const String& freesoundId : uniqueMissingIds)
-    {
-        try
+    client.getSoundsAsync(uniqueMissingIds, "id,name,username,license,previews,duration,filesize")
+        .then([safeThis, uniqueMissingIds](Array<FSSound> resolvedSounds)
         {
-            // Fetch the complete sound data from Freesound API including previews
-            FSSound sound = client.getSound(freesoundId, "id,name,username,license,previews,duration,filesize");
+            if (safeThis == nullptr)
+                return;
 
-            if (!sound.id.isEmpty())
-            {
-                soundsToDownload.add(sound);
-            }
-            else
+            Array<FSSound> soundsToDownload;
+            for (int i = 0; i < resolvedSounds.size(); ++i)
             {
-                DBG("Failed to fetch sound data for ID: " + freesoundId);
+                if (!resolvedSounds[i].id.isEmpty())
+                    soundsToDownload.add(resolvedSounds[i]);
+                else
+                    DBG("Failed to fetch sound data for ID: " + uniqueMissingIds[i]);
             }
-        }
-        catch (const std::exception& e)
-        {
-            DBG("Error fetching sound " + freesoundId + ": " + String(e.what()));
-        }
-    }
+
+            safeThis->startMissingSamplesDownload(soundsToDownload);
+        });
+}
+
+void PresetBrowserComponent::startMissingSamplesDownload(const Array<FSSound>& soundsToDownload)
+{
+    if (!processor)
+        return;
 
     if (soundsToDownload.isEmpty())
     {
@@ -1080,11 +1083,13 @@ void PresetBrowserComponent::downloadMissingSamples(const Array<PadInfo>& missin
         return;
     }
 
-    // Start download using processor's download system
-    processor->getDownloadManager().startDownloads(
+    // Queue the downloads on the processor's download system as background work, so they
+    // neither cancel a running grid download nor hold up pads the user is loading
+    processor->getDownloadManager().enqueueDownloads(
         soundsToDownload,
         processor->getPresetManager().getSamplesFolder(),
-        "Missing samples download"
+        "Missing samples download",
+        AudioDownloadManager::Priority::Background
     );
 
     // Show progress notification
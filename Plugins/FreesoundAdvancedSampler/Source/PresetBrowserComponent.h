@@ -144,6 +144,7 @@ private:
 
     void handleSampleCheckClicked(PresetListItem* item);
     void downloadMissingSamples(const Array<PadInfo>& missingPadInfos);
+    void startMissingSamplesDownload(const Array<FSSound>& soundsToDownload);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetBrowserComponent)
 };
\ No newline at end of file
@@ -1365,6 +1365,51 @@ Badge* SamplePad::findBadgeAtPosition(Point<int> position)
 
 // Waveform methods
 void SamplePad::loadWaveform()
+{
+    if (!audioFile.existsAsFile())
+        return;
+
+    if (freesoundId.isEmpty())
+    {
+        loadWaveformFromFile();
+        return;
+    }
+
+    audioThumbnail.clear();
+
+    // Drawn from the shared decoded copy of the sample, which the pads and the preview
+    // play too; decoded in the background if nothing has loaded it yet
+    Component::SafePointer<SamplePad> safeThis(this);
+    const String requestedId = freesoundId;
+
+    samplePool->requestSample(freesoundId, audioFile, [safeThis, requestedId](DecodedSample::Ptr sample)
+    {
+        auto* pad = safeThis.getComponent();
+
+        // The pad has moved on to another sample since
+        if (pad == nullptr || pad->freesoundId != requestedId || !pad->hasValidSample)
+            return;
+
+        // Long samples only have their start decoded, so those are drawn from the file
+        if (sample != nullptr && !sample->isTruncated())
+            pad->showWaveformOf(*sample);
+        else
+            pad->loadWaveformFromFile();
+    });
+}
+
+void SamplePad::showWaveformOf(const DecodedSample& sample)
+{
+    const auto& data = sample.getAudioData();
+
+    audioThumbnail.reset(data.getNumChannels(), sample.getSourceSampleRate(), sample.getLength());
+    audioThumbnail.addBlock(0, data, 0, sample.getLength());
+
+    fileSourceSampleRate = (float) sample.getSourceSampleRate();
+    repaint();
+}
+
+void SamplePad::loadWaveformFromFile()
 {
     if (audioFile.existsAsFile())
     {
@@ -1584,7 +1629,7 @@ void SamplePad::handleDeleteClick()
                         if (padIndex < data.size())
                             data[padIndex] = StringArray();
 
-                        processor->setSources();
+                        processor->removePadSound(padIndex);
                     }
 
                     gridComponent->updateJsonMetadata();
@@ -1751,6 +1796,34 @@ bool SamplePad::convertOggToWav(const File& oggFile, const File& wavFile)
     if (!oggFile.existsAsFile())
         return false;
 
+    // Written straight from the shared decoded copy when that holds the whole sample
+    if (auto sample = samplePool->findSample(freesoundId))
+    {
+        if (sample->isComplete() && !sample->isTruncated())
+        {
+            const auto& data = sample->getAudioData();
+            std::unique_ptr<FileOutputStream> outputStream(wavFile.createOutputStream());
+            if (!outputStream)
+                return false;
+
+            WavAudioFormat wavFormat;
+            std::unique_ptr<AudioFormatWriter> writer(wavFormat.createWriterFor(
+                outputStream.get(), sample->getSourceSampleRate(), (unsigned int) data.getNumChannels(), 16, {}, 0));
+
+            if (!writer)
+                return false;
+
+            outputStream.release();
+
+            if (writer->writeFromAudioSampleBuffer(data, 0, sample->getLength()))
+                return true;
+
+            writer.reset();
+            wavFile.deleteFile();
+            return false;
+        }
+    }
+
     AudioFormatManager formatManager;
     formatManager.registerBasicFormats();
 
@@ -1860,8 +1933,15 @@ SampleGridComponent::~SampleGridComponent()
 {
     stopTimer();
 
-    // Clean up any active downloads
-    cleanupSingleDownload();
+    // Cancel the single pad downloads first: once they have stopped no worker can be
+    // calling the listener, so removing it cannot miss a callback in progress
+    if (singlePadDownloadManager)
+    {
+        singlePadDownloadManager->cancelDownloads();
+        singlePadDownloadManager->onAudioDataAvailable = nullptr;
+        singlePadDownloadManager->removeListener(this);
+        singlePadDownloadManager.reset();
+    }
 
     if (processor)
     {
@@ -2152,8 +2232,8 @@ void SampleGridComponent::swapSamples(int sourcePadIndex, int targetPadIndex)
         auto& metadata = processor->getDataReference();
         std::swap(metadata[sourcePadIndex], metadata[targetPadIndex]);
 
-        // Rebuild the sampler to apply updated MIDI mappings
-        processor->setSources();
+        // The two pads exchange their decoded samples
+        processor->swapPadSounds(sourcePadIndex, targetPadIndex);
     }
 
     // Repaint both pads to reflect new visuals
@@ -2449,12 +2529,6 @@ Array<SamplePad::SampleInfo> SampleGridComponent::getAllSampleInfo() const
     return allSamples;
 }
 
-Array<FSSound> SampleGridComponent::searchSingleSound(const String& query)
-{
-    auto [finalSounds, soundInfo] = makeQuerySearchUsingFreesoundAPI(query, 1, true);
-    return finalSounds;
-}
-
 void SampleGridComponent::loadSingleSample(int padIndex, const FSSound& sound, const File& audioFile)
 {
     // Update the pad visually
@@ -2463,10 +2537,10 @@ void SampleGridComponent::loadSingleSample(int padIndex, const FSSound& sound, c
     // Update processor's internal arrays
     updateSinglePadInProcessor(padIndex, sound);
 
-    // Reload the sampler to include the new sample
+    // Decode just this pad's new sample
     if (processor)
     {
-        processor->setSources();
+        processor->replacePadSound(padIndex);
         processor->updateReadmeFile();
     }
 
@@ -2476,24 +2550,7 @@ void SampleGridComponent::loadSingleSample(int padIndex, const FSSound& sound, c
 
 void SampleGridComponent::downloadSingleSample(int padIndex, const FSSound& sound)
 {
-    // Create a download manager for single file
-    singlePadDownloadManager = std::make_unique<AudioDownloadManager>();
-    currentDownloadPadIndex = padIndex;
-    currentDownloadSound = sound;
-
-    // Use a simple callback approach instead of inheritance
-    // We'll check for completion in a timer or use the processor's download system
-
-    // Start download
-    Array<FSSound> singleSoundArray;
-    singleSoundArray.add(sound);
-
-    File samplesFolder = processor->getCurrentDownloadLocation();
-
-    // Use a timer to check for completion
-    startTimer(500); // Check every 500ms
-    singlePadDownloadManager->startDownloads(singleSoundArray, samplesFolder, processor->getQuery());
-
+    downloadSingleSampleWithQuery(padIndex, sound, processor->getQuery());
 }
 
 void SampleGridComponent::updateSinglePadInProcessor(int padIndex, const FSSound& sound)
@@ -2716,7 +2773,7 @@ void SampleGridComponent::searchForSinglePadWithQuery(int padIndex, const String
     }
 
     // Check if this pad is already downloading
-    if (currentDownloadPadIndex == padIndex && singlePadDownloadManager && singlePadDownloadManager->isThreadRunning())
+    if (isPadDownloading(padIndex))
     {
         AlertWindow::showMessageBoxAsync(AlertWindow::InfoIcon,
             "Download In Progress",
@@ -2754,8 +2811,48 @@ void SampleGridComponent::searchForSinglePadWithQuery(int padIndex, const String
 
 void SampleGridComponent::performSinglePadSearch(int padIndex, const String& query)
 {
-    // Search for a single sound with the specific query
-    Array<FSSound> searchResults = searchSingleSound(query);
+    // A candidate prefetched for this query swaps in right away
+    FSSound candidate;
+    File candidateFile;
+
+    if (getCandidatePool().takeCandidate(query, samplePads[padIndex]->getSampleInfo().freesoundId,
+                                         processor->getCurrentDownloadLocation(), candidate, candidateFile))
+    {
+        loadSingleSampleWithQuery(padIndex, candidate, candidateFile, query);
+        getCandidatePool().refill(query);
+        return;
+    }
+
+    // Search for a single sound with the specific query, without blocking the message thread
+    Component::SafePointer<SampleGridComponent> safeThis(this);
+
+    makeQuerySearchUsingFreesoundAPIAsync(query, 1, true,
+        [safeThis, padIndex, query](Array<FSSound> finalSounds, std::vector<StringArray>)
+        {
+            if (safeThis == nullptr)
+                return;
+
+            safeThis->handleSinglePadSearchResults(padIndex, query, finalSounds);
+
+            // Have the next re-search of this query ready locally
+            safeThis->getCandidatePool().refill(query);
+        });
+}
+
+PadCandidatePool& SampleGridComponent::getCandidatePool()
+{
+    // Candidates live next to the samples folder and are moved into it when used
+    if (candidatePool == nullptr)
+        candidatePool = std::make_unique<PadCandidatePool>(
+            processor->getCurrentDownloadLocation().getSiblingFile("candidates"));
+
+    return *candidatePool;
+}
+
+void SampleGridComponent::handleSinglePadSearchResults(int padIndex, const String& query, const Array<FSSound>& searchResults)
+{
+    if (!processor || padIndex < 0 || padIndex >= TOTAL_PADS)
+        return;
 
     if (searchResults.isEmpty())
     {
@@ -2796,10 +2893,10 @@ void SampleGridComponent::loadSingleSampleWithQuery(int padIndex, const FSSound&
     // Update processor's internal arrays
     updateSinglePadInProcessor(padIndex, sound);
 
-    // Reload the sampler to include the new sample
+    // Decode just this pad's new sample
     if (processor)
     {
-        processor->setSources();
+        processor->replacePadSound(padIndex);
         processor->updateReadmeFile();
     }
 
@@ -2809,126 +2906,124 @@ void SampleGridComponent::loadSingleSampleWithQuery(int padIndex, const FSSound&
 
 void SampleGridComponent::downloadSingleSampleWithQuery(int padIndex, const FSSound& sound, const String& query)
 {
-    // Store the query for later use
-    currentDownloadQuery = query;
+    if (padIndex < 0 || padIndex >= TOTAL_PADS)
+        return;
 
-    // Clean up any existing download manager first
-    if (singlePadDownloadManager)
+    // One manager serves every pad, so several pads can download at once
+    if (!singlePadDownloadManager)
     {
-        singlePadDownloadManager->stopThread(1000);
-        singlePadDownloadManager.reset();
+        singlePadDownloadManager = std::make_unique<AudioDownloadManager>();
+        singlePadDownloadManager->addListener(this);
+        watchSinglePadAudioData();
     }
 
-    // Create a download manager for single file
-    singlePadDownloadManager = std::make_unique<AudioDownloadManager>();
-    // DON'T add listener to avoid double-listening conflicts
+    // A newer request for the same pad replaces the pending one
+    for (int i = singlePadDownloads.size(); --i >= 0;)
+        if (singlePadDownloads.getReference(i).padIndex == padIndex)
+            singlePadDownloads.remove(i);
 
-    currentDownloadPadIndex = padIndex;
-    currentDownloadSound = sound;
+    singlePadDownloads.add({ padIndex, sound, query });
 
     // Start progress display on the pad
-    if (padIndex >= 0 && padIndex < TOTAL_PADS)
-    {
-        samplePads[padIndex]->startDownloadProgress();
-    }
+    samplePads[padIndex]->startDownloadProgress();
 
-    // Start download
     Array<FSSound> singleSoundArray;
     singleSoundArray.add(sound);
 
     File samplesFolder = processor->getCurrentDownloadLocation();
 
-    // Use timer-based checking instead of listener to avoid conflicts
-    startTimer(250); // Check every 250ms
-
-    singlePadDownloadManager->startDownloads(singleSoundArray, samplesFolder, query);
+    singlePadDownloadManager->enqueueDownloads(singleSoundArray, samplesFolder, query,
+                                               AudioDownloadManager::Priority::Interactive);
 }
 
-void SampleGridComponent::cleanupSingleDownload()
+void SampleGridComponent::watchSinglePadAudioData()
 {
-    // Clean up download manager safely
-    if (singlePadDownloadManager)
+    // Lets a pad be played from the first decodable part of its download
+    singlePadDownloadManager->onAudioDataAvailable = [safeThis = safeThisForDownloads](const FSSound& sound, const MemoryBlock& dataSoFar, bool)
     {
-        // Stop thread with timeout
-        if (singlePadDownloadManager->isThreadRunning())
+        MessageManager::callAsync([safeThis, sound, dataSoFar]
         {
-            singlePadDownloadManager->stopThread(2000);
-        }
-        singlePadDownloadManager.reset();
-    }
+            if (safeThis == nullptr || safeThis->processor == nullptr)
+                return;
 
-    currentDownloadPadIndex = -1;
-    currentDownloadQuery = "";
+            for (const int index : safeThis->findSinglePadDownloads(sound))
+                safeThis->processor->loadPartialSample(safeThis->singlePadDownloads.getReference(index).padIndex, dataSoFar);
+        });
+    };
 }
 
-void SampleGridComponent::timerCallback()
+bool SampleGridComponent::isPadDownloading(int padIndex) const
 {
-    // Check if we're handling single pad downloads
-    if (singlePadDownloadManager && currentDownloadPadIndex >= 0)
-    {
-        String fileName = "FS_ID_" + currentDownloadSound.id + ".ogg";
-        File samplesFolder = processor->getCurrentDownloadLocation();
-        File audioFile = samplesFolder.getChildFile(fileName);
+    for (const auto& download : singlePadDownloads)
+        if (download.padIndex == padIndex)
+            return true;
 
-        // Check if download is still running
-        bool downloadRunning = singlePadDownloadManager->isThreadRunning();
+    return false;
+}
 
-        if (audioFile.existsAsFile())
-        {
-            // Download completed successfully
-            stopTimer();
+Array<int> SampleGridComponent::findSinglePadDownloads(const FSSound& sound) const
+{
+    Array<int> indices;
 
-            // Load the sample
-            loadSingleSampleWithQuery(currentDownloadPadIndex, currentDownloadSound, audioFile, currentDownloadQuery);
+    for (int i = 0; i < singlePadDownloads.size(); ++i)
+        if (singlePadDownloads.getReference(i).sound.id == sound.id)
+            indices.add(i);
 
-            // Finish progress with success - use SafePointer
-            if (currentDownloadPadIndex < TOTAL_PADS && samplePads[currentDownloadPadIndex])
-            {
-                samplePads[currentDownloadPadIndex]->finishDownloadProgress(true, "Complete!");
-            }
+    return indices;
+}
 
-            // Clean up safely
-            cleanupSingleDownload();
-        }
-        else if (!downloadRunning)
-        {
-            // Download thread finished but no file - failed
-            stopTimer();
+void SampleGridComponent::soundDownloadProgress(const FSSound& sound, int64 downloaded, int64 total)
+{
+    if (total <= 0)
+        return;
 
-            // Finish progress with error - use SafePointer
-            if (currentDownloadPadIndex < TOTAL_PADS && samplePads[currentDownloadPadIndex])
-            {
-                samplePads[currentDownloadPadIndex]->finishDownloadProgress(false, "Download failed!");
-            }
+    const double progress = (double) downloaded / (double) total;
 
-            // Clean up safely
-            cleanupSingleDownload();
-        }
-        else
+    MessageManager::callAsync([safeThis = safeThisForDownloads, sound, progress]
+    {
+        if (safeThis == nullptr)
+            return;
+
+        for (const int index : safeThis->findSinglePadDownloads(sound))
+            safeThis->samplePads[safeThis->singlePadDownloads.getReference(index).padIndex]->updateDownloadProgress(progress);
+    });
+}
+
+void SampleGridComponent::soundDownloadFinished(const FSSound& sound, const File& file, bool success)
+{
+    MessageManager::callAsync([safeThis = safeThisForDownloads, sound, file, success]
+    {
+        if (safeThis == nullptr)
+            return;
+
+        // None left if every pad waiting for it has since asked for something else
+        const Array<int> indices = safeThis->findSinglePadDownloads(sound);
+
+        for (int i = indices.size(); --i >= 0;)
         {
-            // Still downloading - update progress if possible
-            // Simple progress estimation based on time (fallback)
-            if (currentDownloadPadIndex < TOTAL_PADS && samplePads[currentDownloadPadIndex])
-            {
-                // You could implement a simple time-based progress here if needed
-                // For now, just ensure the progress bar is still showing
-            }
+            const SinglePadDownload download = safeThis->singlePadDownloads.removeAndReturn(indices.getUnchecked(i));
+
+            if (success)
+                safeThis->loadSingleSampleWithQuery(download.padIndex, download.sound, file, download.query);
+
+            safeThis->samplePads[download.padIndex]->finishDownloadProgress(success, success ? "Complete!" : "Download failed!");
         }
-    }
-    else
-    {
-        // This is the delayed repaint from loadSamplesFromArrays
-        stopTimer();
+    });
+}
 
-        // Safely repaint all pads
-        for (auto& pad : samplePads)
+void SampleGridComponent::timerCallback()
+{
+    // Delayed repaint from loadSamplesFromArrays
+    stopTimer();
+
+    // Safely repaint all pads
+    for (auto& pad : samplePads)
+    {
+        if (pad && pad->isShowing() &&
+            pad->getLocalBounds().getWidth() > 0 &&
+            pad->getLocalBounds().getHeight() > 0)
         {
-            if (pad && pad->isShowing() &&
-                pad->getLocalBounds().getWidth() > 0 &&
-                pad->getLocalBounds().getHeight() > 0)
-            {
-                pad->repaint();
-            }
+            pad->repaint();
         }
     }
 }
@@ -3298,10 +3393,10 @@ void SampleGridComponent::performEnhancedDrop(const String& jsonMetadata, const
     soundsData[targetPadIndex].set(2, licenseType);
     soundsData[targetPadIndex].set(3, searchQuery);
 
-    // Reload sampler
+    // Load the dropped sample into its pad
     if (processor)
     {
-        processor->setSources();
+        processor->replacePadSound(targetPadIndex);
     }
 }
 
@@ -3416,13 +3511,28 @@ void SampleGridComponent::executeMasterSearch(const String& masterQuery, const A
     if (!processor)
         return;
 
-    // Store the target pad indices for when the search completes
-    pendingMasterSearchPads = targetPadIndices;
-    pendingMasterSearchQuery = masterQuery;
-
     int numSoundsNeeded = targetPadIndices.size();
 
-    auto [finalSounds, soundInfo] = makeQuerySearchUsingFreesoundAPI(masterQuery, numSoundsNeeded, true);
+    // Run the search on the Freesound worker pool so the UI stays responsive
+    Component::SafePointer<SampleGridComponent> safeThis(this);
+
+    makeQuerySearchUsingFreesoundAPIAsync(masterQuery, numSoundsNeeded, true,
+        [safeThis, masterQuery, targetPadIndices](Array<FSSound> finalSounds, std::vector<StringArray> soundInfo)
+        {
+            if (safeThis != nullptr)
+                safeThis->handleMasterSearchResults(masterQuery, targetPadIndices, finalSounds, soundInfo);
+        });
+}
+
+void SampleGridComponent::handleMasterSearchResults(const String& masterQuery, const Array<int>& targetPadIndices,
+    const Array<FSSound>& finalSounds, const std::vector<StringArray>& soundInfo)
+{
+    if (!processor)
+        return;
+
+    // Store the target pad indices for when the downloads complete
+    pendingMasterSearchPads = targetPadIndices;
+    pendingMasterSearchQuery = masterQuery;
 
     if (finalSounds.isEmpty())
     {
@@ -3641,7 +3751,7 @@ void SampleGridComponent::handleCrossAppDrop(const StringArray& files, int targe
 
     // Update processor arrays
     updateSinglePadInProcessor(targetPadIndex, sound);  // Complete expression
-    processor->setSources();
+    processor->replacePadSound(targetPadIndex);
 }
 
 void SampleGridComponent::fileDragEnter(const StringArray& files, int x, int y)
@@ -18,6 +18,7 @@
 #include "CustomButtonStyle.h"
 #include "MasterSearchPanel.h"
 #include "FreesoundSearchUtils.h"
+#include "PadCandidatePool.h"
 
 static const String FREESOUND_SAMPLER_MIME_TYPE = "application/x-freesound-sampler-data"; // for inter plugin drag and drop
 
@@ -189,6 +190,8 @@ protected:
 
     // Waveform loading and drawing
     void loadWaveform();
+    void loadWaveformFromFile();
+    void showWaveformOf(const DecodedSample& sample);
     void drawWaveform(Graphics& g, Rectangle<int> bounds);
     void drawPlayhead(Graphics& g, Rectangle<int> bounds);
     void drawPreviewPlayhead(Graphics& g, Rectangle<int> bounds); // NEW: Preview playhead
@@ -206,6 +209,7 @@ protected:
     AudioThumbnailCache audioThumbnailCache;
     std::unique_ptr<AudioFormatReader> audioReader;
     AudioThumbnail audioThumbnail;
+    SharedResourcePointer<DecodedSamplePool> samplePool;
 
     String sampleName;
     String authorName;
@@ -268,6 +272,7 @@ class SampleGridComponent : public Component,
                             public DragAndDropContainer,
                             public DragAndDropTarget,      // for drag and drop between pads or different instances of same VST
                             public FileDragAndDropTarget,  // Add for external files between different targets or compatible apps
+                            public AudioDownloadManager::Listener,
                             public Timer
 {
 public:
@@ -342,11 +347,28 @@ private:
     std::array<bool, TOTAL_PADS> masterSearchConnections; // tracks visual positions (0-15)
     MasterSearchPanel masterSearchPanel;
 
-    // Single pad download management (simplified)
+    // Single pad downloads share one manager; each pad finishes from the manager's
+    // per-sound events. The manager downloads a sound once however many pads asked for
+    // it, so one event serves every pad waiting for that sound. Only touched on the
+    // message thread.
+    struct SinglePadDownload
+    {
+        int padIndex = -1;
+        FSSound sound;
+        String query;
+    };
+
     std::unique_ptr<AudioDownloadManager> singlePadDownloadManager;
-    int currentDownloadPadIndex = -1;
-    FSSound currentDownloadSound;
-    String currentDownloadQuery;
+    Array<SinglePadDownload> singlePadDownloads;
+
+    // The manager calls back from its workers, where a SafePointer must not be created
+    // (that would race the message thread for the component's weak reference). This one
+    // is made with the component and only copied from there.
+    Component::SafePointer<SampleGridComponent> safeThisForDownloads { this };
+
+    // Prefetched alternatives for re-searching pads, created on first use
+    std::unique_ptr<PadCandidatePool> candidatePool;
+    PadCandidatePool& getCandidatePool();
 
     // Helper methods
     void loadSamplesFromJson(const File& metadataFile);
@@ -356,11 +378,19 @@ private:
         const FSSound& sound, const File& audioFile, const String& query);
     void downloadSingleSampleWithQuery(int padIndex, const FSSound& sound, const String& query);
     void updateProcessorArraysFromGrid();
-    Array<FSSound> searchSingleSound(const String& query);
+    void handleSinglePadSearchResults(int padIndex, const String& query, const Array<FSSound>& searchResults);
     void loadSingleSample(int padIndex, const FSSound& sound, const File& audioFile);
     void downloadSingleSample(int padIndex, const FSSound& sound);
     void updateSinglePadInProcessor(int padIndex, const FSSound& sound);
-    void cleanupSingleDownload();  // Add cleanup method
+    void watchSinglePadAudioData();
+    bool isPadDownloading(int padIndex) const;
+    Array<int> findSinglePadDownloads(const FSSound& sound) const;
+
+    // AudioDownloadManager::Listener (single pad downloads)
+    void downloadProgressChanged(const AudioDownloadManager::DownloadProgress&) override {}
+    void downloadCompleted(bool) override {}
+    void soundDownloadProgress(const FSSound& sound, int64 downloaded, int64 total) override;
+    void soundDownloadFinished(const FSSound& sound, const File& file, bool success) override;
 
     // Position conversion helpers
     int getVisualPositionFromRowCol(int row, int col) const;
@@ -389,6 +419,8 @@ private:
     void updateProcessorArraysForMasterSearch(const Array<FSSound>& sounds,
     const std::vector<StringArray>& soundInfo, const Array<int>& targetPads, const String& masterQuery);
     void executeMasterSearch(const String& masterQuery, const Array<int>& targetPadIndices);
+    void handleMasterSearchResults(const String& masterQuery, const Array<int>& targetPadIndices,
+        const Array<FSSound>& finalSounds, const std::vector<StringArray>& soundInfo);
 
     Array<int> pendingMasterSearchPads;
     String pendingMasterSearchQuery;
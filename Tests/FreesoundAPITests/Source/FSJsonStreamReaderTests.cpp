@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+    FSJsonStreamReaderTests.cpp
+    Tests of the streaming JSON reader and of the search result lists built
+    with it
+
+  ==============================================================================
+*/
+
+#include "FreesoundAPI/FreesoundAPI.h"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // Hands out its data a few bytes at a time, so that every token crosses a buffer refill
+    class TrickleInputStream : public InputStream
+    {
+    public:
+        TrickleInputStream(const String& text, int maxBytesPerRead)
+            : data(text.toRawUTF8(), text.getNumBytesAsUTF8()), chunkSize(maxBytesPerRead) {}
+
+        int64 getTotalLength() override { return (int64) data.getSize(); }
+        bool isExhausted() override { return position >= data.getSize(); }
+        int64 getPosition() override { return (int64) position; }
+        bool setPosition(int64) override { return false; }
+
+        int read(void* destBuffer, int maxBytesToRead) override
+        {
+            const int numBytes = (int) jmin((size_t) jmin(maxBytesToRead, chunkSize), data.getSize() - position);
+            memcpy(destBuffer, static_cast<const char*>(data.getData()) + position, (size_t) numBytes);
+            position += (size_t) numBytes;
+            return numBytes;
+        }
+
+    private:
+        MemoryBlock data;
+        int chunkSize;
+        size_t position = 0;
+    };
+
+    String readStringFrom(const String& json)
+    {
+        MemoryInputStream stream(json.toRawUTF8(), json.getNumBytesAsUTF8(), false);
+        FSJsonStreamReader reader(stream);
+        const String value = reader.readString();
+        REQUIRE_FALSE(reader.hasFailed());
+        return value;
+    }
+
+    String replacementCharacter() { return String::charToString((juce_wchar) 0xfffd); }
+
+    const char* searchPage = R"({
+        "count": 2,
+        "next": "https://freesound.org/apiv2/search/text/?page=2",
+        "previous": null,
+        "results": [
+            {
+                "id": 1234,
+                "name": "Kick \"dry\"",
+                "tags": ["kick", "drum"],
+                "username": "someone",
+                "license": "http://creativecommons.org/publicdomain/zero/1.0/",
+                "duration": 0.25,
+                "num_downloads": 42,
+                "avg_rating": 3.5,
+                "num_ratings": 7,
+                "pack": "https://freesound.org/apiv2/packs/77/",
+                "previews": { "preview-hq-ogg": "https://cdn.freesound.org/previews/1/1234_5-hq.ogg" },
+                "analysis": { "lowlevel": { "spectral_centroid": { "mean": 1523.5 } } },
+                "url": "https://freesound.org/people/someone/sounds/1234/"
+            },
+            {
+                "id": 5678,
+                "name": "Snare",
+                "tags": null,
+                "username": "someone",
+                "duration": 1.75
+            }
+        ]
+    })";
+}
+
+TEST_CASE("FSJsonStreamReader reads objects, arrays and scalars in order", "[FSJsonStreamReader]")
+{
+    const String json = R"({ "count": 3, "next": null, "results": [1, 2.5, "x", true, false] })";
+    MemoryInputStream stream(json.toRawUTF8(), json.getNumBytesAsUTF8(), false);
+    FSJsonStreamReader reader(stream);
+
+    String key;
+    REQUIRE(reader.beginObject());
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "count");
+    CHECK((int) reader.readValue() == 3);
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "next");
+    CHECK(reader.nextIsNull());
+    CHECK(reader.readString().isEmpty());
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "results");
+    REQUIRE(reader.beginArray());
+
+    Array<var> elements;
+    while (reader.nextElement())
+        elements.add(reader.readValue());
+
+    REQUIRE(elements.size() == 5);
+    CHECK((int) elements[0] == 1);
+    CHECK((double) elements[1] == 2.5);
+    CHECK(elements[2].toString() == "x");
+    CHECK((bool) elements[3]);
+    CHECK_FALSE((bool) elements[4]);
+
+    CHECK_FALSE(reader.nextKey(key));
+    CHECK_FALSE(reader.hasFailed());
+}
+
+TEST_CASE("FSJsonStreamReader skips and captures nested values", "[FSJsonStreamReader]")
+{
+    const String json = R"({ "skipped": { "a": [1, { "b": "}]" }] }, "raw": { "x": [1, 2] }, "last": true })";
+    MemoryInputStream stream(json.toRawUTF8(), json.getNumBytesAsUTF8(), false);
+    FSJsonStreamReader reader(stream);
+
+    String key;
+    REQUIRE(reader.beginObject());
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "skipped");
+    reader.skipValue();
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "raw");
+    const var raw = JSON::parse(reader.readRawValue());
+    CHECK((int) raw["x"][1] == 2);
+
+    REQUIRE(reader.nextKey(key));
+    CHECK(key == "last");
+    CHECK((bool) reader.readValue());
+
+    CHECK_FALSE(reader.nextKey(key));
+    CHECK_FALSE(reader.hasFailed());
+}
+
+TEST_CASE("FSJsonStreamReader decodes string escapes", "[FSJsonStreamReader]")
+{
+    CHECK(readStringFrom(R"("a\"b\\c\/d\te")") == "a\"b\\c/d\te");
+    CHECK(readStringFrom(R"("caf\u00e9")") == String(CharPointer_UTF8("caf\xc3\xa9")));
+    CHECK(readStringFrom(R"("\u20AC")") == String::charToString((juce_wchar) 0x20ac));
+}
+
+TEST_CASE("FSJsonStreamReader combines surrogate pairs and replaces unpaired halves", "[FSJsonStreamReader]")
+{
+    const String grinningFace = String::charToString((juce_wchar) 0x1f600);
+
+    CHECK(readStringFrom(R"("\ud83d\ude00")") == grinningFace);
+    CHECK(readStringFrom(R"("\ud83dx")") == replacementCharacter() + "x");
+    CHECK(readStringFrom(R"("\ude00")") == replacementCharacter());
+    CHECK(readStringFrom(R"("\ud83d\n")") == replacementCharacter() + "\n");
+    CHECK(readStringFrom(R"("\ud83d\u0041")") == replacementCharacter() + "A");
+    CHECK(readStringFrom(R"("\ud83d\ud83d\ude00")") == replacementCharacter() + grinningFace);
+    CHECK(readStringFrom(R"("\ud83d")") == replacementCharacter());
+
+    // The text stays valid UTF-8 all the way through
+    const String decoded = readStringFrom(R"("a\ud83d")");
+    CHECK(CharPointer_UTF8::isValidString(decoded.toRawUTF8(), (int) decoded.getNumBytesAsUTF8()));
+}
+
+TEST_CASE("FSJsonStreamReader reports malformed text", "[FSJsonStreamReader]")
+{
+    for (const char* json : { R"({ "a": [1, 2 } })", R"({ "a" 1 })", R"({ "a": "unterminated)", R"({ "a": "\x" })", R"({ "a": "\u12" })" })
+    {
+        const String text(json);
+        MemoryInputStream stream(text.toRawUTF8(), text.getNumBytesAsUTF8(), false);
+        FSJsonStreamReader reader(stream);
+
+        String key;
+        if (reader.beginObject())
+            while (reader.nextKey(key))
+                reader.readValue();
+
+        INFO(text);
+        CHECK(reader.hasFailed());
+    }
+}
+
+TEST_CASE("SoundList::fromStream builds compact sounds", "[FSJsonStreamReader][SoundList]")
+{
+    MemoryInputStream stream(searchPage, strlen(searchPage), false);
+    bool parsedOk = false;
+    SoundList list = SoundList::fromStream(stream, &parsedOk);
+    REQUIRE(parsedOk);
+
+    CHECK(list.getCount() == 2);
+    CHECK(list.getNextPage() == "https://freesound.org/apiv2/search/text/?page=2");
+
+    const Array<FSCompactSound> sounds = list.toArrayOfCompactSounds();
+    REQUIRE(sounds.size() == 2);
+
+    const FSCompactSound& kick = sounds.getReference(0);
+    CHECK(kick.id == 1234);
+    CHECK(kick.name == "Kick \"dry\"");
+    CHECK(kick.tags == StringArray({ "kick", "drum" }));
+    CHECK(kick.packId == 77);
+    CHECK(kick.getOGGPreviewURL().toString(false) == "https://cdn.freesound.org/previews/1/1234_5-hq.ogg");
+    CHECK((double) kick.getAnalysis()["lowlevel"]["spectral_centroid"]["mean"] == 1523.5);
+
+    // Fractional durations survive the expansion into FSSound
+    const FSSound expanded = kick.toFSSound();
+    CHECK(expanded.id == "1234");
+    CHECK(expanded.duration == 0.25);
+    CHECK(sounds.getReference(1).toFSSound().duration == 1.75);
+    CHECK(sounds.getReference(1).tags.isEmpty());
+}
+
+TEST_CASE("SoundList::fromStream and the JSON DOM build the same sounds", "[FSJsonStreamReader][SoundList]")
+{
+    MemoryInputStream stream(searchPage, strlen(searchPage), false);
+    const Array<FSCompactSound> compact = SoundList::fromStream(stream).toArrayOfCompactSounds();
+    const Array<FSSound> parsed = SoundList(JSON::parse(String(searchPage))).toArrayOfSounds();
+
+    REQUIRE(compact.size() == 2);
+    REQUIRE(parsed.size() == 2);
+
+    const FSSound expanded = compact.getReference(0).toFSSound();
+    const FSSound& kick = parsed.getReference(0);
+    CHECK(kick.id == expanded.id);
+    CHECK(kick.name == expanded.name);
+    CHECK(kick.duration == expanded.duration);
+    CHECK(kick.numDownloads == 42);
+    CHECK(kick.numDownloads == expanded.numDownloads);
+    CHECK(kick.avgRating == expanded.avgRating);
+    CHECK(kick.numRatings == expanded.numRatings);
+}
+
+TEST_CASE("SoundList::fromStream gives the same result however the stream is split", "[FSJsonStreamReader][SoundList]")
+{
+    MemoryInputStream whole(searchPage, strlen(searchPage), false);
+    TrickleInputStream trickle(searchPage, 7);
+
+    bool wholeOk = false, trickleOk = false;
+    const Array<FSCompactSound> expected = SoundList::fromStream(whole, &wholeOk).toArrayOfCompactSounds();
+    const Array<FSCompactSound> actual = SoundList::fromStream(trickle, &trickleOk).toArrayOfCompactSounds();
+
+    REQUIRE(wholeOk);
+    REQUIRE(trickleOk);
+    REQUIRE(actual.size() == expected.size());
+
+    for (int i = 0; i < actual.size(); ++i)
+    {
+        CHECK(actual[i].id == expected[i].id);
+        CHECK(actual[i].name == expected[i].name);
+        CHECK(actual[i].tags == expected[i].tags);
+        CHECK(actual[i].duration == expected[i].duration);
+        CHECK(actual[i].getOGGPreviewURL() == expected[i].getOGGPreviewURL());
+    }
+}
+
+TEST_CASE("SoundList::fromStream rejects truncated pages", "[FSJsonStreamReader][SoundList]")
+{
+    const String truncated = String(searchPage).substring(0, 200);
+    MemoryInputStream stream(truncated.toRawUTF8(), truncated.getNumBytesAsUTF8(), false);
+
+    bool parsedOk = true;
+    const SoundList list = SoundList::fromStream(stream, &parsedOk);
+    CHECK_FALSE(parsedOk);
+}
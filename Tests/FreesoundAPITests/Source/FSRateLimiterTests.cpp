@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    FSRateLimiterTests.cpp
+    Tests of the rate limiter: token budgets, Retry-After parsing and the
+    retry policy
+
+  ==============================================================================
+*/
+
+#include "FreesoundAPI/FreesoundAPI.h"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    URL soundURL() { return URIS::uri(URIS::SOUND, { "1234" }); }
+    URL searchURL() { return URIS::uri(URIS::TEXT_SEARCH, {}); }
+}
+
+TEST_CASE("FSRateLimiter parses Retry-After given in seconds or as a date", "[FSRateLimiter]")
+{
+    CHECK(FSRateLimiter::parseRetryAfter("120") == 120000);
+    CHECK(FSRateLimiter::parseRetryAfter(" 0 ") == 0);
+    CHECK(FSRateLimiter::parseRetryAfter(String()) == -1);
+    CHECK(FSRateLimiter::parseRetryAfter("soon") == -1);
+    CHECK(FSRateLimiter::parseRetryAfter("Wed, 21 Foo 2015 07:28:00 GMT") == -1);
+
+    // Dates in the past mean right away, dates in the future are counted from now
+    CHECK(FSRateLimiter::parseRetryAfter("Wed, 21 Oct 2015 07:28:00 GMT") == 0);
+    CHECK(FSRateLimiter::parseRetryAfter("Fri, 01 Jan 2100 00:00:00 GMT") > 0);
+}
+
+TEST_CASE("FSRateLimiter lets a burst through and then spaces requests out", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setBudget(String(), 600.0, 2);   // one request every 100 ms
+
+    CHECK(limiter.acquire(soundURL()) == 0);
+    CHECK(limiter.acquire(soundURL()) == 0);
+    CHECK(limiter.acquire(soundURL()) >= 50);
+
+    const FSRateLimiter::Stats stats = limiter.getStats();
+    CHECK(stats.requests == 3);
+    CHECK(stats.throttledRequests == 1);
+    CHECK(stats.throttledMilliseconds >= 50);
+
+    limiter.resetStats();
+    CHECK(limiter.getStats().requests == 0);
+}
+
+TEST_CASE("FSRateLimiter keeps the budgets of endpoints apart", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setBudget(URIS::TEXT_SEARCH, 6.0, 1);   // one search every 10 s
+
+    CHECK(limiter.acquire(searchURL()) == 0);
+
+    // Searching used up the search budget only
+    CHECK(limiter.acquire(soundURL()) == 0);
+}
+
+TEST_CASE("FSRateLimiter matches budgets on anchored path segments", "[FSRateLimiter]")
+{
+    const URL userSoundsURL = URIS::uri(URIS::USER_SOUNDS, { "someone" });
+
+    SECTION("a literal endpoint only matches the start of the path")
+    {
+        FSRateLimiter limiter;
+        limiter.setBudget("/sounds/", 600.0, 1);
+
+        // The sounds of a user are not under /sounds/, so they keep the default budget
+        CHECK(limiter.acquire(userSoundsURL) == 0);
+        CHECK(limiter.acquire(userSoundsURL) == 0);
+
+        CHECK(limiter.acquire(soundURL()) == 0);
+        CHECK(limiter.acquire(soundURL()) >= 50);
+    }
+
+    SECTION("placeholders of the URIS templates match any segment")
+    {
+        FSRateLimiter limiter;
+        limiter.setBudget(URIS::SOUND, 600.0, 1);
+
+        CHECK(limiter.acquire(soundURL()) == 0);
+        CHECK(limiter.acquire(URIS::uri(URIS::SOUND, { "5678" })) >= 50);
+
+        CHECK(limiter.acquire(userSoundsURL) == 0);
+        CHECK(limiter.acquire(userSoundsURL) == 0);
+    }
+}
+
+TEST_CASE("FSRateLimiter retries server errors with growing backoff", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setRetryPolicy(3, 100, 1000);
+    const URL url = soundURL();
+
+    int delayMs = 0;
+    REQUIRE(limiter.shouldRetry(url, 503, 0, String(), delayMs));
+    CHECK(delayMs >= 50);
+    CHECK(delayMs <= 100);
+
+    REQUIRE(limiter.shouldRetry(url, 500, 1, String(), delayMs));
+    CHECK(delayMs >= 100);
+    CHECK(delayMs <= 200);
+
+    REQUIRE(limiter.shouldRetry(url, 502, 2, String(), delayMs));
+    CHECK(delayMs >= 200);
+    CHECK(delayMs <= 400);
+
+    CHECK_FALSE(limiter.shouldRetry(url, 503, 3, String(), delayMs));
+
+    const FSRateLimiter::Stats stats = limiter.getStats();
+    CHECK(stats.retries == 3);
+    CHECK(stats.serverErrorResponses == 4);
+    CHECK(stats.failedAfterRetries == 1);
+}
+
+TEST_CASE("FSRateLimiter does not retry successes or client errors", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    int delayMs = 0;
+
+    for (const int statusCode : { 200, 304, 400, 401, 404 })
+        CHECK_FALSE(limiter.shouldRetry(soundURL(), statusCode, 0, String(), delayMs));
+
+    CHECK(limiter.getStats().retries == 0);
+    CHECK(limiter.getStats().failedAfterRetries == 0);
+}
+
+TEST_CASE("FSRateLimiter honours Retry-After beyond its own maximum backoff", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setRetryPolicy(3, 100, 1000, 120000);
+
+    int delayMs = 0;
+    REQUIRE(limiter.shouldRetry(soundURL(), 429, 0, "60", delayMs));
+    CHECK(delayMs == 60000);
+    CHECK(limiter.getStats().rateLimitedResponses == 1);
+}
+
+TEST_CASE("FSRateLimiter gives up on Retry-After longer than it is willing to wait", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setRetryPolicy(3, 100, 1000, 5000);
+
+    int delayMs = 0;
+    CHECK_FALSE(limiter.shouldRetry(soundURL(), 429, 0, "60", delayMs));
+    CHECK(limiter.getStats().failedAfterRetries == 1);
+}
+
+TEST_CASE("FSRateLimiter refuses requests during a pause longer than it is willing to wait", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setRetryPolicy(3, 100, 1000, 5000);
+
+    int delayMs = 0;
+    CHECK_FALSE(limiter.shouldRetry(soundURL(), 429, 0, "3600", delayMs));
+
+    // Fails at once instead of sleeping for the hour
+    const double startMs = Time::getMillisecondCounterHiRes();
+    CHECK(limiter.acquire(soundURL()) == -1);
+    CHECK(limiter.acquire(searchURL()) == -1);
+    CHECK(Time::getMillisecondCounterHiRes() - startMs < 500.0);
+
+    CHECK(limiter.getStats().refusedRequests == 2);
+    CHECK(limiter.getStats().requests == 0);
+}
+
+TEST_CASE("FSRateLimiter pauses an endpoint after a 429", "[FSRateLimiter]")
+{
+    FSRateLimiter limiter;
+    limiter.setRetryPolicy(3, 10, 100, 5000);
+
+    int delayMs = 0;
+    REQUIRE(limiter.shouldRetry(soundURL(), 429, 0, "1", delayMs));
+    CHECK(delayMs == 1000);
+
+    // Everyone using the endpoint waits for the pause, not only the request that was throttled
+    CHECK(limiter.acquire(soundURL()) >= 900);
+}
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    FSResponseCacheTests.cpp
+    Tests of the on-disk response cache: keys, time to live rules, expiry,
+    revalidation and eviction
+
+  ==============================================================================
+*/
+
+#include "FreesoundAPI/FreesoundAPI.h"
+#include <catch2/catch_test_macros.hpp>
+
+namespace
+{
+    // A cache directory of its own for every test, removed afterwards
+    struct TemporaryCacheDirectory
+    {
+        TemporaryCacheDirectory()
+            : directory(File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("FSResponseCacheTests", "", false)) {}
+
+        ~TemporaryCacheDirectory() { directory.deleteRecursively(); }
+
+        File directory;
+    };
+
+    String keyFor(const String& resource, const StringArray& replacements = {})
+    {
+        return FSResponseCache::getKeyFor(URIS::uri(resource, replacements));
+    }
+
+    String readBody(const FSResponseCache::Entry& entry)
+    {
+        return entry.file.loadFileAsString();
+    }
+}
+
+TEST_CASE("FSResponseCache keys do not depend on the order of the parameters", "[FSResponseCache]")
+{
+    const URL search = URIS::uri(URIS::TEXT_SEARCH, {});
+    const URL pageFirst = search.withParameter("page", "2").withParameter("query", "kick");
+    const URL queryFirst = search.withParameter("query", "kick").withParameter("page", "2");
+
+    CHECK(FSResponseCache::getKeyFor(pageFirst) == FSResponseCache::getKeyFor(queryFirst));
+    CHECK(FSResponseCache::getKeyFor(pageFirst) != FSResponseCache::getKeyFor(search.withParameter("query", "kick")));
+}
+
+TEST_CASE("FSResponseCache stores and looks up responses", "[FSResponseCache]")
+{
+    TemporaryCacheDirectory temporary;
+    FSResponseCache cache(temporary.directory);
+    const String key = keyFor(URIS::SOUND, { "1234" });
+
+    CHECK_FALSE(cache.lookup(key).found);
+
+    cache.store(key, R"({"id": 1234})", "\"abc\"", "Wed, 21 Oct 2015 07:28:00 GMT");
+    const FSResponseCache::Entry entry = cache.lookup(key);
+
+    REQUIRE(entry.found);
+    CHECK(entry.fresh);
+    CHECK(readBody(entry) == R"({"id": 1234})");
+    CHECK(entry.eTag == "\"abc\"");
+    CHECK(entry.lastModified == "Wed, 21 Oct 2015 07:28:00 GMT");
+    CHECK(cache.getTotalSize() == entry.file.getSize());
+
+    // A second cache on the same directory picks the entry up from disk
+    FSResponseCache reopened(temporary.directory);
+    const FSResponseCache::Entry reloaded = reopened.lookup(key);
+    REQUIRE(reloaded.found);
+    CHECK(readBody(reloaded) == R"({"id": 1234})");
+    CHECK(reloaded.eTag == "\"abc\"");
+}
+
+TEST_CASE("FSResponseCache picks time to live rules by anchored path segments", "[FSResponseCache]")
+{
+    TemporaryCacheDirectory temporary;
+    FSResponseCache cache(temporary.directory);
+
+    auto ttlOf = [&cache](const String& resource, const StringArray& replacements = {})
+    {
+        return cache.getTimeToLive(keyFor(resource, replacements));
+    };
+
+    CHECK(ttlOf(URIS::SOUND, { "1234" }) == RelativeTime::days(7));
+    CHECK(ttlOf(URIS::PACK, { "77" }) == RelativeTime::days(7));
+    CHECK(ttlOf(URIS::USER, { "someone" }) == RelativeTime::days(1));
+    CHECK(ttlOf(URIS::TEXT_SEARCH) == RelativeTime::hours(1));
+    CHECK(ttlOf(URIS::COMMENTS, { "1234" }) == RelativeTime::hours(1));
+    CHECK(ttlOf(URIS::PENDING).inMilliseconds() == 0);
+    CHECK(ttlOf(URIS::ME).inMilliseconds() == 0);
+
+    // The sounds of a user are a user resource, not a sound resource
+    CHECK(ttlOf(URIS::USER_SOUNDS, { "someone" }) == RelativeTime::days(1));
+
+    // A user called "sounds" does not make its page a sound resource either
+    CHECK(ttlOf(URIS::USER, { "sounds" }) == RelativeTime::days(1));
+
+    cache.setDefaultTimeToLive(RelativeTime::minutes(5));
+    CHECK(cache.getTimeToLive(FSResponseCache::getKeyFor(URL(URIS::getBaseURL() + "/descriptors/"))) == RelativeTime::minutes(5));
+
+    // Placeholders match any segment, and a longer rule wins over a shorter one
+    cache.setTimeToLive(URIS::PACK_SOUNDS, RelativeTime::hours(2));
+    CHECK(ttlOf(URIS::PACK_SOUNDS, { "77" }) == RelativeTime::hours(2));
+    CHECK(ttlOf(URIS::PACK, { "77" }) == RelativeTime::days(7));
+}
+
+TEST_CASE("FSResponseCache does not store endpoints with a time to live of zero", "[FSResponseCache]")
+{
+    TemporaryCacheDirectory temporary;
+    FSResponseCache cache(temporary.directory);
+    const String key = keyFor(URIS::ME);
+
+    cache.store(key, R"({"username": "someone"})", String(), String());
+
+    CHECK_FALSE(cache.lookup(key).found);
+    CHECK(cache.getTotalSize() == 0);
+}
+
+TEST_CASE("FSResponseCache keeps stale entries for revalidation", "[FSResponseCache]")
+{
+    TemporaryCacheDirectory temporary;
+    FSResponseCache cache(temporary.directory);
+    cache.setTimeToLive("/sounds/", RelativeTime::milliseconds(50));
+    const String key = keyFor(URIS::SOUND, { "1234" });
+
+    cache.store(key, R"({"id": 1234})", "\"abc\"", String());
+    Thread::sleep(100);
+
+    const FSResponseCache::Entry stale = cache.lookup(key);
+    REQUIRE(stale.found);
+    CHECK_FALSE(stale.fresh);
+    CHECK(stale.eTag == "\"abc\"");
+
+    cache.markRevalidated(key);
+    CHECK(cache.lookup(key).fresh);
+}
+
+TEST_CASE("FSResponseCache evicts the least recently used entries over its size cap", "[FSResponseCache]")
+{
+    TemporaryCacheDirectory temporary;
+    const String body = String::repeatedString("x", 100);
+    FSResponseCache cache(temporary.directory, 350);
+
+    const String first = keyFor(URIS::SOUND, { "1" });
+    const String second = keyFor(URIS::SOUND, { "2" });
+    const String third = keyFor(URIS::SOUND, { "3" });
+    const String fourth = keyFor(URIS::SOUND, { "4" });
+
+    // Spaced out, so that the times of use are all different
+    for (const auto& key : { first, second, third })
+    {
+        cache.store(key, body, String(), String());
+        Thread::sleep(20);
+    }
+
+    CHECK(cache.lookup(first).found);
+    Thread::sleep(20);
+    cache.store(fourth, body, String(), String());
+
+    CHECK(cache.lookup(first).found);
+    CHECK_FALSE(cache.lookup(second).found);
+    CHECK(cache.lookup(third).found);
+    CHECK(cache.lookup(fourth).found);
+    CHECK(cache.getTotalSize() <= 350);
+
+    cache.clear();
+    CHECK(cache.getTotalSize() == 0);
+    CHECK_FALSE(cache.lookup(first).found);
+}
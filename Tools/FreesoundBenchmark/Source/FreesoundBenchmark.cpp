@@ -0,0 +1,796 @@
+/*
+  ==============================================================================
+
+    FreesoundBenchmark.cpp
+    Benchmarks of the Freesound API client, run against the Freesound
+    mock server
+
+  ==============================================================================
+*/
+
+#include "FreesoundBenchmark.h"
+#include "Plugins/FreesoundAdvancedSampler/Source/AudioDownloadManager.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#if JUCE_LINUX
+ #include <malloc.h>
+#elif JUCE_MAC
+ #include <malloc/malloc.h>
+#endif
+
+// Same fields as the searches of the sampler
+static const String searchFields = "id,name,username,license,previews,tags,description";
+
+//==============================================================================
+// Helpers
+//==============================================================================
+
+static String getOptionValue(const StringArray& args, const String& name)
+{
+    for (int i = 0; i < args.size(); ++i)
+    {
+        if (args[i].startsWith(name + "="))
+            return args[i].fromFirstOccurrenceOf("=", false, false);
+
+        if (args[i] == name && i + 1 < args.size() && ! args[i + 1].startsWith("--"))
+            return args[i + 1];
+    }
+
+    return {};
+}
+
+// Bytes allocated on the heap right now, or -1 where the allocator does not say.
+// Counts what JUCE allocates with std::malloc too, which operator new hooks would miss.
+static int64 getHeapBytesInUse()
+{
+   #if JUCE_LINUX && defined (__GLIBC__)
+    #if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+     const struct mallinfo2 info = mallinfo2();
+     return (int64) (info.uordblks + info.hblkhd);
+    #else
+     const struct mallinfo info = mallinfo();
+     return (int64) (unsigned int) info.uordblks + (int64) (unsigned int) info.hblkhd;
+    #endif
+   #elif JUCE_MAC
+    malloc_statistics_t stats;
+    malloc_zone_statistics (nullptr, &stats);
+    return (int64) stats.size_in_use;
+   #else
+    return -1;
+   #endif
+}
+
+static double getMedian(Array<double> values)
+{
+    if (values.isEmpty())
+        return 0.0;
+
+    values.sort();
+    const int middle = values.size() / 2;
+    return values.size() % 2 != 0 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+static String formatBytes(double bytes)
+{
+    if (bytes < 0.0)
+        return "n/a";
+
+    if (std::abs(bytes) >= 1024.0 * 1024.0)
+        return String(bytes / (1024.0 * 1024.0), 2) + " MB";
+
+    return String(bytes / 1024.0, 1) + " KB";
+}
+
+static void print(const String& line)
+{
+    std::cout << line << std::endl;
+}
+
+//==============================================================================
+// Options
+//==============================================================================
+
+BenchmarkOptions BenchmarkOptions::fromArguments(const StringArray& args)
+{
+    BenchmarkOptions options;
+    options.serverOptions = MockServerOptions::fromArguments(args);
+
+    const String benchmarks = getOptionValue(args, "--benchmark");
+    if (benchmarks.isNotEmpty() && benchmarks != "all")
+        options.benchmarks = StringArray::fromTokens(benchmarks, ",", "");
+
+    const String workers = getOptionValue(args, "--workers");
+    if (workers.isNotEmpty())
+    {
+        options.workerCounts.clear();
+
+        for (auto& count : StringArray::fromTokens(workers, ",", ""))
+            if (count.getIntValue() > 0)
+                options.workerCounts.add(count.getIntValue());
+    }
+
+    auto intOption = [&args](const String& name, int defaultValue)
+    {
+        const String value = getOptionValue(args, name);
+        return value.isNotEmpty() ? value.getIntValue() : defaultValue;
+    };
+
+    options.baseURL = getOptionValue(args, "--base-url").trimCharactersAtEnd("/");
+
+    const String query = getOptionValue(args, "--query");
+    if (query.isNotEmpty())
+        options.query = query;
+
+    options.repeats = jmax(1, intOption("--repeats", options.repeats));
+    options.gridSize = jlimit(1, 150, intOption("--grid-size", options.gridSize));
+    options.progressSounds = jlimit(1, 150, intOption("--progress-sounds", options.progressSounds));
+
+    const String progressSeconds = getOptionValue(args, "--progress-preview-seconds");
+    if (progressSeconds.isNotEmpty())
+        options.progressPreviewSeconds = jlimit(1.0, 600.0, progressSeconds.getDoubleValue());
+
+    options.progressPublishes = jlimit(1000, 100000000, intOption("--publishes", options.progressPublishes));
+
+    return options;
+}
+
+String BenchmarkOptions::getUsage()
+{
+    return "FreesoundBenchmark [options] [mock server options]\n"
+           "\n"
+           "  --benchmark <list>              Comma separated list of search, grid, progress and\n"
+           "                                    progress-overhead (default all)\n"
+           "  --base-url <url>                Run against a server that is already running instead of an\n"
+           "                                    in-process mock server (e.g. http://127.0.0.1:8085/apiv2)\n"
+           "  --query <text>                  Query searched by every benchmark (default \"drum loop\")\n"
+           "  --repeats <n>                   Runs of each measurement, the median is reported (default 5)\n"
+           "  --workers <list>                Worker counts of the grid and progress-overhead benchmarks\n"
+           "                                    (default 1,4,8)\n"
+           "  --grid-size <n>                 Sounds in the grid (default 16)\n"
+           "  --progress-sounds <n>           Sounds downloaded by the progress benchmark (default 4)\n"
+           "  --progress-preview-seconds <s>  Length of the previews of the progress benchmark (default 60)\n"
+           "  --publishes <n>                 Progress updates per worker of the progress-overhead benchmark\n"
+           "                                    (default 1000000)\n"
+           "\n"
+           "search    Fetches every page of the query (150 results each), then parses them with the DOM\n"
+           "          (JSON::parse + FSSound) and with the streaming reader (FSCompactSound): median time\n"
+           "          and heap kept by the results.\n"
+           "grid      Fills a grid with AudioDownloadManager once per worker count: wall time and throughput.\n"
+           "progress  Downloads long previews: throughput, and the number of and largest gap between the\n"
+           "          progress updates the UI receives.\n"
+           "progress-overhead\n"
+           "          No server: workers publish their progress as after every read while a timer samples\n"
+           "          it, once with one lock shared by all (as the manager used to) and once with the\n"
+           "          per-worker atomics it uses now. Time per publish on each worker and per sample.\n"
+           "\n"
+           "The in-process servers listen on --port, --port + 1 and --port + 2, one per benchmark.\n"
+           "The remaining options are those of the mock server:\n"
+           "\n"
+           + MockServerOptions::getUsage();
+}
+
+//==============================================================================
+// Benchmark
+//==============================================================================
+
+FreesoundBenchmark::FreesoundBenchmark(const BenchmarkOptions& benchmarkOptions)
+    : options(benchmarkOptions)
+{
+}
+
+bool FreesoundBenchmark::run()
+{
+    bool allRan = true;
+
+    for (auto& benchmark : options.benchmarks)
+    {
+        if (benchmark == "search")
+            allRan = runSearchBenchmark() && allRan;
+        else if (benchmark == "grid")
+            allRan = runGridBenchmark() && allRan;
+        else if (benchmark == "progress")
+            allRan = runProgressBenchmark() && allRan;
+        else if (benchmark == "progress-overhead")
+            allRan = runProgressOverheadBenchmark() && allRan;
+        else
+        {
+            print("Unknown benchmark: " + benchmark);
+            allRan = false;
+        }
+    }
+
+    return allRan;
+}
+
+bool FreesoundBenchmark::startServer(std::unique_ptr<FreesoundMockServer>& server, MockServerOptions serverOptions, int portOffset)
+{
+    if (options.baseURL.isNotEmpty())
+    {
+        URIS::setBaseURL(options.baseURL);
+        return true;
+    }
+
+    serverOptions.port += portOffset;
+    serverOptions.durationSeconds = 0.0;
+    server = std::make_unique<FreesoundMockServer>(serverOptions);
+
+    if (! server->start())
+    {
+        print("Could not listen on " + serverOptions.bindAddress + ":" + String(serverOptions.port));
+        server.reset();
+        return false;
+    }
+
+    URIS::setBaseURL(server->getBaseURL());
+    return true;
+}
+
+//==============================================================================
+// search
+//==============================================================================
+
+bool FreesoundBenchmark::fetchSearchPages(Array<MemoryBlock>& pages)
+{
+    const URL search = URIS::uri(URIS::TEXT_SEARCH, {})
+                           .withParameter("query", options.query)
+                           .withParameter("page_size", "150")
+                           .withParameter("fields", searchFields);
+
+    for (int page = 1, numPages = 1; page <= numPages; ++page)
+    {
+        StringPairArray responseHeaders;
+        int statusCode = -1;
+        std::unique_ptr<InputStream> stream(search.withParameter("page", String(page))
+                                                  .createInputStream(false, nullptr, nullptr, "Authorization: Token benchmark",
+                                                                     10000, &responseHeaders, &statusCode));
+
+        MemoryBlock body;
+        if (stream == nullptr || statusCode != 200 || stream->readIntoMemoryBlock(body) == 0)
+        {
+            print("Could not fetch page " + String(page) + " of the search (status " + String(statusCode) + ")");
+            return false;
+        }
+
+        if (page == 1)
+        {
+            const int count = (int) JSON::parse(body.toString())["count"];
+            numPages = (count + 149) / 150;
+        }
+
+        pages.add(std::move(body));
+    }
+
+    return true;
+}
+
+bool FreesoundBenchmark::runSearchBenchmark()
+{
+    print("\n== search: \"" + options.query + "\" ==");
+
+    std::unique_ptr<FreesoundMockServer> server;
+    if (! startServer(server, options.serverOptions, 0))
+        return false;
+
+    // Fetched once up front, so that only the parsing is timed
+    const double fetchStartMs = Time::getMillisecondCounterHiRes();
+    Array<MemoryBlock> pages;
+    if (! fetchSearchPages(pages))
+        return false;
+
+    int64 totalBytes = 0;
+    for (auto& page : pages)
+        totalBytes += (int64) page.getSize();
+
+    print("fetched " + String(pages.size()) + " pages, " + formatBytes((double) totalBytes) + " in "
+          + String(Time::getMillisecondCounterHiRes() - fetchStartMs, 1) + " ms");
+
+    // Every run keeps its results alive while the heap is measured, as the plugin keeps its
+    // search results around
+    Array<double> domMs, domRetained, streamMs, streamRetained;
+    int numSounds = 0;
+
+    for (int run = 0; run < options.repeats; ++run)
+    {
+        {
+            const int64 heapBefore = getHeapBytesInUse();
+            const double startMs = Time::getMillisecondCounterHiRes();
+            Array<FSSound> sounds;
+
+            for (auto& page : pages)
+                sounds.addArray(SoundList(JSON::parse(page.toString())).toArrayOfSounds());
+
+            domMs.add(Time::getMillisecondCounterHiRes() - startMs);
+            domRetained.add(heapBefore < 0 ? -1.0 : (double) (getHeapBytesInUse() - heapBefore));
+            numSounds = sounds.size();
+        }
+
+        {
+            const int64 heapBefore = getHeapBytesInUse();
+            const double startMs = Time::getMillisecondCounterHiRes();
+            Array<FSCompactSound> sounds;
+
+            for (auto& page : pages)
+            {
+                MemoryInputStream stream(page, false);
+                sounds.addArray(SoundList::fromStream(stream).toArrayOfCompactSounds());
+            }
+
+            streamMs.add(Time::getMillisecondCounterHiRes() - startMs);
+            streamRetained.add(heapBefore < 0 ? -1.0 : (double) (getHeapBytesInUse() - heapBefore));
+
+            if (sounds.size() != numSounds)
+                print("warning: the streaming reader found " + String(sounds.size()) + " sounds, the DOM " + String(numSounds));
+        }
+    }
+
+    auto printResult = [numSounds](const String& name, const Array<double>& times, const Array<double>& retained)
+    {
+        const double retainedBytes = getMedian(retained);
+        print(name + String(getMedian(times), 2).paddedLeft(' ', 10) + " ms"
+              + formatBytes(retainedBytes).paddedLeft(' ', 12) + " kept"
+              + (retainedBytes < 0.0 || numSounds == 0 ? String() : "  (" + String(retainedBytes / numSounds, 0) + " bytes per sound)"));
+    };
+
+    print(String(numSounds) + " sounds, median of " + String(options.repeats) + " runs:");
+    printResult("  DOM (FSSound)          ", domMs, domRetained);
+    printResult("  stream (FSCompactSound)", streamMs, streamRetained);
+
+    // The whole client path for comparison: requests, streaming parse and compact results
+    const double clientStartMs = Time::getMillisecondCounterHiRes();
+    int clientSounds = 0;
+
+    for (int page = 1; page <= pages.size(); ++page)
+        clientSounds += client.textSearch(options.query, String(), "score", 0, page, 150, searchFields).toArrayOfCompactSounds().size();
+
+    print("  FreesoundClient::textSearch over every page: " + String(Time::getMillisecondCounterHiRes() - clientStartMs, 1)
+          + " ms for " + String(clientSounds) + " sounds");
+
+    if (server != nullptr)
+        print("server: " + JSON::toString(server->getStats(), true));
+
+    return numSounds > 0;
+}
+
+//==============================================================================
+// grid and progress
+//==============================================================================
+
+namespace
+{
+    // Waits for a download job and records when the UI hears of its progress
+    class DownloadWatcher : public AudioDownloadManager::Listener
+    {
+    public:
+        void downloadProgressChanged(const AudioDownloadManager::DownloadProgress&) override
+        {
+            // Only the samples the timer delivers to the message thread reach the UI; the final
+            // update is sent from the download thread right before completion
+            if (! MessageManager::existsAndIsCurrentThread())
+                return;
+
+            const ScopedLock lock(updateTimesLock);
+            updateTimes.add(Time::getMillisecondCounterHiRes());
+        }
+
+        void downloadCompleted(bool success) override
+        {
+            succeeded = success;
+            finished.signal();
+        }
+
+        Array<double> getUpdateTimes() const
+        {
+            const ScopedLock lock(updateTimesLock);
+            return updateTimes;
+        }
+
+        WaitableEvent finished;
+        std::atomic<bool> succeeded { false };
+
+    private:
+        CriticalSection updateTimesLock;
+        Array<double> updateTimes;
+    };
+}
+
+Array<FSSound> FreesoundBenchmark::searchSounds(int numSounds)
+{
+    return client.textSearch(options.query, String(), "score", 0, 1, numSounds, searchFields).toArrayOfSounds();
+}
+
+FreesoundBenchmark::DownloadRun FreesoundBenchmark::downloadSounds(const Array<FSSound>& sounds, int numWorkers)
+{
+    // The workers of the manager are the only limit: the process-wide transfer slots and
+    // the requests per host are opened up to match them for the run
+    SharedResourcePointer<DownloadService> downloadService;
+    const int previousMaxDownloads = downloadService->getMaxConcurrentDownloads();
+    const int previousMaxPerHost = FSHostLimiter::getShared().getMaxRequestsPerHost();
+    downloadService->setMaxConcurrentDownloads(jmax(numWorkers, previousMaxDownloads));
+    FSHostLimiter::getShared().setMaxRequestsPerHost(jmax(numWorkers, previousMaxPerHost));
+
+    const File directory = File::getSpecialLocation(File::tempDirectory).getNonexistentChildFile("FreesoundBenchmark", "", false);
+    directory.createDirectory();
+
+    DownloadRun result;
+    DownloadWatcher watcher;
+
+    {
+        AudioDownloadManager manager;
+        manager.setNumWorkers(numWorkers);
+        manager.addListener(&watcher);
+
+        const double startMs = Time::getMillisecondCounterHiRes();
+        manager.startDownloads(sounds, directory, options.query);
+        const bool finished = watcher.finished.wait(600000);
+        const double endMs = Time::getMillisecondCounterHiRes();
+
+        result.success = finished && watcher.succeeded;
+        result.seconds = (endMs - startMs) / 1000.0;
+
+        for (auto& stats : manager.getRecentTransferStats())
+            result.bytes += stats.bytesReceived;
+
+        manager.removeListener(&watcher);
+
+        // Gaps between the start, every update the UI received and the end of the job
+        Array<double> times = watcher.getUpdateTimes();
+        times.insert(0, startMs);
+        times.add(endMs);
+
+        result.numProgressUpdates = times.size() - 2;
+        for (int i = 1; i < times.size(); ++i)
+            result.maxProgressGapMs = jmax(result.maxProgressGapMs, times[i] - times[i - 1]);
+
+        result.meanProgressGapMs = (endMs - startMs) / (times.size() - 1);
+    }
+
+    directory.deleteRecursively();
+    downloadService->setMaxConcurrentDownloads(previousMaxDownloads);
+    FSHostLimiter::getShared().setMaxRequestsPerHost(previousMaxPerHost);
+    return result;
+}
+
+static String formatThroughput(int64 bytes, double seconds)
+{
+    return String(seconds > 0.0 ? (double) bytes / seconds / (1024.0 * 1024.0) : 0.0, 2) + " MB/s";
+}
+
+bool FreesoundBenchmark::runGridBenchmark()
+{
+    print("\n== grid: " + String(options.gridSize) + " sounds ==");
+
+    std::unique_ptr<FreesoundMockServer> server;
+    if (! startServer(server, options.serverOptions, 1))
+        return false;
+
+    const Array<FSSound> sounds = searchSounds(options.gridSize);
+    if (sounds.isEmpty())
+    {
+        print("The search found no sounds");
+        return false;
+    }
+
+    bool allSucceeded = true;
+
+    for (const int numWorkers : options.workerCounts)
+    {
+        Array<double> seconds;
+        Array<double> bytes;
+        int failures = 0;
+
+        for (int run = 0; run < options.repeats; ++run)
+        {
+            const DownloadRun result = downloadSounds(sounds, numWorkers);
+            seconds.add(result.seconds);
+            bytes.add((double) result.bytes);
+            failures += result.success ? 0 : 1;
+        }
+
+        const double medianSeconds = getMedian(seconds);
+        print("  " + String(numWorkers).paddedLeft(' ', 2) + " workers: "
+              + String(medianSeconds * 1000.0, 1).paddedLeft(' ', 9) + " ms  "
+              + formatThroughput((int64) getMedian(bytes), medianSeconds).paddedLeft(' ', 12)
+              + (failures > 0 ? "  (" + String(failures) + " of " + String(options.repeats) + " runs failed)" : String()));
+
+        allSucceeded = allSucceeded && failures == 0;
+    }
+
+    if (server != nullptr)
+        print("server: " + JSON::toString(server->getStats(), true));
+
+    return allSucceeded;
+}
+
+bool FreesoundBenchmark::runProgressBenchmark()
+{
+    print("\n== progress: " + String(options.progressSounds) + " sounds of "
+          + String(options.progressPreviewSeconds, 0) + " s ==");
+
+    // Long previews, so that every download spans many progress samples
+    MockServerOptions serverOptions = options.serverOptions;
+    serverOptions.previewSeconds = options.progressPreviewSeconds;
+
+    std::unique_ptr<FreesoundMockServer> server;
+    if (! startServer(server, serverOptions, 2))
+        return false;
+
+    if (options.baseURL.isNotEmpty())
+        print("(the preview length is that of the external server)");
+
+    const Array<FSSound> sounds = searchSounds(options.progressSounds);
+    if (sounds.isEmpty())
+    {
+        print("The search found no sounds");
+        return false;
+    }
+
+    // With the four workers the plugin uses by default
+    const DownloadRun result = downloadSounds(sounds, 4);
+
+    print("  " + formatBytes((double) result.bytes) + " in " + String(result.seconds, 2) + " s, "
+          + formatThroughput(result.bytes, result.seconds));
+    print("  " + String(result.numProgressUpdates) + " progress updates, every "
+          + String(result.meanProgressGapMs, 1) + " ms on average, largest gap "
+          + String(result.maxProgressGapMs, 1) + " ms");
+
+    if (! result.success)
+        print("  some downloads failed");
+
+    if (server != nullptr)
+        print("server: " + JSON::toString(server->getStats(), true));
+
+    return result.success;
+}
+
+//==============================================================================
+// progress-overhead
+//==============================================================================
+
+namespace
+{
+    // The two ways AudioDownloadManager has shared the progress of its workers with the UI
+    // timer, copied from it so that only the synchronisation differs. Each worker keeps its
+    // own Worker and publishes it after every read; sample() is what the timer runs.
+
+    // Before: every worker copies its whole progress, file name included, into an array
+    // behind the one lock the timer also takes
+    struct LockedProgress
+    {
+        struct Worker
+        {
+            bool active = false;
+            String fileName;
+            int64 downloaded = 0;
+            int64 total = 0;
+            uint32 startedAt = 0;
+        };
+
+        explicit LockedProgress(int numWorkers)
+        {
+            workers.resize(numWorkers);
+        }
+
+        Worker begin(int workerIndex, const String& fileName)
+        {
+            Worker progress;
+            progress.active = true;
+            progress.fileName = fileName;
+            progress.startedAt = Time::getMillisecondCounter();
+            publish(workerIndex, progress);
+            return progress;
+        }
+
+        void publish(int workerIndex, const Worker& progress)
+        {
+            const ScopedLock lock(progressLock);
+            workers.set(workerIndex, progress);
+        }
+
+        AudioDownloadManager::DownloadProgress sample()
+        {
+            AudioDownloadManager::DownloadProgress progress;
+            uint32 latestStart = 0;
+
+            const ScopedLock lock(progressLock);
+
+            for (const auto& worker : workers)
+            {
+                if (! worker.active)
+                    continue;
+
+                ++progress.activeFiles;
+                progress.currentFileDownloaded += worker.downloaded;
+                progress.currentFileTotal += jmax((int64) 0, worker.total);
+
+                if (worker.startedAt >= latestStart)
+                {
+                    latestStart = worker.startedAt;
+                    progress.currentFileName = worker.fileName;
+                }
+            }
+
+            return progress;
+        }
+
+        CriticalSection progressLock;
+        Array<Worker> workers;
+    };
+
+    // Now: every worker stores its byte counts into atomics of its own slot, and only the
+    // file name, set once per file, has a lock
+    struct AtomicProgress
+    {
+        struct Worker
+        {
+            int64 downloaded = 0;
+            int64 total = 0;
+        };
+
+        struct Slot
+        {
+            std::atomic<bool> active { false };
+            std::atomic<int64> downloaded { 0 };
+            std::atomic<int64> total { 0 };
+            std::atomic<uint32> startedAt { 0 };
+            SpinLock fileNameLock;
+            String fileName;
+        };
+
+        explicit AtomicProgress(int numWorkers)
+            : slots((size_t) numWorkers)
+        {
+        }
+
+        Worker begin(int workerIndex, const String& fileName)
+        {
+            auto& slot = slots[(size_t) workerIndex];
+
+            {
+                const SpinLock::ScopedLockType lock(slot.fileNameLock);
+                slot.fileName = fileName;
+            }
+
+            slot.downloaded = 0;
+            slot.total = 0;
+            slot.startedAt = Time::getMillisecondCounter();
+            slot.active = true;
+            return {};
+        }
+
+        void publish(int workerIndex, const Worker& progress)
+        {
+            auto& slot = slots[(size_t) workerIndex];
+            slot.downloaded.store(progress.downloaded, std::memory_order_relaxed);
+            slot.total.store(progress.total, std::memory_order_relaxed);
+        }
+
+        AudioDownloadManager::DownloadProgress sample()
+        {
+            AudioDownloadManager::DownloadProgress progress;
+            uint32 latestStart = 0;
+            const Slot* latestSlot = nullptr;
+
+            for (const auto& slot : slots)
+            {
+                if (! slot.active.load())
+                    continue;
+
+                const int64 total = slot.total.load(std::memory_order_relaxed);
+
+                ++progress.activeFiles;
+                progress.currentFileDownloaded += slot.downloaded.load(std::memory_order_relaxed);
+                progress.currentFileTotal += jmax((int64) 0, total);
+
+                if (slot.startedAt.load() >= latestStart)
+                {
+                    latestStart = slot.startedAt.load();
+                    latestSlot = &slot;
+                }
+            }
+
+            if (latestSlot != nullptr)
+            {
+                const SpinLock::ScopedLockType lock(latestSlot->fileNameLock);
+                progress.currentFileName = latestSlot->fileName;
+            }
+
+            return progress;
+        }
+
+        std::vector<Slot> slots;
+    };
+
+    struct OverheadRun
+    {
+        double nsPerPublish = 0.0;      // wall time of the workers over the publishes of each
+        double usPerSample = 0.0;
+    };
+
+    template <typename Progress>
+    OverheadRun measureProgressOverhead(int numWorkers, int publishesPerWorker)
+    {
+        Progress progress(numWorkers);
+        std::atomic<bool> publishing { true };
+        std::atomic<int64> sampled { 0 };
+        Array<double> sampleMs;
+
+        // Samples every millisecond rather than every 100 like the UI, so that a run of a
+        // fraction of a second still sees the timer contend with the workers
+        std::thread timer([&]
+        {
+            while (publishing.load())
+            {
+                const double startMs = Time::getMillisecondCounterHiRes();
+                sampled += progress.sample().currentFileDownloaded;
+                sampleMs.add(Time::getMillisecondCounterHiRes() - startMs);
+                Thread::sleep(1);
+            }
+        });
+
+        const double startMs = Time::getMillisecondCounterHiRes();
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            workers.emplace_back([&progress, i, publishesPerWorker]
+            {
+                auto worker = progress.begin(i, "FS_ID_" + String(i) + ".ogg");
+                worker.total = (int64) publishesPerWorker * 8192;
+
+                // One publish per 8 KB read
+                for (int n = 0; n < publishesPerWorker; ++n)
+                {
+                    worker.downloaded += 8192;
+                    progress.publish(i, worker);
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        const double elapsedMs = Time::getMillisecondCounterHiRes() - startMs;
+        publishing = false;
+        timer.join();
+
+        OverheadRun result;
+        result.nsPerPublish = elapsedMs * 1.0e6 / publishesPerWorker;
+
+        double totalSampleMs = 0.0;
+        for (const double ms : sampleMs)
+            totalSampleMs += ms;
+
+        result.usPerSample = sampleMs.isEmpty() ? 0.0 : totalSampleMs * 1000.0 / sampleMs.size();
+        return result;
+    }
+}
+
+bool FreesoundBenchmark::runProgressOverheadBenchmark()
+{
+    print("\n== progress-overhead: " + String(options.progressPublishes) + " publishes per worker ==");
+
+    for (const int numWorkers : options.workerCounts)
+    {
+        Array<double> lockedPublish, lockedSample, atomicPublish, atomicSample;
+
+        for (int run = 0; run < options.repeats; ++run)
+        {
+            const OverheadRun locked = measureProgressOverhead<LockedProgress>(numWorkers, options.progressPublishes);
+            const OverheadRun atomic = measureProgressOverhead<AtomicProgress>(numWorkers, options.progressPublishes);
+            lockedPublish.add(locked.nsPerPublish);
+            lockedSample.add(locked.usPerSample);
+            atomicPublish.add(atomic.nsPerPublish);
+            atomicSample.add(atomic.usPerSample);
+        }
+
+        print("  " + String(numWorkers).paddedLeft(' ', 2) + " workers:"
+              + "  lock " + String(getMedian(lockedPublish), 1).paddedLeft(' ', 8) + " ns/publish "
+              + String(getMedian(lockedSample), 2).paddedLeft(' ', 8) + " us/sample"
+              + "  |  atomics " + String(getMedian(atomicPublish), 1).paddedLeft(' ', 8) + " ns/publish "
+              + String(getMedian(atomicSample), 2).paddedLeft(' ', 8) + " us/sample");
+    }
+
+    return true;
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    FreesoundBenchmark.h
+    Benchmarks of the Freesound API client, run against the Freesound
+    mock server
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "FreesoundAPI/FreesoundAPI.h"
+#include "Tools/FreesoundMockServer/Source/FreesoundMockServer.h"
+
+//==============================================================================
+// Everything the benchmark can be told on the command line. Options it does not know
+// about are handed to the mock server (--latency-ms, --bandwidth-kbps, ...).
+struct BenchmarkOptions
+{
+    StringArray benchmarks { "search", "grid", "progress", "progress-overhead" };
+    String baseURL;                     // an already running server, empty = start one in-process
+    String query = "drum loop";
+    int repeats = 5;
+    Array<int> workerCounts { 1, 4, 8 };
+    int gridSize = 16;
+    int progressSounds = 4;
+    double progressPreviewSeconds = 60.0;
+    int progressPublishes = 1000000;    // per worker
+    MockServerOptions serverOptions;
+
+    static BenchmarkOptions fromArguments(const StringArray& args);
+    static String getUsage();
+};
+
+//==============================================================================
+class FreesoundBenchmark
+{
+public:
+    explicit FreesoundBenchmark(const BenchmarkOptions& options);
+
+    // Runs the selected benchmarks one after the other and prints their results.
+    // Returns false if one of them could not be run. Call it away from the message
+    // thread, the download managers report their progress through it.
+    bool run();
+
+private:
+    //==========================================================================
+    // search: time and retained memory of parsing every page of a query, with the
+    // DOM (JSON::parse + FSSound) and with the streaming reader (FSCompactSound)
+    bool runSearchBenchmark();
+
+    // grid: wall time of filling a grid with AudioDownloadManager for each worker count
+    bool runGridBenchmark();
+
+    // progress: throughput of long previews and how regularly their progress reaches the UI
+    bool runProgressBenchmark();
+
+    // progress-overhead: cost of publishing a worker's progress after every read and of the
+    // timer sampling it, with the lock the manager used to share and with its atomics
+    bool runProgressOverheadBenchmark();
+
+    //==========================================================================
+    struct DownloadRun
+    {
+        bool success = false;
+        double seconds = 0.0;
+        int64 bytes = 0;
+        int numProgressUpdates = 0;
+        double maxProgressGapMs = 0.0;
+        double meanProgressGapMs = 0.0;
+    };
+
+    DownloadRun downloadSounds(const Array<FSSound>& sounds, int numWorkers);
+    bool fetchSearchPages(Array<MemoryBlock>& pages);
+    Array<FSSound> searchSounds(int numSounds);
+
+    // Starts the mock server of one benchmark and points the client at it, unless an
+    // external server was given. Every benchmark gets a port of its own, so that none of
+    // them waits for the sockets of the one before to be released.
+    bool startServer(std::unique_ptr<FreesoundMockServer>& server, MockServerOptions serverOptions, int portOffset);
+
+    BenchmarkOptions options;
+    FreesoundClient client { "benchmark" };
+};
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command line entry point of the Freesound benchmarks
+
+  ==============================================================================
+*/
+
+#include "FreesoundBenchmark.h"
+#include <iostream>
+
+//==============================================================================
+// Runs the benchmarks while the main thread dispatches messages, so that the
+// download managers can report their progress as they do in the plugin
+class BenchmarkThread : public Thread
+{
+public:
+    explicit BenchmarkThread(const BenchmarkOptions& options)
+        : Thread("Freesound benchmark"), benchmark(options) {}
+
+    void run() override
+    {
+        succeeded = benchmark.run();
+        MessageManager::getInstance()->stopDispatchLoop();
+    }
+
+    std::atomic<bool> succeeded { false };
+
+private:
+    FreesoundBenchmark benchmark;
+};
+
+int main(int argc, char* argv[])
+{
+    StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(CharPointer_UTF8(argv[i]));
+
+    if (args.contains("--help") || args.contains("-h"))
+    {
+        std::cout << BenchmarkOptions::getUsage();
+        return 0;
+    }
+
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    BenchmarkThread benchmarkThread(BenchmarkOptions::fromArguments(args));
+    benchmarkThread.startThread();
+    MessageManager::getInstance()->runDispatchLoop();
+    benchmarkThread.stopThread(-1);
+
+    return benchmarkThread.succeeded ? 0 : 1;
+}
@@ -0,0 +1,817 @@
+/*
+  ==============================================================================
+
+    FreesoundMockServer.cpp
+    Local stand-in for the Freesound API (search, sound, pack and preview
+    resources) with injectable latency, bandwidth limits and error rates
+
+  ==============================================================================
+*/
+
+#include "FreesoundMockServer.h"
+
+//==============================================================================
+// Options
+//==============================================================================
+
+static String getOptionValue(const StringArray& args, const String& name)
+{
+    for (int i = 0; i < args.size(); ++i)
+    {
+        if (args[i].startsWith(name + "="))
+            return args[i].fromFirstOccurrenceOf("=", false, false);
+
+        if (args[i] == name && i + 1 < args.size() && ! args[i + 1].startsWith("--"))
+            return args[i + 1];
+    }
+
+    return {};
+}
+
+MockServerOptions MockServerOptions::fromArguments(const StringArray& args)
+{
+    MockServerOptions options;
+
+    auto intOption = [&args](const String& name, int defaultValue)
+    {
+        const String value = getOptionValue(args, name);
+        return value.isNotEmpty() ? value.getIntValue() : defaultValue;
+    };
+
+    auto doubleOption = [&args](const String& name, double defaultValue)
+    {
+        const String value = getOptionValue(args, name);
+        return value.isNotEmpty() ? value.getDoubleValue() : defaultValue;
+    };
+
+    options.port = intOption("--port", options.port);
+    options.latencyMs = jmax(0, intOption("--latency-ms", options.latencyMs));
+    options.jitterMs = jmax(0, intOption("--jitter-ms", options.jitterMs));
+    options.bandwidthKbps = jmax(0, intOption("--bandwidth-kbps", options.bandwidthKbps));
+    options.errorRate = jlimit(0.0, 1.0, doubleOption("--error-rate", options.errorRate));
+    options.throttleRate = jlimit(0.0, 1.0, doubleOption("--throttle-rate", options.throttleRate));
+    options.previewSeconds = jlimit(0.0, 600.0, doubleOption("--preview-seconds", options.previewSeconds));
+    options.numThreads = jmax(1, intOption("--threads", options.numThreads));
+    options.durationSeconds = jmax(0.0, doubleOption("--duration", options.durationSeconds));
+    options.verbose = args.contains("--verbose");
+
+    const String seed = getOptionValue(args, "--seed");
+    if (seed.isNotEmpty())
+        options.seed = seed.getLargeIntValue();
+
+    const String bind = getOptionValue(args, "--bind");
+    if (bind.isNotEmpty())
+        options.bindAddress = bind;
+
+    const String recordings = getOptionValue(args, "--recordings");
+    if (recordings.isNotEmpty())
+        options.recordingsDirectory = File::getCurrentWorkingDirectory().getChildFile(recordings);
+
+    return options;
+}
+
+String MockServerOptions::getUsage()
+{
+    return "FreesoundMockServer [options]\n"
+           "\n"
+           "  --port <n>              Port to listen on (default 8085)\n"
+           "  --bind <address>        Address to listen on (default 127.0.0.1)\n"
+           "  --recordings <dir>      Serve recorded responses from <dir> before synthetic ones:\n"
+           "                            apiv2/search/text/<query>.json (or .page<n>.json), apiv2/search/text.json,\n"
+           "                            apiv2/sounds/<id>.json, apiv2/packs/<id>.json, apiv2/packs/<id>/sounds.json,\n"
+           "                            previews/<any path>.ogg\n"
+           "  --latency-ms <n>        Delay added before every response\n"
+           "  --jitter-ms <n>         Uniform extra delay in [0, n]\n"
+           "  --bandwidth-kbps <n>    Per-connection body rate limit (0 = unlimited)\n"
+           "  --error-rate <p>        Fraction of requests answered with 503\n"
+           "  --throttle-rate <p>     Fraction of requests answered with 429 and Retry-After\n"
+           "  --preview-seconds <s>   Length of synthetic previews (default 0.1-0.5 s, derived from the id)\n"
+           "  --seed <n>              Seed for the injected faults and jitter (default 1)\n"
+           "  --threads <n>           Number of connection threads (default 16)\n"
+           "  --duration <s>          Stop after s seconds (default: run until killed)\n"
+           "  --verbose               Log every request\n"
+           "\n"
+           "Point the plugins at the server with FREESOUND_API_BASE_URL=http://127.0.0.1:<port>/apiv2\n"
+           "Counters are served at /__mock/stats\n";
+}
+
+//==============================================================================
+// Request parsing helpers
+//==============================================================================
+
+static StringPairArray parseQueryString(const String& query)
+{
+    StringPairArray parameters;
+
+    for (auto& pair : StringArray::fromTokens(query, "&", ""))
+    {
+        if (pair.isEmpty())
+            continue;
+
+        parameters.set(URL::removeEscapeChars(pair.upToFirstOccurrenceOf("=", false, false)),
+                       URL::removeEscapeChars(pair.fromFirstOccurrenceOf("=", false, false)));
+    }
+
+    return parameters;
+}
+
+// Parses the ids out of a filter such as "id:(123 OR 456 OR 789)"
+static Array<int> parseIdFilter(const String& filter)
+{
+    Array<int> ids;
+    const String list = filter.fromFirstOccurrenceOf("id:(", false, false).upToFirstOccurrenceOf(")", false, false);
+
+    for (auto& token : StringArray::fromTokens(list, " ", ""))
+    {
+        const int id = token.getIntValue();
+        if (id > 0)
+            ids.add(id);
+    }
+
+    return ids;
+}
+
+static var stringOrNull(const String& text)
+{
+    return text.isNotEmpty() ? var(text) : var();
+}
+
+//==============================================================================
+// FreesoundMockServer
+//==============================================================================
+
+FreesoundMockServer::FreesoundMockServer(const MockServerOptions& serverOptions)
+    : Thread("Freesound mock server"),
+      options(serverOptions),
+      connectionPool(serverOptions.numThreads)
+{
+}
+
+FreesoundMockServer::~FreesoundMockServer()
+{
+    stop();
+}
+
+bool FreesoundMockServer::start()
+{
+    if (! listener.createListener(options.port, options.bindAddress))
+        return false;
+
+    startThread();
+    return true;
+}
+
+void FreesoundMockServer::stop()
+{
+    signalThreadShouldExit();
+    listener.close();
+    stopThread(2000);
+    connectionPool.removeAllJobs(true, options.keepAliveTimeoutMs + 2000);
+}
+
+String FreesoundMockServer::getBaseURL() const
+{
+    const String address = (options.bindAddress.isEmpty() || options.bindAddress == "0.0.0.0")
+                               ? String("127.0.0.1") : options.bindAddress;
+
+    return "http://" + address + ":" + String(options.port) + "/apiv2";
+}
+
+var FreesoundMockServer::getStats() const
+{
+    auto* stats = new DynamicObject();
+    stats->setProperty("requests", numRequests.load());
+    stats->setProperty("connections", numConnections.load());
+    stats->setProperty("bytes_sent", numBytesSent.load());
+    stats->setProperty("injected_errors", numInjectedErrors.load());
+    stats->setProperty("throttled", numThrottled.load());
+    stats->setProperty("not_modified", numNotModified.load());
+    return var(stats);
+}
+
+void FreesoundMockServer::run()
+{
+    while (! threadShouldExit())
+    {
+        std::shared_ptr<StreamingSocket> socket(listener.waitForNextConnection());
+
+        if (socket == nullptr)
+        {
+            if (threadShouldExit() || ! listener.isConnected())
+                break;
+
+            continue;
+        }
+
+        ++numConnections;
+        connectionPool.addJob([this, socket] { handleConnection(*socket); });
+    }
+}
+
+void FreesoundMockServer::handleConnection(StreamingSocket& socket)
+{
+    std::string pending;
+
+    while (! threadShouldExit())
+    {
+        Request request;
+        if (! readRequest(socket, pending, request))
+            break;
+
+        const double startMs = Time::getMillisecondCounterHiRes();
+        const Response response = handleRequest(request);
+        const bool keepAlive = ! request.getHeader("connection").equalsIgnoreCase("close");
+        const bool sent = sendResponse(socket, request, response, keepAlive);
+
+        if (options.verbose)
+            Logger::writeToLog(request.method + " " + request.path + " -> " + String(response.status)
+                               + " (" + String((int64) response.body.getSize()) + " bytes, "
+                               + String(Time::getMillisecondCounterHiRes() - startMs, 1) + " ms)");
+
+        if (! sent || ! keepAlive)
+            break;
+    }
+
+    socket.close();
+}
+
+bool FreesoundMockServer::readRequest(StreamingSocket& socket, std::string& pending, Request& request)
+{
+    auto readMore = [this, &socket, &pending]
+    {
+        // Wait in short slices so that stop() does not have to sit out the keep-alive timeout
+        for (int waited = 0; ; waited += 200)
+        {
+            if (threadShouldExit() || waited >= options.keepAliveTimeoutMs)
+                return false;
+
+            const int ready = socket.waitUntilReady(true, 200);
+            if (ready < 0)
+                return false;
+            if (ready > 0)
+                break;
+        }
+
+        char buffer[8192];
+        const int numRead = socket.read(buffer, (int) sizeof(buffer), false);
+        if (numRead <= 0)
+            return false;
+
+        pending.append(buffer, (size_t) numRead);
+        return true;
+    };
+
+    size_t headerEnd;
+    while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos)
+        if (pending.size() > 65536 || ! readMore())
+            return false;
+
+    StringArray lines = StringArray::fromLines(String(pending.substr(0, headerEnd)));
+    const StringArray requestLine = StringArray::fromTokens(lines[0], " ", "");
+
+    if (requestLine.size() < 2)
+        return false;
+
+    request.method = requestLine[0].toUpperCase();
+    request.path = URL::removeEscapeChars(requestLine[1].upToFirstOccurrenceOf("?", false, false));
+    request.parameters = parseQueryString(requestLine[1].fromFirstOccurrenceOf("?", false, false));
+
+    for (int i = 1; i < lines.size(); ++i)
+        if (lines[i].containsChar(':'))
+            request.headers.set(lines[i].upToFirstOccurrenceOf(":", false, false).trim().toLowerCase(),
+                                lines[i].fromFirstOccurrenceOf(":", false, false).trim());
+
+    // Request bodies (uploads, descriptions...) are read and dropped
+    const size_t bodySize = (size_t) jmax((int64) 0, request.getHeader("content-length").getLargeIntValue());
+    const size_t requestSize = headerEnd + 4 + bodySize;
+
+    while (pending.size() < requestSize)
+        if (! readMore())
+            return false;
+
+    pending.erase(0, requestSize);
+    return true;
+}
+
+bool FreesoundMockServer::sendResponse(StreamingSocket& socket, const Request& request,
+                                       const Response& response, bool keepAlive)
+{
+    const bool hasBody = request.method != "HEAD" && response.status != 304;
+
+    String head;
+    head << "HTTP/1.1 " << response.status << " " << getStatusText(response.status) << "\r\n"
+         << "Server: FreesoundMockServer\r\n"
+         << "Content-Type: " << response.contentType << "\r\n"
+         << "Content-Length: " << (int64) (hasBody ? response.body.getSize() : 0) << "\r\n"
+         << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n";
+
+    const StringArray& keys = response.headers.getAllKeys();
+    const StringArray& values = response.headers.getAllValues();
+
+    for (int i = 0; i < keys.size(); ++i)
+        head << keys[i] << ": " << values[i] << "\r\n";
+
+    head << "\r\n";
+
+    const int headSize = (int) head.getNumBytesAsUTF8();
+    if (socket.write(head.toRawUTF8(), headSize) != headSize)
+        return false;
+
+    numBytesSent += headSize;
+
+    if (! hasBody)
+        return true;
+
+    return writeBody(socket, static_cast<const char*>(response.body.getData()), response.body.getSize());
+}
+
+bool FreesoundMockServer::writeBody(StreamingSocket& socket, const char* data, size_t numBytes)
+{
+    const double bytesPerSecond = options.bandwidthKbps * 1000.0 / 8.0;
+
+    // Unlimited bodies go out in one write, limited ones in ~20 ms slices paced against the
+    // start time so that the average rate holds regardless of scheduling hiccups
+    const size_t chunkSize = bytesPerSecond > 0.0 ? (size_t) jmax(512.0, bytesPerSecond / 50.0) : numBytes;
+    const double startMs = Time::getMillisecondCounterHiRes();
+    size_t sent = 0;
+
+    while (sent < numBytes)
+    {
+        if (threadShouldExit())
+            return false;
+
+        const int written = socket.write(data + sent, (int) jmin(chunkSize, numBytes - sent));
+        if (written <= 0)
+            return false;
+
+        sent += (size_t) written;
+        numBytesSent += written;
+
+        if (bytesPerSecond > 0.0)
+        {
+            const double dueMs = startMs + (double) sent * 1000.0 / bytesPerSecond;
+            const double nowMs = Time::getMillisecondCounterHiRes();
+
+            if (dueMs > nowMs)
+                Thread::sleep((int) (dueMs - nowMs));
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+// Routing
+//==============================================================================
+
+FreesoundMockServer::Response FreesoundMockServer::handleRequest(const Request& request)
+{
+    const int64 requestIndex = numRequests++;
+
+    if (request.path == "/__mock/stats")
+        return jsonResponse(getStats());
+
+    // Faults are drawn from the seed and the request index, so a run with the same
+    // seed and request order injects the same faults
+    Random random(options.seed * 1000003 + requestIndex);
+
+    const int delayMs = options.latencyMs + (options.jitterMs > 0 ? random.nextInt(options.jitterMs + 1) : 0);
+    if (delayMs > 0)
+        Thread::sleep(delayMs);
+
+    const double roll = random.nextDouble();
+
+    if (roll < options.throttleRate)
+    {
+        ++numThrottled;
+        Response response = errorResponse(429, "Request was throttled. Expected available in 1 second.");
+        response.headers.set("Retry-After", "1");
+        return response;
+    }
+
+    if (roll < options.throttleRate + options.errorRate)
+    {
+        ++numInjectedErrors;
+        return errorResponse(503, "Service temporarily unavailable.");
+    }
+
+    if (request.method != "GET" && request.method != "HEAD")
+        return errorResponse(405, "Method \"" + request.method + "\" not allowed.");
+
+    Response response;
+
+    if (! findRecording(request, response))
+    {
+        StringArray tokens = StringArray::fromTokens(request.path, "/", "");
+        tokens.removeEmptyStrings();
+
+        const int id = tokens[2].getIntValue();
+
+        if (tokens[0] == "previews" && tokens.size() > 1)
+            response = handlePreview(request, tokens[tokens.size() - 1]);
+        else if (tokens[0] != "apiv2")
+            response = errorResponse(404, "Not found.");
+        else if (tokens.size() == 3 && tokens[1] == "search" && tokens[2] == "text")
+            response = handleSearch(request);
+        else if (tokens.size() == 3 && tokens[1] == "sounds" && id > 0)
+            response = handleSound(request, id);
+        else if (tokens.size() == 4 && tokens[1] == "sounds" && tokens[3] == "similar" && id > 0)
+        {
+            Array<int> similar;
+            for (int i = 1; i <= 15; ++i)
+                similar.add(id + i * 7);
+
+            response = handleSoundList(request, similar);
+        }
+        else if (tokens.size() == 3 && tokens[1] == "packs" && id > 0)
+            response = handlePack(request, id);
+        else if (tokens.size() == 4 && tokens[1] == "packs" && tokens[3] == "sounds" && id > 0 && id < 20000000)
+        {
+            Array<int> packSounds;
+            for (int i = 0; i < 5 + id % 40; ++i)
+                packSounds.add(id * 100 + i);
+
+            response = handleSoundList(request, packSounds);
+        }
+        else
+            response = errorResponse(404, "Not found.");
+    }
+
+    if (response.status == 200 && response.contentType == "application/json")
+        applyETag(request, response);
+
+    return response;
+}
+
+bool FreesoundMockServer::findRecording(const Request& request, Response& response) const
+{
+    if (! options.recordingsDirectory.isDirectory())
+        return false;
+
+    const String relative = request.path.trimCharactersAtStart("/").trimCharactersAtEnd("/");
+    if (relative.isEmpty() || relative.contains(".."))
+        return false;
+
+    if (relative.startsWith("previews/"))
+    {
+        const File file = options.recordingsDirectory.getChildFile(relative);
+        if (! file.existsAsFile() || ! file.loadFileAsData(response.body))
+            return false;
+
+        response.contentType = "audio/ogg";
+        applyRange(request, response);
+        return true;
+    }
+
+    File file;
+    const String query = request.parameters["query"];
+
+    if (query.isNotEmpty())
+    {
+        const String page = request.parameters["page"];
+        const String name = File::createLegalFileName(query);
+
+        if (page.isNotEmpty() && page != "1")
+            file = options.recordingsDirectory.getChildFile(relative + "/" + name + ".page" + page + ".json");
+        else
+            file = options.recordingsDirectory.getChildFile(relative + "/" + name + ".json");
+    }
+
+    if (! file.existsAsFile())
+        file = options.recordingsDirectory.getChildFile(relative + ".json");
+
+    if (! file.existsAsFile())
+        return false;
+
+    // Recorded responses point at freesound.org; send the follow-up requests
+    // (next pages, previews, pack sounds...) back to this server instead
+    const String host = getHostURL(request);
+    const String text = file.loadFileAsString()
+                            .replace("https://cdn.freesound.org", host)
+                            .replace("https://freesound.org", host);
+
+    response.body = MemoryBlock(text.toRawUTF8(), text.getNumBytesAsUTF8());
+    return true;
+}
+
+//==============================================================================
+// Synthetic responses
+//==============================================================================
+
+FreesoundMockServer::Response FreesoundMockServer::handleSearch(const Request& request)
+{
+    const String filter = request.parameters["filter"];
+
+    if (filter.contains("id:("))
+        return handleSoundList(request, parseIdFilter(filter));
+
+    // The number and ids of the results are derived from the query, so the same
+    // query always gets the same pages
+    const uint64 hash = (uint64) request.parameters["query"].toLowerCase().trim().hashCode64();
+    const int count = 50 + (int) (hash % 951);
+    const int firstId = 100000 + (int) (hash % 8000) * 1000;
+
+    Array<int> ids;
+    ids.ensureStorageAllocated(count);
+
+    for (int i = 0; i < count; ++i)
+        ids.add(firstId + i);
+
+    return handleSoundList(request, ids);
+}
+
+FreesoundMockServer::Response FreesoundMockServer::handleSound(const Request& request, int id)
+{
+    return jsonResponse(filterFields(createSound(request, id), request.parameters["fields"]));
+}
+
+FreesoundMockServer::Response FreesoundMockServer::handleSoundList(const Request& request, const Array<int>& ids)
+{
+    const int pageSize = jlimit(1, 150, request.parameters.getValue("page_size", "15").getIntValue());
+    const int page = request.parameters.getValue("page", "1").getIntValue();
+    const int numPages = jmax(1, (ids.size() + pageSize - 1) / pageSize);
+
+    if (page < 1 || page > numPages)
+        return errorResponse(404, "Invalid page.");
+
+    auto getPageURL = [this, &request](int pageNumber)
+    {
+        StringPairArray parameters = request.parameters;
+        parameters.set("page", String(pageNumber));
+
+        StringArray pairs;
+        for (int i = 0; i < parameters.size(); ++i)
+            pairs.add(URL::addEscapeChars(parameters.getAllKeys()[i], true) + "="
+                      + URL::addEscapeChars(parameters.getAllValues()[i], true));
+
+        return getHostURL(request) + request.path + "?" + pairs.joinIntoString("&");
+    };
+
+    const String fields = request.parameters["fields"];
+    Array<var> results;
+
+    for (int i = (page - 1) * pageSize; i < jmin(ids.size(), page * pageSize); ++i)
+        results.add(filterFields(createSound(request, ids[i]), fields));
+
+    auto* list = new DynamicObject();
+    list->setProperty("count", ids.size());
+    list->setProperty("next", stringOrNull(page < numPages ? getPageURL(page + 1) : String()));
+    list->setProperty("previous", stringOrNull(page > 1 ? getPageURL(page - 1) : String()));
+    list->setProperty("results", results);
+
+    return jsonResponse(var(list));
+}
+
+FreesoundMockServer::Response FreesoundMockServer::handlePack(const Request& request, int id)
+{
+    const String host = getHostURL(request);
+
+    auto* pack = new DynamicObject();
+    pack->setProperty("id", id);
+    pack->setProperty("url", host + "/people/mock_user_" + String(id % 97) + "/packs/" + String(id) + "/");
+    pack->setProperty("description", "Synthetic pack served by the Freesound mock server");
+    pack->setProperty("created", "2020-01-01T00:00:00");
+    pack->setProperty("name", "mock_pack_" + String(id));
+    pack->setProperty("username", "mock_user_" + String(id % 97));
+    pack->setProperty("num_sounds", 5 + id % 40);
+    pack->setProperty("sounds", host + "/apiv2/packs/" + String(id) + "/sounds/");
+    pack->setProperty("num_downloads", (id * 13) % 5000);
+
+    return jsonResponse(var(pack));
+}
+
+FreesoundMockServer::Response FreesoundMockServer::handlePreview(const Request& request, const String& fileName)
+{
+    // Preview names look like "<sound id>_<user id>-hq.ogg"
+    const int id = fileName.initialSectionContainingOnly("0123456789").getIntValue();
+
+    if (id <= 0 || ! fileName.endsWithIgnoreCase(".ogg"))
+        return errorResponse(404, "Not found.");
+
+    Response response;
+    response.contentType = "audio/ogg";
+    response.body = getPreviewData(id);
+
+    if (response.body.isEmpty())
+        return errorResponse(500, "Could not encode the preview.");
+
+    applyRange(request, response);
+    return response;
+}
+
+String FreesoundMockServer::getHostURL(const Request& request) const
+{
+    const String host = request.getHeader("host");
+    return "http://" + (host.isNotEmpty() ? host : options.bindAddress + ":" + String(options.port));
+}
+
+var FreesoundMockServer::createSound(const Request& request, int id) const
+{
+    static const StringArray licenses { "http://creativecommons.org/publicdomain/zero/1.0/",
+                                        "https://creativecommons.org/licenses/by/4.0/",
+                                        "http://creativecommons.org/licenses/by-nc/3.0/" };
+
+    const String host = getHostURL(request);
+    const String soundId(id);
+    const String username = "mock_user_" + String(id % 97);
+    const String previewBase = host + "/previews/" + String(id / 1000) + "/" + soundId + "_" + String(id % 97);
+    const String resourceBase = host + "/apiv2/sounds/" + soundId + "/";
+    const double duration = options.previewSeconds > 0.0 ? options.previewSeconds : 0.1 + (id % 5) * 0.1;
+
+    auto* previews = new DynamicObject();
+    previews->setProperty("preview-hq-ogg", previewBase + "-hq.ogg");
+    previews->setProperty("preview-lq-ogg", previewBase + "-lq.ogg");
+    previews->setProperty("preview-hq-mp3", previewBase + "-hq.mp3");
+    previews->setProperty("preview-lq-mp3", previewBase + "-lq.mp3");
+
+    Array<var> tags;
+    tags.add("mock");
+    tags.add("synthetic");
+    tags.add("tone-" + String(id % 12));
+
+    auto* sound = new DynamicObject();
+    sound->setProperty("id", id);
+    sound->setProperty("url", host + "/people/" + username + "/sounds/" + soundId + "/");
+    sound->setProperty("name", "mock_sound_" + soundId + ".wav");
+    sound->setProperty("tags", tags);
+    sound->setProperty("description", "Synthetic tone " + soundId + " served by the Freesound mock server");
+    sound->setProperty("created", "2020-01-01T00:00:00");
+    sound->setProperty("license", licenses[id % licenses.size()]);
+    sound->setProperty("type", "wav");
+    sound->setProperty("channels", 1);
+    sound->setProperty("filesize", (int) (duration * 44100.0 * 2.0) + 44);
+    sound->setProperty("bitrate", 0);
+    sound->setProperty("bitdepth", 16);
+    sound->setProperty("duration", duration);
+    sound->setProperty("samplerate", 44100);
+    sound->setProperty("username", username);
+    sound->setProperty("pack", host + "/apiv2/packs/" + String(jmax(1, id / 100)) + "/");
+    sound->setProperty("download", resourceBase + "download/");
+    sound->setProperty("bookmark", resourceBase + "bookmark/");
+    sound->setProperty("previews", var(previews));
+    sound->setProperty("images", var(new DynamicObject()));
+    sound->setProperty("num_downloads", (id * 7) % 10000);
+    sound->setProperty("avg_rating", (id % 50) / 10.0);
+    sound->setProperty("num_ratings", id % 20);
+    sound->setProperty("rate", resourceBase + "rate/");
+    sound->setProperty("comments", resourceBase + "comments/");
+    sound->setProperty("num_comments", id % 5);
+    sound->setProperty("comment", resourceBase + "comment/");
+    sound->setProperty("similar_sounds", resourceBase + "similar/");
+    sound->setProperty("analysis", resourceBase + "analysis/");
+
+    return var(sound);
+}
+
+var FreesoundMockServer::filterFields(const var& sound, const String& fields) const
+{
+    if (fields.isEmpty() || sound.getDynamicObject() == nullptr)
+        return sound;
+
+    auto* filtered = new DynamicObject();
+
+    for (auto& field : StringArray::fromTokens(fields, ",", ""))
+        if (sound.hasProperty(field.trim()))
+            filtered->setProperty(field.trim(), sound[Identifier(field.trim())]);
+
+    return var(filtered);
+}
+
+MemoryBlock FreesoundMockServer::getPreviewData(int id)
+{
+    {
+        const ScopedLock sl(previewLock);
+        if (previewCache.contains(id))
+            return previewCache[id];
+    }
+
+    // A decaying tone whose pitch and length are derived from the id
+    const double sampleRate = 44100.0;
+    const double seconds = options.previewSeconds > 0.0 ? options.previewSeconds : 0.1 + (id % 5) * 0.1;
+    const double frequency = 110.0 * std::pow(2.0, (id % 36) / 12.0);
+    const int numSamples = (int) (sampleRate * seconds);
+
+    AudioBuffer<float> buffer(1, numSamples);
+    float* samples = buffer.getWritePointer(0);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const double t = i / sampleRate;
+        samples[i] = (float) (0.5 * std::sin(MathConstants<double>::twoPi * frequency * t) * std::exp(-3.0 * t / seconds));
+    }
+
+    MemoryBlock data;
+    OggVorbisAudioFormat format;
+    auto* stream = new MemoryOutputStream(data, false);
+    std::unique_ptr<AudioFormatWriter> writer(format.createWriterFor(stream, sampleRate, 1, 16, {},
+                                                                     format.getQualityOptions().size() / 2));
+
+    if (writer == nullptr)
+    {
+        delete stream;
+        return {};
+    }
+
+    writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+    writer.reset(); // flushes and deletes the stream
+
+    const ScopedLock sl(previewLock);
+
+    if (previewCache.size() > 1024)
+        previewCache.clear();
+
+    previewCache.set(id, data);
+    return data;
+}
+
+//==============================================================================
+// Response helpers
+//==============================================================================
+
+FreesoundMockServer::Response FreesoundMockServer::jsonResponse(const var& json, int status)
+{
+    const String text = JSON::toString(json, true);
+
+    Response response;
+    response.status = status;
+    response.body = MemoryBlock(text.toRawUTF8(), text.getNumBytesAsUTF8());
+    return response;
+}
+
+FreesoundMockServer::Response FreesoundMockServer::errorResponse(int status, const String& detail)
+{
+    auto* error = new DynamicObject();
+    error->setProperty("detail", detail);
+    return jsonResponse(var(error), status);
+}
+
+void FreesoundMockServer::applyRange(const Request& request, Response& response)
+{
+    response.headers.set("Accept-Ranges", "bytes");
+
+    const String range = request.getHeader("range").trim();
+    if (response.status != 200 || ! range.startsWithIgnoreCase("bytes="))
+        return;
+
+    // Only the first range of a multi-range request is honoured
+    const String spec = range.fromFirstOccurrenceOf("=", false, false).upToFirstOccurrenceOf(",", false, false).trim();
+    const int64 total = (int64) response.body.getSize();
+    int64 first, last;
+
+    if (spec.startsWith("-"))
+    {
+        first = jmax((int64) 0, total - spec.substring(1).getLargeIntValue());
+        last = total - 1;
+    }
+    else
+    {
+        const String end = spec.fromFirstOccurrenceOf("-", false, false).trim();
+        first = spec.upToFirstOccurrenceOf("-", false, false).trim().getLargeIntValue();
+        last = end.isNotEmpty() ? jmin(total - 1, end.getLargeIntValue()) : total - 1;
+    }
+
+    if (first >= total || last < first)
+    {
+        response.status = 416;
+        response.headers.set("Content-Range", "bytes */" + String(total));
+        response.body.reset();
+        return;
+    }
+
+    MemoryBlock part(static_cast<const char*>(response.body.getData()) + first, (size_t) (last - first + 1));
+    response.body = std::move(part);
+    response.status = 206;
+    response.headers.set("Content-Range", "bytes " + String(first) + "-" + String(last) + "/" + String(total));
+}
+
+void FreesoundMockServer::applyETag(const Request& request, Response& response)
+{
+    const String body = String::fromUTF8(static_cast<const char*>(response.body.getData()), (int) response.body.getSize());
+    const String eTag = "\"" + String::toHexString(body.hashCode64()) + "\"";
+
+    response.headers.set("ETag", eTag);
+
+    if (request.getHeader("if-none-match") == eTag)
+    {
+        ++numNotModified;
+        response.status = 304;
+        response.body.reset();
+    }
+}
+
+String FreesoundMockServer::getStatusText(int status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 304: return "Not Modified";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 416: return "Range Not Satisfiable";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default:  return "Unknown";
+    }
+}
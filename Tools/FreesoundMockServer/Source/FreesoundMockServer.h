@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    FreesoundMockServer.h
+    Local stand-in for the Freesound API (search, sound, pack and preview
+    resources) with injectable latency, bandwidth limits and error rates
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+using namespace juce;
+
+//==============================================================================
+// Everything the server can be told on the command line
+struct MockServerOptions
+{
+    int port = 8085;
+    String bindAddress = "127.0.0.1";
+    File recordingsDirectory;       // recorded responses, served in preference to synthetic ones
+    int latencyMs = 0;              // added before every response
+    int jitterMs = 0;               // uniform extra latency in [0, jitterMs]
+    int bandwidthKbps = 0;          // per-connection body rate, 0 = unlimited
+    double errorRate = 0.0;         // fraction of requests answered with 503
+    double throttleRate = 0.0;      // fraction of requests answered with 429
+    double previewSeconds = 0.0;    // forces the length of synthetic previews, 0 = derived from the id
+    int64 seed = 1;
+    int numThreads = 16;
+    int keepAliveTimeoutMs = 5000;
+    double durationSeconds = 0.0;   // stop after this long, 0 = run until killed
+    bool verbose = false;
+
+    static MockServerOptions fromArguments(const StringArray& args);
+    static String getUsage();
+};
+
+//==============================================================================
+class FreesoundMockServer : private Thread
+{
+public:
+    explicit FreesoundMockServer(const MockServerOptions& options);
+    ~FreesoundMockServer() override;
+
+    bool start();
+    void stop();
+    bool isRunning() const { return isThreadRunning(); }
+
+    String getBaseURL() const;
+    var getStats() const;
+
+private:
+    struct Request
+    {
+        String method;
+        String path;
+        StringPairArray parameters;
+        StringPairArray headers;    // keys are lower case
+
+        String getHeader(const String& name) const { return headers[name.toLowerCase()]; }
+    };
+
+    struct Response
+    {
+        int status = 200;
+        String contentType = "application/json";
+        MemoryBlock body;
+        StringPairArray headers;
+    };
+
+    void run() override;
+    void handleConnection(StreamingSocket& socket);
+    bool readRequest(StreamingSocket& socket, std::string& pending, Request& request);
+    bool sendResponse(StreamingSocket& socket, const Request& request, const Response& response, bool keepAlive);
+    bool writeBody(StreamingSocket& socket, const char* data, size_t numBytes);
+
+    Response handleRequest(const Request& request);
+    Response handleSearch(const Request& request);
+    Response handleSound(const Request& request, int id);
+    Response handleSoundList(const Request& request, const Array<int>& ids);
+    Response handlePack(const Request& request, int id);
+    Response handlePreview(const Request& request, const String& fileName);
+
+    bool findRecording(const Request& request, Response& response) const;
+    String getHostURL(const Request& request) const;
+    var createSound(const Request& request, int id) const;
+    var filterFields(const var& sound, const String& fields) const;
+    MemoryBlock getPreviewData(int id);
+
+    static Response jsonResponse(const var& json, int status = 200);
+    static Response errorResponse(int status, const String& detail);
+    static void applyRange(const Request& request, Response& response);
+    void applyETag(const Request& request, Response& response);
+    static String getStatusText(int status);
+
+    MockServerOptions options;
+    StreamingSocket listener;
+    ThreadPool connectionPool;
+
+    CriticalSection previewLock;
+    HashMap<int, MemoryBlock> previewCache;
+
+    std::atomic<int64> numRequests { 0 };
+    std::atomic<int64> numConnections { 0 };
+    std::atomic<int64> numBytesSent { 0 };
+    std::atomic<int64> numInjectedErrors { 0 };
+    std::atomic<int64> numThrottled { 0 };
+    std::atomic<int64> numNotModified { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FreesoundMockServer)
+};
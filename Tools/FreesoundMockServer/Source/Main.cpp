@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Command line entry point of the Freesound mock server
+
+  ==============================================================================
+*/
+
+#include "FreesoundMockServer.h"
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+    StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add(CharPointer_UTF8(argv[i]));
+
+    if (args.contains("--help") || args.contains("-h"))
+    {
+        std::cout << MockServerOptions::getUsage();
+        return 0;
+    }
+
+    const MockServerOptions options = MockServerOptions::fromArguments(args);
+    FreesoundMockServer server(options);
+
+    if (! server.start())
+    {
+        std::cerr << "Could not listen on " << options.bindAddress << ":" << options.port << std::endl;
+        return 1;
+    }
+
+    std::cout << "Freesound mock server listening on " << server.getBaseURL() << std::endl
+              << "Run the plugin with FREESOUND_API_BASE_URL=" << server.getBaseURL() << std::endl;
+
+    const double endMs = Time::getMillisecondCounterHiRes() + options.durationSeconds * 1000.0;
+
+    while (server.isRunning() && (options.durationSeconds <= 0.0 || Time::getMillisecondCounterHiRes() < endMs))
+        Thread::sleep(100);
+
+    server.stop();
+    std::cout << JSON::toString(server.getStats()) << std::endl;
+    return 0;
+}